@@ -0,0 +1,342 @@
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Instance.h"
+#include "Device.h"
+#include "Swapchain.h"
+#include "Renderer.h"
+#include "Mesh.h"
+#include "Logger.h"
+
+// Renders a generated scene headless for a fixed number of frames and reports frame time
+// percentiles, draw calls and upload bandwidth as JSON.
+//
+//   VulkanoVistaBench [--models N] [--meshes N] [--textures N] [--warmup N] [--frames N]
+//                     [--width W] [--height H] [--frames-in-flight N] [--static] [--instanced] [--cpu-culling]
+//                     [--output file.json]
+
+struct BenchConfig
+{
+    uint32_t modelCount = 64;
+    uint32_t meshesPerModel = 4;
+    uint32_t textureCount = 8;
+    uint32_t warmupFrames = 60;
+    uint32_t measuredFrames = 600;
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t framesInFlight = 2;
+    bool staticModels = false;      // record the scene once into the cached bundles, needs --cpu-culling
+    bool instanced = false;         // one model with an instance per grid cell instead of a model per cell
+    bool gpuCulling = true;         // cull on the GPU and draw indirect where the device can
+    std::string output;
+};
+
+struct Summary
+{
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    size_t samples = 0;
+};
+
+const uint32_t BENCH_TEXTURE_SIZE = 256;
+const float BENCH_FRAME_TIME = 1.0f / 60.0f;    // fixed update step, keeps runs comparable
+
+static bool parseArguments(int argc, char* argv[], BenchConfig& config)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--static")
+        {
+            config.staticModels = true;
+        }
+        else if (arg == "--instanced")
+        {
+            config.instanced = true;
+        }
+        else if (arg == "--cpu-culling")
+        {
+            config.gpuCulling = false;
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            config.output = argv[++i];
+        }
+        else if (hasValue && (arg == "--models" || arg == "--meshes" || arg == "--textures" || arg == "--warmup" ||
+                              arg == "--frames" || arg == "--width" || arg == "--height" || arg == "--frames-in-flight"))
+        {
+            uint32_t value = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            if (arg == "--models") config.modelCount = value;
+            else if (arg == "--meshes") config.meshesPerModel = value;
+            else if (arg == "--textures") config.textureCount = value;
+            else if (arg == "--warmup") config.warmupFrames = value;
+            else if (arg == "--frames") config.measuredFrames = value;
+            else if (arg == "--width") config.width = value;
+            else if (arg == "--height") config.height = value;
+            else config.framesInFlight = value;
+        }
+        else
+        {
+            Logger::error("Unknown argument: " + arg);
+            return false;
+        }
+    }
+
+    // Every mesh samples a texture, at least one has to exist
+    config.textureCount = std::max(config.textureCount, 1u);
+    config.measuredFrames = std::max(config.measuredFrames, 1u);
+    config.width = std::max(config.width, 1u);
+    config.height = std::max(config.height, 1u);
+    return true;
+}
+
+// Nearest rank percentiles
+static Summary summarize(std::vector<double> values)
+{
+    Summary summary;
+    summary.samples = values.size();
+    if (values.empty())
+    {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+    auto percentile = [&](double p)
+    {
+        size_t rank = static_cast<size_t>(p / 100.0 * values.size() + 0.5);
+        return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+    };
+
+    summary.mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    summary.p50 = percentile(50.0);
+    summary.p95 = percentile(95.0);
+    summary.p99 = percentile(99.0);
+    summary.min = values.front();
+    summary.max = values.back();
+    return summary;
+}
+
+static void writeSummary(std::ostream& out, const Summary& summary)
+{
+    out << "{ \"mean\": " << summary.mean << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99 << ", \"min\": " << summary.min << ", \"max\": " << summary.max
+        << ", \"samples\": " << summary.samples << " }";
+}
+
+// A checkerboard per texture, tinted so the textures differ
+static std::vector<uint8_t> generateTexture(uint32_t index)
+{
+    std::vector<uint8_t> pixels(BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE * 4);
+    uint8_t tint[3] = { static_cast<uint8_t>(64 + index * 37), static_cast<uint8_t>(64 + index * 91), static_cast<uint8_t>(64 + index * 53) };
+    for (uint32_t y = 0; y < BENCH_TEXTURE_SIZE; ++y)
+    {
+        for (uint32_t x = 0; x < BENCH_TEXTURE_SIZE; ++x)
+        {
+            bool light = ((x / 16) + (y / 16)) % 2 == 0;
+            uint8_t* pixel = &pixels[(y * BENCH_TEXTURE_SIZE + x) * 4];
+            for (int c = 0; c < 3; ++c)
+            {
+                pixel[c] = light ? tint[c] : tint[c] / 4;
+            }
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+// Models on a grid in front of the default camera, the meshes of a model stacked on top of each other.
+// Instanced, every grid cell is an instance of the first model instead
+static void createScene(Device& device, Renderer& renderer, const BenchConfig& config)
+{
+    std::vector<int> textureIds;
+    for (uint32_t i = 0; i < config.textureCount; ++i)
+    {
+        std::vector<uint8_t> pixels = generateTexture(i);
+        Texture* texture = renderer.createTexture("bench_texture_" + std::to_string(i), BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE, pixels.data());
+        textureIds.push_back(texture->textId);
+    }
+
+    uint32_t columns = std::max(1u, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(config.modelCount)))));
+    float spacing = 6.0f / columns;
+    float halfSize = spacing * 0.3f;
+
+    uint32_t textureIndex = 0;
+    int instancedModel = -1;
+    for (uint32_t i = 0; i < config.modelCount; ++i)
+    {
+        float x = (i % columns) * spacing - 3.0f + spacing * 0.5f;
+        float z = -static_cast<float>(i / columns) * spacing;
+        glm::mat4 cell = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, z));
+        if (instancedModel >= 0)
+        {
+            renderer.getMeshModel(instancedModel).addInstance(cell);
+            continue;
+        }
+
+        std::vector<Mesh> meshes;
+        for (uint32_t j = 0; j < config.meshesPerModel; ++j)
+        {
+            DecodedMesh box = MeshModel::createBoxMesh(glm::vec3(0.0f, j * halfSize * 0.5f, 0.0f), halfSize / (1.0f + j * 0.25f));
+            meshes.emplace_back(&device, box.vertices, box.indices, textureIds[textureIndex++ % textureIds.size()]);
+        }
+
+        int modelIndex = renderer.createMeshModel(meshes);
+
+        MeshModel& model = renderer.getMeshModel(modelIndex);
+        if (config.instanced)
+        {
+            instancedModel = modelIndex;
+            model.addInstance(cell);
+            continue;
+        }
+        model.setModel(cell);
+        model.setStatic(config.staticModels);
+    }
+}
+
+static void writeReport(std::ostream& out, const BenchConfig& config, const std::string& deviceName,
+                        const Summary& cpu, const Summary& gpu, bool gpuSupported, bool gpuCulling, uint32_t drawCalls,
+                        uint64_t uploadBytes, double uploadSeconds, double measuredSeconds)
+{
+    out << "{\n";
+    out << "  \"device\": \"" << deviceName << "\",\n";
+    out << "  \"scene\": { \"models\": " << config.modelCount << ", \"meshesPerModel\": " << config.meshesPerModel
+        << ", \"textures\": " << config.textureCount << ", \"static\": " << (config.staticModels ? "true" : "false")
+        << ", \"instanced\": " << (config.instanced ? "true" : "false") << " },\n";
+    out << "  \"resolution\": { \"width\": " << config.width << ", \"height\": " << config.height << " },\n";
+    out << "  \"framesInFlight\": " << config.framesInFlight << ",\n";
+    out << "  \"gpuCulling\": " << (gpuCulling ? "true" : "false") << ",\n";
+    out << "  \"frames\": { \"warmup\": " << config.warmupFrames << ", \"measured\": " << config.measuredFrames << " },\n";
+    out << "  \"fps\": " << config.measuredFrames / measuredSeconds << ",\n";
+    out << "  \"cpuFrameMs\": ";
+    writeSummary(out, cpu);
+    out << ",\n  \"gpuFrameMs\": ";
+    if (gpuSupported)
+    {
+        writeSummary(out, gpu);
+    }
+    else
+    {
+        out << "null";
+    }
+    out << ",\n  \"drawCalls\": " << drawCalls << ",\n";
+    out << "  \"upload\": { \"bytes\": " << uploadBytes << ", \"seconds\": " << uploadSeconds
+        << ", \"mbPerSecond\": " << (uploadSeconds > 0.0 ? uploadBytes / (1024.0 * 1024.0) / uploadSeconds : 0.0) << " }\n";
+    out << "}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchConfig config;
+    if (!parseArguments(argc, argv, config))
+    {
+        return EXIT_FAILURE;
+    }
+
+    Instance instance;
+    Device device;
+    Swapchain swapchain;
+    Renderer renderer;
+
+    try {
+        // Headless, runs wherever there is a Vulkan implementation, software rasterizers included
+        instance.create(nullptr);
+        device.pickPhysicalDevice(instance, VK_NULL_HANDLE);
+        device.createLogicalDevice(VK_NULL_HANDLE);
+        swapchain.createOffscreen(&device, { config.width, config.height });
+        renderer.setup(&device, &swapchain, nullptr, &instance, config.framesInFlight);
+        renderer.setGpuCullingEnabled(config.gpuCulling);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.getPhysicalDevice(), &properties);
+        std::string deviceName = properties.deviceName;
+
+        // Scene creation until the GPU has the data, for the upload bandwidth
+        UploadEngine& uploadEngine = device.getUploadEngine();
+        uint64_t uploadStart = uploadEngine.getUploadedBytes();
+        auto loadStart = std::chrono::steady_clock::now();
+        createScene(device, renderer, config);
+        uploadEngine.wait(uploadEngine.flush());
+        double uploadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+        uint64_t uploadBytes = uploadEngine.getUploadedBytes() - uploadStart;
+
+        for (uint32_t i = 0; i < config.warmupFrames; ++i)
+        {
+            renderer.update(BENCH_FRAME_TIME);
+            renderer.drawFrame();
+        }
+
+        // GPU times arrive a few frames late, one for every frame the profiler collects
+        GpuProfiler& gpuProfiler = renderer.getGpuProfiler();
+        uint64_t collectedFrames = gpuProfiler.getCollectedFrames();
+
+        std::vector<double> cpuTimes;
+        std::vector<double> gpuTimes;
+        cpuTimes.reserve(config.measuredFrames);
+        gpuTimes.reserve(config.measuredFrames);
+
+        auto measureStart = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < config.measuredFrames; ++i)
+        {
+            auto frameStart = std::chrono::steady_clock::now();
+            renderer.update(BENCH_FRAME_TIME);
+            renderer.drawFrame();
+            cpuTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+
+            if (gpuProfiler.getCollectedFrames() != collectedFrames)
+            {
+                collectedFrames = gpuProfiler.getCollectedFrames();
+                double gpuTime = gpuProfiler.getMilliseconds("Frame");
+                if (gpuTime >= 0.0)
+                {
+                    gpuTimes.push_back(gpuTime);
+                }
+            }
+        }
+        device.waitIdle();
+        double measuredSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+
+        std::ostringstream report;
+        writeReport(report, config, deviceName, summarize(cpuTimes), summarize(gpuTimes), gpuProfiler.isSupported(),
+                    config.gpuCulling && renderer.isGpuCullingSupported(), renderer.getDrawCallCount(), uploadBytes, uploadSeconds, measuredSeconds);
+
+        std::cout << report.str();
+        if (!config.output.empty())
+        {
+            std::ofstream file(config.output);
+            file << report.str();
+            if (!file.good())
+            {
+                Logger::error("Failed to write benchmark results to " + config.output);
+            }
+        }
+    }
+    catch (std::runtime_error& e) {
+        Logger::error("Benchmark failed: " + std::string(e.what()));
+        return EXIT_FAILURE;
+    }
+
+    swapchain.cleanup();
+    renderer.cleanup();
+    device.cleanup();
+    instance.cleanup();
+
+    return 0;
+}
@@ -1,5 +1,8 @@
-glslangValidator -V shader.frag -o fragment_shader.spv
-glslangValidator -V shader.vert -o vertex_shader.spv
-glslangValidator -V second_pass.vert -o second_pass_vert.spv
-glslangValidator -V second_pass.frag -o second_pass_frag.spv
+glslangValidator -V shader.frag -o fragment_shader.spv
+glslangValidator -V shader.vert -o vertex_shader.spv
+glslangValidator -V shader_indirect.vert -o vertex_shader_indirect.spv
+glslangValidator -V shader_instanced.vert -o vertex_shader_instanced.spv
+glslangValidator -V cull.comp -o cull_comp.spv
+glslangValidator -V second_pass.vert -o second_pass_vert.spv
+glslangValidator -V second_pass.frag -o second_pass_frag.spv
 pause
\ No newline at end of file
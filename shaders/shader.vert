@@ -1,28 +1,28 @@
-#version 450
-
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 tex;
-
-layout(set = 0, binding = 0) uniform UboViewProjection {
-    mat4 projection;
-    mat4 view;
-} uboViewProjection;
-
-// not in use left for reference
-layout(set = 0, binding = 1) uniform UboModel {
-    mat4 model;
-} uboModel;
-
-layout(push_constant) uniform PushModel {
-    mat4 model;
-} pushModel;
-
-layout(location = 0) out vec3 fragColor;
-layout(location = 1) out vec2 fragTex;
-
-void main() {
-    gl_Position = uboViewProjection.projection * uboViewProjection.view * pushModel.model * vec4(inPos, 1.0);
-    fragColor = inColor;
-    fragTex = tex;
-}
+#version 450
+
+// Packed vertex formats may store position in [0, 1], the push constant model includes the dequantization
+layout(location = 0) in vec3 inPos;
+layout(location = 2) in vec2 tex;
+
+layout(set = 0, binding = 0) uniform UboViewProjection {
+    mat4 projection;
+    mat4 view;
+} uboViewProjection;
+
+// not in use left for reference
+layout(set = 0, binding = 1) uniform UboModel {
+    mat4 model;
+} uboModel;
+
+layout(push_constant) uniform PushModel {
+    mat4 model;
+} pushModel;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTex;
+
+void main() {
+    gl_Position = uboViewProjection.projection * uboViewProjection.view * pushModel.model * vec4(inPos, 1.0);
+    fragColor = vec3(1.0);      // vertex colors were always white, packed formats have no color stream
+    fragTex = tex;
+}
@@ -0,0 +1,42 @@
+#version 450
+
+// shader.vert for GPU culled indirect draws, the model comes from the object the draw belongs to
+layout(location = 0) in vec3 inPos;
+layout(location = 2) in vec2 tex;
+
+layout(set = 0, binding = 0) uniform UboViewProjection {
+    mat4 projection;
+    mat4 view;
+} uboViewProjection;
+
+struct Object {
+    mat4 transform;
+    vec4 dequantScale;
+    vec4 dequantOffset;
+    vec4 boundsCenter;
+    vec4 boundsExtent;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint bucket;
+    uint bucketFirst;
+    uint command;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTex;
+
+void main() {
+    // firstInstance of every command is its object index
+    Object object = objects[gl_InstanceIndex];
+    vec3 position = inPos * object.dequantScale.xyz + object.dequantOffset.xyz;
+    gl_Position = uboViewProjection.projection * uboViewProjection.view * object.transform * vec4(position, 1.0);
+    fragColor = vec3(1.0);
+    fragTex = tex;
+}
@@ -0,0 +1,33 @@
+#version 450
+
+// shader.vert for instanced draws, every instance is placed by its own transform in front of the model
+layout(location = 0) in vec3 inPos;
+layout(location = 2) in vec2 tex;
+
+layout(set = 0, binding = 0) uniform UboViewProjection {
+    mat4 projection;
+    mat4 view;
+} uboViewProjection;
+
+layout(push_constant) uniform PushModel {
+    mat4 model;
+} pushModel;
+
+struct Instance {
+    mat4 transform;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTex;
+
+void main() {
+    // firstInstance of the draw is where its instances start in the frame's buffer
+    mat4 instance = instances[gl_InstanceIndex].transform;
+    gl_Position = uboViewProjection.projection * uboViewProjection.view * instance * pushModel.model * vec4(inPos, 1.0);
+    fragColor = vec3(1.0);
+    fragTex = tex;
+}
@@ -0,0 +1,266 @@
+#include "AssetLoader.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "stb_image.h"
+#include "CpuProfiler.h"
+#include "MeshOptimizer.h"
+
+void AssetLoader::create(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(ASSET_LOADER_THREADS, std::thread::hardware_concurrency());
+    }
+
+    stopping = false;
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+}
+
+void AssetLoader::cleanup()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+    }
+    wake.notify_all();
+
+    // A running import is finished, whatever it produced is thrown away
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+    loaded.clear();
+    cancelled.clear();
+    pending = 0;
+}
+
+void AssetLoader::loadModel(size_t modelIndex, const std::string& modelPath, const std::string& modelFile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // A slot that is reused after a cancel starts over
+    cancelled.erase(std::remove(cancelled.begin(), cancelled.end(), modelIndex), cancelled.end());
+    pending++;
+
+    tasks.push_back([this, modelIndex, modelPath, modelFile]()
+    {
+        std::shared_ptr<PendingModel> pendingModel = std::make_shared<PendingModel>();
+        DecodedModel& model = pendingModel->model;
+        model.modelIndex = modelIndex;
+        try {
+            model.geometry = importModel(modelPath, modelFile);
+            listImages(model, modelPath);
+        }
+        catch (const std::exception& e) {
+            model.error = e.what();
+        }
+
+        if (!model.error.empty() || model.images.empty())
+        {
+            finishModel(std::move(model));
+            return;
+        }
+
+        // Decode tasks go to the front, the images of this model are done before the next import starts
+        pendingModel->remainingImages = static_cast<uint32_t>(model.images.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = model.images.size(); i-- > 0;)
+            {
+                tasks.push_front([this, pendingModel, i]() { decodeModelImage(pendingModel, i); });
+            }
+        }
+        wake.notify_all();
+    });
+    wake.notify_one();
+}
+
+void AssetLoader::decodeModelImage(const std::shared_ptr<PendingModel>& pendingModel, size_t image)
+{
+    DecodedModel& model = pendingModel->model;
+
+    // Every task writes its own slot, only the error is shared
+    try {
+        model.images[image] = decodeImage(model.images[image].path);
+    }
+    catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        model.error = e.what();
+    }
+
+    // The last decode hands the model over
+    if (pendingModel->remainingImages.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        finishModel(std::move(model));
+    }
+}
+
+void AssetLoader::finishModel(DecodedModel&& model)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto cancel = std::find(cancelled.begin(), cancelled.end(), model.modelIndex);
+    if (cancel != cancelled.end())
+    {
+        cancelled.erase(cancel);
+        pending--;
+        return;
+    }
+    loaded.push_back(std::move(model));
+}
+
+std::vector<DecodedModel> AssetLoader::takeLoaded()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<DecodedModel> result = std::move(loaded);
+    loaded.clear();
+    pending -= static_cast<uint32_t>(result.size());
+    return result;
+}
+
+void AssetLoader::cancel(size_t modelIndex)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Already finished, drop the result here
+    auto done = std::find_if(loaded.begin(), loaded.end(), [&](const DecodedModel& model) { return model.modelIndex == modelIndex; });
+    if (done != loaded.end())
+    {
+        loaded.erase(done);
+        pending--;
+        return;
+    }
+    cancelled.push_back(modelIndex);
+}
+
+uint32_t AssetLoader::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return pending;
+}
+
+DecodedImage AssetLoader::decodeImage(const std::string& path)
+{
+    PROFILE_ZONE("Decode image");
+
+    if (TextureContainer::isContainer(path))
+    {
+        DecodedImage image;
+        image.path = path;
+        image.container = std::make_shared<TextureContainer>();
+        image.container->load(path);
+        image.width = image.container->getWidth();
+        image.height = image.container->getHeight();
+        return image;
+    }
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        throw std::runtime_error("Failed to load texture image! (" + path + ")");
+    }
+
+    DecodedImage image;
+    image.path = path;
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.reset(pixels);
+    return image;
+}
+
+void AssetLoader::workerLoop()
+{
+    PROFILE_THREAD("Asset loader");
+
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || !tasks.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+ImportedModel AssetLoader::importModel(const std::string& modelPath, const std::string& modelFile)
+{
+    PROFILE_ZONE("AssetLoader::importModel");
+
+    ImportedModel model;
+    std::shared_ptr<MeshCache> cache = std::make_shared<MeshCache>();
+    if (cache->open(modelPath + modelFile))
+    {
+        model.textureNames = cache->getMaterialTextures();
+        model.nodes = cache->getNodes();
+        model.cache = cache;
+        return model;
+    }
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath + modelFile, MESH_IMPORT_FLAGS);
+    if (!scene)
+    {
+        throw std::runtime_error("Failed to load model! (" + modelPath + modelFile + ")");
+    }
+    model.textureNames = MeshModel::loadMaterials(scene);
+    MeshModel::decodeNode(scene->mRootNode, scene, model.meshes, model.nodes);
+    if (MESH_OPTIMIZATION_ENABLED)
+    {
+        optimizeMeshes(model.meshes, modelFile);
+    }
+    if (MESH_SPLIT_FOR_INDEX16)
+    {
+        splitMeshes(model.meshes, MAX_INDEX16_VERTEX_COUNT);
+    }
+    MeshCache::write(modelPath + modelFile, model.textureNames, model.nodes, model.meshes);
+    return model;
+}
+
+std::vector<MeshView> ImportedModel::getMeshViews() const
+{
+    return cache ? cache->getMeshes() : MeshCache::view(meshes);
+}
+
+void AssetLoader::listImages(DecodedModel& model, const std::string& modelPath)
+{
+    const std::vector<std::string>& textureNames = model.geometry.textureNames;
+    model.materialImages.assign(textureNames.size(), -1);
+    for (size_t i = 0; i < textureNames.size(); ++i)
+    {
+        if (textureNames[i].empty())
+        {
+            continue;
+        }
+
+        std::string path = modelPath + textureNames[i];
+        auto image = std::find_if(model.images.begin(), model.images.end(), [&](const DecodedImage& decoded) { return decoded.path == path; });
+        if (image == model.images.end())
+        {
+            model.images.emplace_back();
+            model.images.back().path = path;
+            image = model.images.end() - 1;
+        }
+        model.materialImages[i] = static_cast<int>(image - model.images.begin());
+    }
+}
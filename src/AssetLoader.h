@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+
+#include "MeshModel.h"
+#include "MeshCache.h"
+#include "TextureContainer.h"
+#include "stb_image.h"
+
+// Minimum number of background threads for imports and decoding, separate from the recording
+// job system. By default there is one per hardware thread so image decoding scales with cores
+const uint32_t ASSET_LOADER_THREADS = 2;
+
+// Texture drawn until the real ones are resident
+const char* const PLACEHOLDER_TEXTURE_NAME = "__placeholder";
+
+// RGBA8 pixels of a decoded image, or the mapped KTX2 / DDS file uploaded as stored
+struct DecodedImage
+{
+    std::string path;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::unique_ptr<unsigned char, void(*)(void*)> pixels{ nullptr, stbi_image_free };
+    std::shared_ptr<TextureContainer> container;
+};
+
+// Geometry and materials of a model file on the CPU, from the mesh cache or a fresh import
+struct ImportedModel
+{
+    std::vector<std::string> textureNames;  // diffuse texture file per material, empty without one
+    std::vector<DecodedNode> nodes;
+    std::vector<DecodedMesh> meshes;
+    std::shared_ptr<MeshCache> cache;       // mapped geometry instead of meshes when the model was cached
+
+    // Views of the meshes wherever they are, valid as long as the model
+    std::vector<MeshView> getMeshViews() const;
+};
+
+// A model imported and decoded off the render thread, nothing in it touches the GPU yet
+struct DecodedModel
+{
+    size_t modelIndex = 0;
+    ImportedModel geometry;
+    std::vector<int> materialImages;        // index into images per material, -1 without a texture
+    std::vector<DecodedImage> images;
+    std::string error;                      // set when the import failed
+};
+
+// Runs model imports and image decoding on worker threads.
+// An import queues one decode task per image of the model ahead of everything else, so the
+// images of a model are decoded in parallel and the model is complete once the last one is done.
+// Results are queued and picked up by the render thread, which does every GPU upload itself.
+class AssetLoader
+{
+public:
+    // threadCount 0 picks one thread per hardware thread
+    void create(uint32_t threadCount = 0);
+    void cleanup();
+
+    // Queue the import of modelPath + modelFile for the model slot modelIndex
+    void loadModel(size_t modelIndex, const std::string& modelPath, const std::string& modelFile);
+
+    // Models the workers have finished, in completion order
+    std::vector<DecodedModel> takeLoaded();
+
+    // The model was destroyed while loading, its result is dropped
+    void cancel(size_t modelIndex);
+
+    // Loads queued or running, their results not taken yet
+    uint32_t getPendingCount() const;
+
+    // Decode an image file to RGBA8, KTX2 and DDS files are only mapped. Throws when it cannot be read
+    static DecodedImage decodeImage(const std::string& path);
+
+    // Map the mesh cache, or import with Assimp, optimize and split the meshes and write the cache.
+    // Used by the workers and by synchronous loads alike, safe on any thread. Throws when the file cannot be read
+    static ImportedModel importModel(const std::string& modelPath, const std::string& modelFile);
+
+private:
+    // A model whose images are still being decoded
+    struct PendingModel
+    {
+        DecodedModel model;
+        std::atomic<uint32_t> remainingImages{ 0 };
+    };
+
+    std::vector<std::thread> workers;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    std::vector<DecodedModel> loaded;
+    std::vector<size_t> cancelled;
+    uint32_t pending = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void decodeModelImage(const std::shared_ptr<PendingModel>& pending, size_t image);
+    void finishModel(DecodedModel&& model);
+
+    // The images of the model's materials, listed by path but not decoded yet
+    static void listImages(DecodedModel& model, const std::string& modelPath);
+};
@@ -0,0 +1,219 @@
+#include "CpuProfiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Logger.h"
+
+namespace
+{
+    enum class EventType : uint32_t
+    {
+        Zone,
+        Counter
+    };
+
+    struct Event
+    {
+        const char* name;
+        int64_t begin;
+        union
+        {
+            int64_t end;
+            double value;
+        };
+        EventType type;
+    };
+
+    // Events are stored in blocks so a thread that records little allocates little
+    const uint32_t EVENTS_PER_BLOCK = 16 * 1024;
+    const uint32_t BLOCKS_PER_THREAD = (PROFILER_EVENTS_PER_THREAD + EVENTS_PER_BLOCK - 1) / EVENTS_PER_BLOCK;
+
+    // Only the owning thread writes, the exporter reads up to the published count
+    struct ThreadBuffer
+    {
+        uint32_t threadId = 0;
+        std::string name;                                   // guarded by the registry mutex
+        std::unique_ptr<Event[]> blocks[BLOCKS_PER_THREAD];
+        std::atomic<uint32_t> count{ 0 };
+        std::atomic<uint32_t> dropped{ 0 };
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;     // kept after a thread exits
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    // Registration takes the lock once per thread, everything after is lock free
+    ThreadBuffer& getThreadBuffer()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr)
+        {
+            Registry& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(std::make_unique<ThreadBuffer>());
+            buffer = registry.threads.back().get();
+            buffer->threadId = static_cast<uint32_t>(registry.threads.size());
+            buffer->name = "Thread " + std::to_string(buffer->threadId);
+        }
+        return *buffer;
+    }
+
+    Event* reserveEvent(ThreadBuffer& buffer)
+    {
+        uint32_t index = buffer.count.load(std::memory_order_relaxed);
+        if (index >= PROFILER_EVENTS_PER_THREAD)
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        std::unique_ptr<Event[]>& block = buffer.blocks[index / EVENTS_PER_BLOCK];
+        if (!block)
+        {
+            block.reset(new Event[EVENTS_PER_BLOCK]);
+        }
+        return &block[index % EVENTS_PER_BLOCK];
+    }
+
+    // Make the event written into the reserved slot visible to the exporter
+    void publishEvent(ThreadBuffer& buffer)
+    {
+        buffer.count.store(buffer.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void writeJsonString(std::ofstream& file, const std::string& text)
+    {
+        file << '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                file << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                file << ' ';
+            }
+            else
+            {
+                file << c;
+            }
+        }
+        file << '"';
+    }
+}
+
+void CpuProfiler::zone(const char* name, int64_t begin, int64_t end)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    Event* event = reserveEvent(buffer);
+    if (event == nullptr)
+    {
+        return;
+    }
+
+    event->name = name;
+    event->begin = begin;
+    event->end = end;
+    event->type = EventType::Zone;
+    publishEvent(buffer);
+}
+
+void CpuProfiler::counter(const char* name, double value)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    Event* event = reserveEvent(buffer);
+    if (event == nullptr)
+    {
+        return;
+    }
+
+    event->name = name;
+    event->begin = now();
+    event->value = value;
+    event->type = EventType::Counter;
+    publishEvent(buffer);
+}
+
+void CpuProfiler::setThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(getRegistry().mutex);
+    buffer.name = name;
+}
+
+int64_t CpuProfiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - getRegistry().start).count();
+}
+
+// Threads keep recording while this runs, only events published before each thread is visited are written
+bool CpuProfiler::writeChromeTrace(const std::string& path)
+{
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open())
+    {
+        Logger::error("Failed to open trace file: " + path);
+        return false;
+    }
+
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    size_t eventCount = 0;
+    uint32_t droppedCount = 0;
+
+    for (const std::unique_ptr<ThreadBuffer>& thread : registry.threads)
+    {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->threadId
+             << ",\"args\":{\"name\":";
+        writeJsonString(file, thread->name);
+        file << "}}";
+        first = false;
+
+        uint32_t count = thread->count.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Event& event = thread->blocks[i / EVENTS_PER_BLOCK][i % EVENTS_PER_BLOCK];
+
+            // timestamps are in microseconds
+            file << ",\n{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"pid\":1,\"tid\":" << thread->threadId << ",\"ts\":" << event.begin / 1000.0;
+            if (event.type == EventType::Zone)
+            {
+                file << ",\"ph\":\"X\",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+            }
+            else
+            {
+                file << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}}";
+            }
+        }
+
+        eventCount += count;
+        droppedCount += thread->dropped.load(std::memory_order_relaxed);
+    }
+
+    file << "\n]}\n";
+
+    Logger::info("Wrote " + std::to_string(eventCount) + " profiler events to " + path +
+        (droppedCount > 0 ? ", " + std::to_string(droppedCount) + " dropped" : ""));
+    return file.good();
+}
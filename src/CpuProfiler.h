@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// CPU instrumentation, compiled in with the VULKANOVISTA_PROFILER build option.
+// Without it the macros expand to nothing and the profiler costs nothing.
+//
+//   PROFILE_ZONE("Name");              time the enclosing scope
+//   PROFILE_COUNTER("Name", value);    sample a value, shown as a graph
+//   PROFILE_THREAD("Name");            name the calling thread in the trace
+//
+// Names must outlive the profiler, string literals are stored by pointer.
+// Every thread writes into its own buffer without locking, the buffers are
+// written to a Chrome / Perfetto trace with CpuProfiler::writeChromeTrace().
+
+// Events kept per thread, later events are dropped and counted
+const uint32_t PROFILER_EVENTS_PER_THREAD = 1u << 20;
+
+// Written on shutdown and from the UI
+const char* const CPU_TRACE_FILE = "cpu_trace.json";
+
+class CpuProfiler
+{
+public:
+    class Zone
+    {
+    public:
+        explicit Zone(const char* name) : name(name), begin(now()) {}
+        ~Zone() { CpuProfiler::zone(name, begin, now()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* name;
+        int64_t begin;
+    };
+
+    static void zone(const char* name, int64_t begin, int64_t end);
+    static void counter(const char* name, double value);
+    static void setThreadName(const std::string& name);
+
+    // Nanoseconds since the profiler started
+    static int64_t now();
+
+    // Write every event recorded so far, open in chrome://tracing or ui.perfetto.dev
+    static bool writeChromeTrace(const std::string& path);
+};
+
+#ifdef VULKANOVISTA_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) CpuProfiler::counter(name, static_cast<double>(value))
+#define PROFILE_THREAD(name) CpuProfiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,74 +1,114 @@
-#pragma once
-
-#include <vulkan/vulkan.h>
-#include <optional>
-#include <iostream>
-#include <vector>
-#include <string>
-#include <set>
-
-#include "Instance.h"
-
-struct QueueFamilyIndices
-{
-    std::optional<uint32_t> graphicsFamily;
-    std::optional<uint32_t> presentFamily;
-
-    bool isComplete() const 
-    {
-        return graphicsFamily.has_value() && presentFamily.has_value();
-    }
-};
-
-struct SwapChainSupportDetails 
-{
-    VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> presentModes;
-};
-
-
-class Device 
-{
-public:
-    void pickPhysicalDevice(const Instance& instance, VkSurfaceKHR surface);
-    VkPhysicalDevice getPhysicalDevice() const;
-    void createLogicalDevice(VkSurfaceKHR surface);
-    VkDevice getLogicalDevice() const;
-    uint32_t getGraphicsQueueFamilyIndex() const;
-    VkQueue getGraphicsQueue() const;
-    VkQueue getPresentQueue() const;
-    void cleanup();
-    void waitIdle();
-    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
-
-    std::vector<VkSurfaceFormatKHR> getSurfaceFormats(VkSurfaceKHR surface) const;
-    std::vector<VkPresentModeKHR> getPresentModes(VkSurfaceKHR surface) const;
-
-
-    void createCommandPool();
-    VkCommandPool getCommandPool();
-
-    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-    
-private:
-    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    VkDevice device;
-    VkQueue graphicsQueue;
-    VkQueue presentQueue;
-    uint32_t graphicsQueueFamilyIndex = UINT32_MAX;
-
-    VkCommandPool commandPool = VK_NULL_HANDLE;
-
-    std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME  // Required for swapchain creation
-    };
-
-    bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
-    int rateDeviceSuitability(VkPhysicalDevice device, VkSurfaceKHR surface);
-    bool isSwapchainExtensionSupported(VkPhysicalDevice physicalDevice);
-    bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
-    bool  findGraphicsAndPresentQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t& graphicsQueueFamilyIndex, uint32_t& presentQueueFamilyIndex);
-
-};
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <optional>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+
+#include "Instance.h"
+#include "MemoryAllocator.h"
+#include "GpuTimeline.h"
+#include "UploadEngine.h"
+#include "GeometryArena.h"
+
+struct QueueFamilyIndices
+{
+    std::optional<uint32_t> graphicsFamily;
+    std::optional<uint32_t> presentFamily;
+
+    bool isComplete() const 
+    {
+        return graphicsFamily.has_value() && presentFamily.has_value();
+    }
+};
+
+struct SwapChainSupportDetails 
+{
+    VkSurfaceCapabilitiesKHR capabilities;
+    std::vector<VkSurfaceFormatKHR> formats;
+    std::vector<VkPresentModeKHR> presentModes;
+};
+
+
+// A null surface selects headless mode, presentation and VK_KHR_swapchain are then not required
+class Device 
+{
+public:
+    void pickPhysicalDevice(const Instance& instance, VkSurfaceKHR surface);
+    VkPhysicalDevice getPhysicalDevice() const;
+    void createLogicalDevice(VkSurfaceKHR surface);
+    VkDevice getLogicalDevice() const;
+    uint32_t getGraphicsQueueFamilyIndex() const;
+    VkQueue getGraphicsQueue() const;
+    VkQueue getPresentQueue() const;
+    uint32_t getTransferQueueFamilyIndex() const { return transferQueueFamilyIndex; }
+    VkQueue getTransferQueue() const { return transferQueue; }
+    bool supportsTimelineSemaphores() const { return timelineSemaphoreSupported; }
+    bool supportsSamplerAnisotropy() const { return samplerAnisotropySupported; }
+    // Indirect draws, the count variant is core in Vulkan 1.2 but optional
+    bool supportsDrawIndirectCount() const { return drawIndirectCountSupported; }
+    bool supportsMultiDrawIndirect() const { return multiDrawIndirectSupported; }
+    bool supportsDrawIndirectFirstInstance() const { return drawIndirectFirstInstanceSupported; }
+    void cleanup();
+    void waitIdle();
+    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
+
+    std::vector<VkSurfaceFormatKHR> getSurfaceFormats(VkSurfaceKHR surface) const;
+    std::vector<VkPresentModeKHR> getPresentModes(VkSurfaceKHR surface) const;
+
+
+    void createCommandPool();
+    VkCommandPool getCommandPool();
+
+    // All buffer and image memory is sub-allocated from here
+    MemoryAllocator& getAllocator() { return allocator; }
+
+    // Every graphics submission signals the next value, frames, uploads and deferred deletion use it
+    GpuTimeline& getGpuTimeline() { return gpuTimeline; }
+
+    // Batched CPU to GPU copies, on the transfer queue when there is one
+    UploadEngine& getUploadEngine() { return uploadEngine; }
+
+    // Vertex and index buffers shared by all meshes
+    GeometryArena& getGeometryArena() { return geometryArena; }
+
+    // Size of the upload staging ring, set before createLogicalDevice
+    void setStagingBufferSize(VkDeviceSize size) { stagingBufferSize = size; }
+    
+private:
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device;
+    VkQueue graphicsQueue;
+    VkQueue presentQueue;
+    uint32_t graphicsQueueFamilyIndex = UINT32_MAX;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    uint32_t transferQueueFamilyIndex = UINT32_MAX;
+    bool timelineSemaphoreSupported = false;
+    bool samplerAnisotropySupported = false;
+    bool drawIndirectCountSupported = false;
+    bool multiDrawIndirectSupported = false;
+    bool drawIndirectFirstInstanceSupported = false;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+
+    MemoryAllocator allocator;
+    GpuTimeline gpuTimeline;
+    UploadEngine uploadEngine;
+    GeometryArena geometryArena;
+    VkDeviceSize stagingBufferSize = DEFAULT_STAGING_BUFFER_SIZE;
+
+    std::vector<const char*> deviceExtensions = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME  // Required for swapchain creation
+    };
+
+    bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
+    int rateDeviceSuitability(VkPhysicalDevice device, VkSurfaceKHR surface);
+    bool isSwapchainExtensionSupported(VkPhysicalDevice physicalDevice);
+    bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
+    uint32_t findTransferQueueFamily(VkPhysicalDevice physicalDevice, uint32_t graphicsQueueFamilyIndex);
+    bool  findGraphicsAndPresentQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t& graphicsQueueFamilyIndex, uint32_t& presentQueueFamilyIndex);
+
+};
@@ -1,118 +1,179 @@
-#include "Engine.h"
-
-#include <stdexcept>
-#include <chrono>
-
-#include "Logger.h"
-#include "Mesh.h"
-#include <glm/ext/matrix_transform.hpp>
-
-int Engine::init()
-{
-    if (initWindow() == EXIT_FAILURE)
-    {
-        return EXIT_FAILURE;
-    }
-
-    if (initVulkan() == EXIT_FAILURE)
-    {
-        return EXIT_FAILURE;
-    }
-
-
-    return 0;
-}
-
-void Engine::run()
-{
-    auto lastTime = std::chrono::high_resolution_clock::now();
-
-    while (!window.shouldClose()) 
-    {
-        SDL_Event event;
-        while (SDL_PollEvent(&event))
-        {
-            ImGui_ImplSDL3_ProcessEvent(&event); // Process ImGui input
-            if (event.type == SDL_EVENT_WINDOW_RESIZED) 
-            {
-                VkExtent2D newExtent = window.getExtent();
-                renderer.recreateSwapchain(newExtent);
-            }
-            window.pollEvents();
-        }
-
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
-        lastTime = currentTime;
- 
-        // Update the renderer
-        renderer.update(deltaTime);
-
-        // Draw frame
-        renderer.drawFrame();
-
-    }
-    device.waitIdle();
-}
-
-
-void Engine::cleanup()
-{
-    swapchain.cleanup();  // Clean up swapchain resources first.
-    renderer.cleanup();   // Clean up renderer resources
-    device.cleanup();     // Clean up device resources
-    instance.cleanup();   // Clean up Vulkan instance
-    window.cleanup();     // Clean up window
-}
-
-int Engine::initWindow()
-{
-    try {
-        window.create(WIDTH, HEIGHT, "VulkanoVista");
-        windowExtent = { WIDTH, HEIGHT };
-    }
-    catch (std::runtime_error &e) {
-        Logger::error("Failed to create window error: " + std::string(e.what()));
-        return EXIT_FAILURE;
-    }
-
-    return 0;
-}
-
-int Engine::initVulkan()
-{
-    try {
-        instance.create(window.getSDLWindow());
-        window.createSurface(instance);
-        instance.SetSurface(window.getSurface());
-
-        device.pickPhysicalDevice(instance, window.getSurface());
-        device.createLogicalDevice(window.getSurface());
-        swapchain.create(&device, window.getSurface(), windowExtent);
-        renderer.setup(&device, &swapchain, &window, &instance);
-
-        //int modelIndex = renderer.createMeshModel("assets/Crate/", "Crate1.obj");
-        int modelIndex = renderer.createMeshModel("assets/teapot/", "teapot.obj");
-
-        
-        MeshModel meshModel = renderer.getMeshModel(modelIndex);
-        glm::vec3 offset(0.0f, -60.0f, -150.0f);
-        float rotationAngle = glm::radians(-45.0f);
-        glm::vec3 scale(0.1f, 0.1f, 0.1f);
-        meshModel.setModel(glm::scale(meshModel.getModel().model, scale));
-        meshModel.setModel(glm::translate(meshModel.getModel().model, offset));
-        meshModel.setModel(glm::rotate(meshModel.getModel().model, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)));
-        
-
-        renderer.getMeshModel(modelIndex).setModel(meshModel.getModel().model);
-        
-
-        renderer.finalizeSetup();
-    }
-    catch (std::runtime_error& e) {
-        Logger::error("Failed to init Vulkan: " + std::string(e.what()));
-        return EXIT_FAILURE;
-    }
-
-    return 0;
-}
+#include "Engine.h"
+
+#include <stdexcept>
+#include <chrono>
+
+#include "Logger.h"
+#include "CpuProfiler.h"
+#include "Mesh.h"
+#include <glm/ext/matrix_transform.hpp>
+
+int Engine::init(bool headless)
+{
+    this->headless = headless;
+
+    if (headless)
+    {
+        windowExtent = { WIDTH, HEIGHT };
+    }
+    else if (initWindow() == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (initVulkan() == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+
+
+    return 0;
+}
+
+void Engine::run()
+{
+    PROFILE_THREAD("Main");
+    PROFILE_ZONE("Engine::run");
+
+    auto lastTime = std::chrono::high_resolution_clock::now();
+
+    while (!window.shouldClose()) 
+    {
+        PROFILE_ZONE("Frame");
+
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            ImGui_ImplSDL3_ProcessEvent(&event); // Process ImGui input
+            if (event.type == SDL_EVENT_WINDOW_RESIZED) 
+            {
+                VkExtent2D newExtent = window.getExtent();
+                renderer.recreateSwapchain(newExtent);
+            }
+            window.pollEvents();
+        }
+
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
+        lastTime = currentTime;
+ 
+        // Update the renderer
+        renderer.update(deltaTime);
+
+        // Draw frame
+        renderer.drawFrame();
+
+    }
+    device.waitIdle();
+}
+
+void Engine::runFrames(uint32_t frameCount)
+{
+    PROFILE_THREAD("Main");
+    PROFILE_ZONE("Engine::runFrames");
+
+    auto lastTime = std::chrono::high_resolution_clock::now();
+
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        PROFILE_ZONE("Frame");
+
+        auto currentTime = std::chrono::high_resolution_clock::now();
+        float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
+        lastTime = currentTime;
+
+        renderer.update(deltaTime);
+        renderer.drawFrame();
+    }
+    device.waitIdle();
+
+    Logger::info("Rendered " + std::to_string(frameCount) + " headless frames");
+}
+
+
+void Engine::cleanup()
+{
+#ifdef VULKANOVISTA_PROFILER
+    CpuProfiler::writeChromeTrace(CPU_TRACE_FILE);
+#endif
+
+    swapchain.cleanup();  // Clean up swapchain resources first.
+    renderer.cleanup();   // Clean up renderer resources
+    device.cleanup();     // Clean up device resources
+    instance.cleanup();   // Clean up Vulkan instance
+    window.cleanup();     // Clean up window
+}
+
+int Engine::initWindow()
+{
+    try {
+        window.create(WIDTH, HEIGHT, "VulkanoVista");
+        windowExtent = { WIDTH, HEIGHT };
+    }
+    catch (std::runtime_error &e) {
+        Logger::error("Failed to create window error: " + std::string(e.what()));
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+int Engine::initVulkan()
+{
+    try {
+        // Headless there is no surface, the device is picked for drawing alone and renders offscreen
+        instance.create(headless ? nullptr : window.getSDLWindow());
+        if (!headless)
+        {
+            window.createSurface(instance);
+            instance.SetSurface(window.getSurface());
+        }
+
+        device.pickPhysicalDevice(instance, window.getSurface());
+        device.setStagingBufferSize(STAGING_BUFFER_SIZE);
+        device.createLogicalDevice(window.getSurface());
+        if (headless)
+        {
+            swapchain.createOffscreen(&device, windowExtent);
+        }
+        else
+        {
+            swapchain.create(&device, window.getSurface(), windowExtent);
+        }
+        renderer.setup(&device, &swapchain, headless ? nullptr : &window, &instance, DEFAULT_FRAMES_IN_FLIGHT);
+
+        //int modelIndex = renderer.createMeshModel("assets/Crate/", "Crate1.obj");
+        // Imported in the background, a placeholder is drawn meanwhile and keeps the transform set below
+        int modelIndex = renderer.loadMeshModelAsync("assets/teapot/", "teapot.obj");
+
+        
+        MeshModel meshModel = renderer.getMeshModel(modelIndex);
+        glm::vec3 offset(0.0f, -60.0f, -150.0f);
+        float rotationAngle = glm::radians(-45.0f);
+        glm::vec3 scale(0.1f, 0.1f, 0.1f);
+        meshModel.setModel(glm::scale(meshModel.getModel().model, scale));
+        meshModel.setModel(glm::translate(meshModel.getModel().model, offset));
+        meshModel.setModel(glm::rotate(meshModel.getModel().model, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f)));
+        
+
+        renderer.getMeshModel(modelIndex).setModel(meshModel.getModel().model);
+
+        // A row of teapots from the one model, each mesh is drawn once for all of them
+        for (int i = -1; i <= 1; ++i)
+        {
+            renderer.getMeshModel(modelIndex).addInstance(glm::translate(glm::mat4(1.0f), glm::vec3(i * 8.0f, 0.0f, 0.0f)));
+        }
+
+        // The row does not move, its draws and instances are recorded once
+        renderer.getMeshModel(modelIndex).setStatic(true);
+        
+
+        renderer.finalizeSetup();
+    }
+    catch (std::runtime_error& e) {
+        Logger::error("Failed to init Vulkan: " + std::string(e.what()));
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
@@ -1,35 +1,47 @@
-#pragma once
-
-#include "Window.h"
-#include "Instance.h"
-#include "Device.h"
-#include "Swapchain.h"
-#include "Renderer.h"
-
-const int WIDTH = 1280;
-const int HEIGHT = 720;
-
-class Engine 
-{
-public:
-    // Initialize the engine
-    int init();
-
-    // Start the main loop
-    void run();   
-
-    // Cleanup resources
-    void cleanup(); 
-
-private:
-    Window window;
-    Instance instance;
-    Device device;
-    Swapchain swapchain;
-    Renderer renderer;
-
-    VkExtent2D windowExtent;  // holding the window size
-
-    int initWindow();
-    int initVulkan();
-};
+#pragma once
+
+#include "Window.h"
+#include "Instance.h"
+#include "Device.h"
+#include "Swapchain.h"
+#include "Renderer.h"
+
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+
+// Persistently mapped staging memory shared by all uploads, larger uploads are split into chunks
+const VkDeviceSize STAGING_BUFFER_SIZE = 32ull * 1024 * 1024;
+
+// Frames rendered by a headless run when no count is given
+const uint32_t HEADLESS_FRAME_COUNT = 300;
+
+class Engine 
+{
+public:
+    // Initialize the engine, headless renders into offscreen images without a window or surface
+    int init(bool headless = false);
+
+    // Start the main loop
+    void run();   
+
+    // Render a fixed number of frames without a window, for headless runs
+    void runFrames(uint32_t frameCount);
+
+    bool isHeadless() const { return headless; }
+
+    // Cleanup resources
+    void cleanup(); 
+
+private:
+    Window window;
+    Instance instance;
+    Device device;
+    Swapchain swapchain;
+    Renderer renderer;
+
+    VkExtent2D windowExtent;  // holding the window size
+    bool headless = false;
+
+    int initWindow();
+    int initVulkan();
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+// Default number of frames the CPU may record ahead of the GPU.
+const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+const uint32_t MAX_FRAMES_IN_FLIGHT_LIMIT = 8;
+
+// Max descriptor sets (and descriptors of each type) a frame can allocate from its arena.
+const uint32_t FRAME_DESCRIPTOR_ARENA_SIZE = 64;
+
+// Scene draws are cut into chunks of this many, each recorded by a job into its own secondary command buffer
+const uint32_t DRAWS_PER_RECORDING_JOB = 256;
+const uint32_t MAX_RECORDING_THREADS = 8;
+
+// Initial capacity of a frame's instance buffer in instances, grows when exceeded
+const uint32_t DEFAULT_FRAME_INSTANCES = 1024;
+
+// Static bundles of a frame that can hold instanced draws, each one keeps its own instance set
+const uint32_t MAX_INSTANCED_STATIC_BUNDLES = 4;
+
+// Secondary command buffers of one recording thread.
+// Every thread has its own pool so no locking is needed, the buffers stay allocated and are
+// reused after the pool is reset.
+struct ThreadCommands
+{
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> secondaries;
+    uint32_t used = 0;
+};
+
+// Draws of static models recorded once and executed again every frame.
+// Re-recorded only when anything it was recorded from has changed since.
+struct StaticBundle
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    bool recorded = false;
+    uint32_t drawCount = 0;
+
+    // What it was recorded from
+    uint64_t sceneRevision = 0;
+    uint64_t geometryRevision = 0;
+    std::vector<uint32_t> modelRevisions;
+    std::vector<uint32_t> visibleDraws;
+
+    // Instances of the static instanced draws, only written when the bundle is recorded
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    Allocation instanceMemory;
+    uint32_t instanceCapacity = 0;
+    VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+};
+
+// Everything the CPU writes while building one frame.
+// The renderer keeps a ring of these and only reuses one after the GPU timeline has passed
+// its last submission, so nothing in here can still be read by the GPU while we record into it.
+struct FrameContext
+{
+    // Command recording, the pool is reset as a whole at the start of the frame
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    std::vector<ThreadCommands> threadCommands;     // indexed by job system thread
+
+    // Static bundles live across frames, their pool is never reset as a whole
+    VkCommandPool staticCommandPool = VK_NULL_HANDLE;
+    std::vector<StaticBundle> staticBundles;        // one per pipeline
+    VkDescriptorPool staticDescriptorPool = VK_NULL_HANDLE;     // instance sets of the bundles
+
+    // Slice of the shared view projection uniform buffer
+    VkDeviceSize uniformOffset = 0;
+    void* uniformMapped = nullptr;
+    VkDescriptorSet vpDescriptorSet = VK_NULL_HANDLE;
+
+    // Instance data of the instanced draws, host visible and mapped, replaced when outgrown
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    Allocation instanceMemory;
+    uint32_t instanceCapacity = 0;
+
+    // Texture of every GPU cull bucket, the counts read back for this context come in this order
+    std::vector<int> cullBucketTextures;
+
+    // Descriptor arena for sets that only live for this frame, reset at the start of the frame
+    VkDescriptorPool descriptorArena = VK_NULL_HANDLE;
+
+    // Swapchain semaphores are binary, completion is tracked on the GPU timeline
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+    VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+    uint64_t timelineValue = 0;     // signaled when the last submission of this context has finished
+};
@@ -0,0 +1,147 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef VULKANOVISTA_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "CpuProfiler.h"
+
+void FrustumCuller::getPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    // Gribb and Hartmann, each plane is a sum or difference of rows of the matrix
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+    planes[0] = rows[3] + rows[0];      // left
+    planes[1] = rows[3] - rows[0];      // right
+    planes[2] = rows[3] + rows[1];      // bottom
+    planes[3] = rows[3] - rows[1];      // top
+    planes[4] = rows[2];                // near, depth 0 to 1
+    planes[5] = rows[3] - rows[2];      // far
+
+    // Normalized, the sphere test compares distances
+    for (int i = 0; i < 6; ++i)
+    {
+        float length = glm::length(glm::vec3(planes[i]));
+        planes[i] = length > 0.0f ? planes[i] / length : planes[i];
+    }
+}
+
+void FrustumCuller::begin(const glm::mat4& viewProjection)
+{
+    getPlanes(viewProjection, planes);
+
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+    radius.clear();
+    visibility.clear();
+    stats = CullingStats{};
+}
+
+uint32_t FrustumCuller::add(const MeshBounds& bounds, const glm::mat4& transform)
+{
+    glm::vec3 center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+    glm::vec3 extent = (bounds.max - bounds.min) * 0.5f;
+
+    // Box around the transformed box, every world axis gathers the extent of all model axes
+    glm::vec3 worldExtent(0.0f);
+    float scale = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        glm::vec3 column = glm::vec3(transform[axis]);
+        worldExtent += glm::abs(column) * extent[axis];
+        scale = std::max(scale, glm::length(column));
+    }
+
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(worldExtent.x);
+    extentY.push_back(worldExtent.y);
+    extentZ.push_back(worldExtent.z);
+    radius.push_back(bounds.radius * scale);
+    return static_cast<uint32_t>(radius.size() - 1);
+}
+
+void FrustumCuller::cull()
+{
+    PROFILE_ZONE("FrustumCuller::cull");
+
+    // Padding lanes are tested like any other, their results are never read
+    uint32_t count = static_cast<uint32_t>(radius.size());
+    uint32_t padded = (count + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE * CULLING_BATCH_SIZE;
+    for (std::vector<float>* values : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius })
+    {
+        values->resize(padded, 0.0f);
+    }
+    visibility.assign(padded, 0);
+
+    // Per plane the bounds reach as far as the tighter of the sphere and the box toward it
+#ifdef VULKANOVISTA_CULLING_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    __m128 absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+        absX[p] = _mm_andnot_ps(signMask, planeX[p]);
+        absY[p] = _mm_andnot_ps(signMask, planeY[p]);
+        absZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t i = 0; i < padded; i += CULLING_BATCH_SIZE)
+    {
+        __m128 x = _mm_loadu_ps(&centerX[i]);
+        __m128 y = _mm_loadu_ps(&centerY[i]);
+        __m128 z = _mm_loadu_ps(&centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&extentX[i]);
+        __m128 ey = _mm_loadu_ps(&extentY[i]);
+        __m128 ez = _mm_loadu_ps(&extentZ[i]);
+        __m128 r = _mm_loadu_ps(&radius[i]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                                         _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            __m128 boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)), _mm_mul_ps(absZ[p], ez));
+            __m128 reach = _mm_min_ps(r, boxReach);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (uint32_t lane = 0; lane < CULLING_BATCH_SIZE; ++lane)
+        {
+            visibility[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+        }
+    }
+#else
+    for (uint32_t i = 0; i < padded; ++i)
+    {
+        bool inside = true;
+        for (const glm::vec4& plane : planes)
+        {
+            float distance = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+            float boxReach = std::abs(plane.x) * extentX[i] + std::abs(plane.y) * extentY[i] + std::abs(plane.z) * extentZ[i];
+            inside = inside && distance + std::min(radius[i], boxReach) >= 0.0f;
+        }
+        visibility[i] = inside ? 1 : 0;
+    }
+#endif
+
+    stats.tested = count;
+    stats.visible = static_cast<uint32_t>(std::count(visibility.begin(), visibility.begin() + count, 1));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+
+// SSE is part of every x64 target, 32 bit x86 needs it enabled
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define VULKANOVISTA_CULLING_SSE
+#endif
+
+// Bounds tested together, one per SIMD lane
+const uint32_t CULLING_BATCH_SIZE = 4;
+
+struct CullingStats
+{
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+};
+
+// Tests mesh bounds against the view frustum.
+// Bounds are added in world space to structure of arrays storage, then all of them are tested
+// against the six planes a batch at a time. A mesh is culled when its bounding sphere or its box
+// is entirely behind one of the planes, both are conservative so nothing visible is lost.
+class FrustumCuller
+{
+public:
+    // Normalized planes of a view projection that maps to clip space with depth 0 to 1,
+    // inside is dot(plane.xyz, p) + plane.w >= 0
+    static void getPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+    // Start a new set of bounds
+    void begin(const glm::mat4& viewProjection);
+
+    // Model space bounds drawn with transform, returns the index of its result
+    uint32_t add(const MeshBounds& bounds, const glm::mat4& transform);
+
+    // Test everything added since begin()
+    void cull();
+
+    bool isVisible(uint32_t index) const { return visibility[index] != 0; }
+    const CullingStats& getStats() const { return stats; }
+
+private:
+    glm::vec4 planes[6];
+
+    // World space, indexed by add() order and padded to a whole batch
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;     // half size of the box along each world axis
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<float> radius;
+
+    std::vector<uint8_t> visibility;
+    CullingStats stats;
+};
@@ -0,0 +1,358 @@
+#include "GeometryArena.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <string>
+
+#include "UploadEngine.h"
+#include "GpuTimeline.h"
+#include "Utils.h"
+#include "Logger.h"
+
+// Size of an index in the 16 bit units of the index pool
+static uint32_t getIndexUnits(VkIndexType indexType)
+{
+    return indexType == VK_INDEX_TYPE_UINT16 ? 1 : 2;
+}
+
+void GeometryArena::create(VkDevice device, MemoryAllocator* allocator, UploadEngine* uploadEngine, GpuTimeline* gpuTimeline,
+                           uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    this->device = device;
+    this->allocator = allocator;
+    this->uploadEngine = uploadEngine;
+    this->gpuTimeline = gpuTimeline;
+
+    // Transfer source as well, growing and compacting copies the ranges into a new buffer
+    vertexPool.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    vertexPool.stride = sizeof(GpuVertex);
+    createPool(vertexPool, vertexCapacity);
+
+    indexPool.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    indexPool.stride = sizeof(uint16_t);
+    createPool(indexPool, uint64_t(indexCapacity) * getIndexUnits(VK_INDEX_TYPE_UINT32));
+}
+
+void GeometryArena::cleanup()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    destroyBuffer(device, *allocator, vertexPool.buffer, vertexPool.memory);
+    destroyBuffer(device, *allocator, indexPool.buffer, indexPool.memory);
+
+    entries.clear();
+    freeHandles.clear();
+    meshCount = 0;
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t GeometryArena::allocate(const std::vector<GpuVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    return allocate(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+}
+
+uint32_t GeometryArena::allocate(const GpuVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+{
+    return allocateGeometry(vertices, vertexCount, indices, indexCount, VK_INDEX_TYPE_UINT32);
+}
+
+uint32_t GeometryArena::allocate(const GpuVertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount)
+{
+    return allocateGeometry(vertices, vertexCount, indices, indexCount, VK_INDEX_TYPE_UINT16);
+}
+
+uint32_t GeometryArena::allocateGeometry(const GpuVertex* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount,
+                                         VkIndexType indexType)
+{
+    const uint32_t indexUnits = getIndexUnits(indexType);
+
+    Entry entry;
+    uint64_t vertexOffset = allocateRange(vertexPool, vertexCount, 1, entry.vertexNode);
+    uint64_t indexOffset = allocateRange(indexPool, uint64_t(indexCount) * indexUnits, indexUnits, entry.indexNode);
+
+    entry.range.vertexOffset = static_cast<int32_t>(vertexOffset);
+    entry.range.firstIndex = static_cast<uint32_t>(indexOffset / indexUnits);
+    entry.range.vertexCount = vertexCount;
+    entry.range.indexCount = indexCount;
+    entry.range.indexType = indexType;
+
+    // Goes through the staging ring into the current upload batch
+    if (vertexCount > 0)
+    {
+        uploadEngine->uploadBuffer(vertexPool.buffer, vertexOffset * vertexPool.stride,
+            vertices, vertexCount * vertexPool.stride);
+    }
+    if (indexCount > 0)
+    {
+        uploadEngine->uploadBuffer(indexPool.buffer, indexOffset * indexPool.stride,
+            indices, uint64_t(indexCount) * indexUnits * indexPool.stride);
+    }
+
+    uint32_t handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        entries[handle] = entry;
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(entries.size());
+        entries.push_back(entry);
+    }
+
+    meshCount++;
+    index16MeshCount += indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+    return handle;
+}
+
+void GeometryArena::free(uint32_t handle)
+{
+    if (handle >= entries.size())
+    {
+        return;
+    }
+
+    // The handle can be reused now, nothing on the GPU refers to it
+    Entry& entry = entries[handle];
+    freeRange(vertexPool, entry.vertexNode);
+    freeRange(indexPool, entry.indexNode);
+    index16MeshCount -= entry.range.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+    entry = Entry{};
+
+    freeHandles.push_back(handle);
+    meshCount--;
+}
+
+// Frames in flight may still draw from the range, it goes back to the allocator once they are done
+void GeometryArena::freeRange(Pool& pool, uint32_t node)
+{
+    if (node == TlsfAllocator::INVALID_NODE)
+    {
+        return;
+    }
+
+    uint32_t generation = pool.generation;
+    gpuTimeline->defer([&pool, node, generation]()
+    {
+        // A rebuild since then only kept live ranges, this one is gone already
+        if (pool.generation == generation)
+        {
+            pool.ranges.free(node);
+        }
+    });
+}
+
+void GeometryArena::compact()
+{
+    // The rebuild copies only live ranges, an empty arena has nothing to defragment
+    if (!vertexPool.ranges.isEmpty())
+    {
+        rebuild(vertexPool, vertexPool.ranges.getCapacity());
+    }
+    if (!indexPool.ranges.isEmpty())
+    {
+        rebuild(indexPool, indexPool.ranges.getCapacity());
+    }
+
+    // Frames recorded from now on use the new buffers, the moves must be submitted before them
+    uploadEngine->flush();
+}
+
+bool GeometryArena::compactIfFragmented()
+{
+    bool compacted = false;
+    for (Pool* pool : { &vertexPool, &indexPool })
+    {
+        if (isFragmented(*pool))
+        {
+            rebuild(*pool, pool->ranges.getCapacity());
+            compacted = true;
+        }
+    }
+
+    if (compacted)
+    {
+        uploadEngine->flush();
+    }
+    return compacted;
+}
+
+bool GeometryArena::isFragmented(const Pool& pool)
+{
+    // A little free space is not worth copying the whole pool for, however it is split
+    const TlsfAllocator& ranges = pool.ranges;
+    uint64_t freeSize = ranges.getFreeSize();
+    if (ranges.isEmpty() || freeSize < ranges.getCapacity() * GEOMETRY_COMPACT_MIN_FREE)
+    {
+        return false;
+    }
+    return ranges.getLargestFreeSize() < freeSize * GEOMETRY_COMPACT_FREE_RATIO;
+}
+
+void GeometryArena::bind(VkCommandBuffer commandBuffer, VkIndexType& boundIndexType) const
+{
+    VkDeviceSize offsets[] = { 0 };
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexPool.buffer, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, indexPool.buffer, 0, VK_INDEX_TYPE_UINT32);
+    boundIndexType = VK_INDEX_TYPE_UINT32;
+}
+
+void GeometryArena::draw(VkCommandBuffer commandBuffer, uint32_t handle, VkIndexType& boundIndexType,
+                         uint32_t instanceCount, uint32_t firstInstance) const
+{
+    const GeometryRange& range = entries[handle].range;
+    bindIndexType(commandBuffer, range.indexType, boundIndexType);
+    vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, range.firstIndex, range.vertexOffset, firstInstance);
+}
+
+void GeometryArena::bindIndexType(VkCommandBuffer commandBuffer, VkIndexType indexType, VkIndexType& boundIndexType) const
+{
+    if (indexType != boundIndexType)
+    {
+        // Same buffer, firstIndex is in units of the new type
+        vkCmdBindIndexBuffer(commandBuffer, indexPool.buffer, 0, indexType);
+        boundIndexType = indexType;
+    }
+}
+
+GeometryRange GeometryArena::getRange(uint32_t handle) const
+{
+    return entries[handle].range;
+}
+
+GeometryStats GeometryArena::getStats() const
+{
+    GeometryStats stats;
+    stats.vertexCapacity = static_cast<uint32_t>(vertexPool.ranges.getCapacity());
+    stats.vertexCount = stats.vertexCapacity - static_cast<uint32_t>(vertexPool.ranges.getFreeSize());
+    stats.indexByteCapacity = indexPool.ranges.getCapacity() * indexPool.stride;
+    stats.indexBytes = stats.indexByteCapacity - indexPool.ranges.getFreeSize() * indexPool.stride;
+    stats.meshCount = meshCount;
+    stats.index16MeshCount = index16MeshCount;
+    return stats;
+}
+
+void GeometryArena::createPool(Pool& pool, uint64_t capacity)
+{
+    createBuffer(device, *allocator, capacity * pool.stride, pool.usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, pool.buffer, pool.memory);
+    pool.ranges.init(capacity);
+}
+
+uint64_t GeometryArena::allocateRange(Pool& pool, uint64_t count, uint64_t alignment, uint32_t& node)
+{
+    if (count == 0)
+    {
+        node = TlsfAllocator::INVALID_NODE;
+        return 0;
+    }
+
+    uint64_t offset = 0;
+    node = pool.ranges.allocate(count, alignment, offset);
+    if (node == TlsfAllocator::INVALID_NODE)
+    {
+        // Full or too fragmented, move everything into a buffer at least twice as large
+        uint64_t used = pool.ranges.getCapacity() - pool.ranges.getFreeSize();
+        uint64_t capacity = std::max(pool.ranges.getCapacity() * 2, (used + count) * 2);
+        Logger::info("Growing geometry arena to " + std::to_string(capacity) + " elements");
+
+        rebuild(pool, capacity);
+
+        node = pool.ranges.allocate(count, alignment, offset);
+        if (node == TlsfAllocator::INVALID_NODE)
+        {
+            throw std::runtime_error("Failed to allocate geometry arena range!");
+        }
+    }
+    return offset;
+}
+
+// Copy every live range of the pool to the front of a new buffer and swap it in.
+// The old buffer is destroyed once the copies have completed, which also covers frames
+// that were submitted before them and still read it.
+void GeometryArena::rebuild(Pool& pool, uint64_t capacity)
+{
+    const bool vertexRanges = &pool == &vertexPool;
+
+    // Live ranges in the order they sit in the old buffer
+    std::vector<uint32_t> live;
+    for (uint32_t i = 0; i < entries.size(); ++i)
+    {
+        uint32_t node = vertexRanges ? entries[i].vertexNode : entries[i].indexNode;
+        if (node != TlsfAllocator::INVALID_NODE)
+        {
+            live.push_back(i);
+        }
+    }
+    // In elements of the pool, 16 bit units for indices
+    auto unitsOf = [&](const Entry& entry) -> uint64_t
+    {
+        return vertexRanges ? 1 : getIndexUnits(entry.range.indexType);
+    };
+    auto offsetOf = [&](const Entry& entry) -> uint64_t
+    {
+        return vertexRanges ? static_cast<uint64_t>(entry.range.vertexOffset) : uint64_t(entry.range.firstIndex) * unitsOf(entry);
+    };
+    auto countOf = [&](const Entry& entry) -> uint64_t
+    {
+        return vertexRanges ? entry.range.vertexCount : uint64_t(entry.range.indexCount) * unitsOf(entry);
+    };
+    std::sort(live.begin(), live.end(), [&](uint32_t a, uint32_t b)
+    {
+        return offsetOf(entries[a]) < offsetOf(entries[b]);
+    });
+
+    // Place them in a fresh range allocator first, the fit is not exact so it may need more room
+    TlsfAllocator ranges;
+    std::vector<std::pair<uint32_t, uint64_t>> placed(live.size());
+    bool fits = false;
+    while (!fits)
+    {
+        ranges.init(capacity);
+        fits = true;
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            placed[i].first = ranges.allocate(countOf(entries[live[i]]), unitsOf(entries[live[i]]), placed[i].second);
+            if (placed[i].first == TlsfAllocator::INVALID_NODE)
+            {
+                fits = false;
+                capacity *= 2;
+                break;
+            }
+        }
+    }
+
+    Pool moved;
+    moved.usage = pool.usage;
+    moved.stride = pool.stride;
+    moved.generation = pool.generation + 1;
+    createBuffer(device, *allocator, capacity * pool.stride, pool.usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, moved.buffer, moved.memory);
+    moved.ranges = ranges;
+
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        Entry& entry = entries[live[i]];
+        uploadEngine->copyBuffer(pool.buffer, moved.buffer, countOf(entry) * pool.stride,
+            offsetOf(entry) * pool.stride, placed[i].second * pool.stride);
+
+        if (vertexRanges)
+        {
+            entry.vertexNode = placed[i].first;
+            entry.range.vertexOffset = static_cast<int32_t>(placed[i].second);
+        }
+        else
+        {
+            entry.indexNode = placed[i].first;
+            entry.range.firstIndex = static_cast<uint32_t>(placed[i].second / unitsOf(entry));
+        }
+    }
+
+    uploadEngine->destroyAfterUpload(pool.buffer, pool.memory);
+    pool = moved;
+    revision++;
+}
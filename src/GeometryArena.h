@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "MemoryAllocator.h"
+#include "TlsfAllocator.h"
+#include "Vertex.h"
+
+class UploadEngine;
+class GpuTimeline;
+
+// Initial arena capacities, in vertices and 32 bit indices. Both grow when full
+const uint32_t DEFAULT_ARENA_VERTEX_COUNT = 1024 * 1024;
+const uint32_t DEFAULT_ARENA_INDEX_COUNT = 4 * 1024 * 1024;
+
+// A pool is compacted once its free space is at least this share of its capacity and the
+// largest free range holds less than GEOMETRY_COMPACT_FREE_RATIO of it
+const float GEOMETRY_COMPACT_MIN_FREE = 1.0f / 16.0f;
+const float GEOMETRY_COMPACT_FREE_RATIO = 0.5f;
+
+// Meshes with at most this many vertices are stored with 16 bit indices
+const uint32_t MAX_INDEX16_VERTEX_COUNT = 65536;
+
+struct GeometryStats
+{
+    uint32_t vertexCount = 0;       // live vertices
+    uint32_t vertexCapacity = 0;
+    uint64_t indexBytes = 0;        // live indices
+    uint64_t indexByteCapacity = 0;
+    uint32_t meshCount = 0;
+    uint32_t index16MeshCount = 0;  // meshes with 16 bit indices
+};
+
+// Where the geometry of one mesh lives inside the arenas
+struct GeometryRange
+{
+    int32_t vertexOffset = 0;
+    uint32_t firstIndex = 0;        // in indices of indexType
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+};
+
+// One vertex buffer and one index buffer shared by every mesh.
+// Meshes keep a handle, the ranges behind it may move when the arena grows or is compacted,
+// so a frame binds both buffers once and draws with vertexOffset / firstIndex.
+// 16 and 32 bit indices share the index buffer, it is bound again with the other index type
+// whenever a draw switches between them.
+class GeometryArena
+{
+public:
+    static const uint32_t INVALID_HANDLE = UINT32_MAX;
+
+    void create(VkDevice device, MemoryAllocator* allocator, UploadEngine* uploadEngine, GpuTimeline* gpuTimeline,
+                uint32_t vertexCapacity = DEFAULT_ARENA_VERTEX_COUNT,
+                uint32_t indexCapacity = DEFAULT_ARENA_INDEX_COUNT);
+    void cleanup();
+
+    // Upload the geometry into the arenas, indices are relative to the first vertex
+    uint32_t allocate(const std::vector<GpuVertex>& vertices, const std::vector<uint32_t>& indices);
+    uint32_t allocate(const GpuVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+    uint32_t allocate(const GpuVertex* vertices, uint32_t vertexCount, const uint16_t* indices, uint32_t indexCount);
+
+    // The ranges are reused once the frames submitted so far have finished
+    void free(uint32_t handle);
+
+    // Move every live range to the front of the arenas so the free space is in one piece
+    void compact();
+    // Compact only the pools whose free space is split up, returns whether any moved
+    bool compactIfFragmented();
+
+    // Binds the index buffer as 32 bit, draw rebinds it when a mesh uses the other type
+    void bind(VkCommandBuffer commandBuffer, VkIndexType& boundIndexType) const;
+    void draw(VkCommandBuffer commandBuffer, uint32_t handle, VkIndexType& boundIndexType,
+              uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
+    // Rebind the index buffer when indexType is not the bound one, for draws that do not go through draw()
+    void bindIndexType(VkCommandBuffer commandBuffer, VkIndexType indexType, VkIndexType& boundIndexType) const;
+
+    GeometryRange getRange(uint32_t handle) const;
+    GeometryStats getStats() const;
+
+    // Changes whenever ranges have moved, anything recorded with the old offsets is stale
+    uint64_t getRevision() const { return revision; }
+
+private:
+    struct Pool
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        Allocation memory;
+        VkBufferUsageFlags usage = 0;
+        VkDeviceSize stride = 0;
+        TlsfAllocator ranges;           // in elements, not bytes
+        uint32_t generation = 0;        // bumped by rebuild, deferred frees of older nodes are dropped
+    };
+
+    struct Entry
+    {
+        uint32_t vertexNode = TlsfAllocator::INVALID_NODE;
+        uint32_t indexNode = TlsfAllocator::INVALID_NODE;
+        GeometryRange range;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    UploadEngine* uploadEngine = nullptr;
+    GpuTimeline* gpuTimeline = nullptr;
+
+    Pool vertexPool;
+    Pool indexPool;                     // in 16 bit units, 32 bit ranges take two and are aligned to two
+
+    uint32_t index16MeshCount = 0;
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> freeHandles;
+    uint32_t meshCount = 0;
+    uint64_t revision = 0;
+
+    uint32_t allocateGeometry(const GpuVertex* vertices, uint32_t vertexCount, const void* indices, uint32_t indexCount,
+                              VkIndexType indexType);
+    void createPool(Pool& pool, uint64_t capacity);
+    uint64_t allocateRange(Pool& pool, uint64_t count, uint64_t alignment, uint32_t& node);
+    void rebuild(Pool& pool, uint64_t capacity);
+    static bool isFragmented(const Pool& pool);
+    void freeRange(Pool& pool, uint32_t node);
+};
@@ -0,0 +1,279 @@
+#include "GpuCuller.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include "FrameContext.h"
+#include "FrustumCuller.h"
+#include "Utils.h"
+
+namespace
+{
+    // Push constants of cull.comp
+    struct CullConstants
+    {
+        glm::vec4 planes[6];
+        uint32_t objectCount;
+        uint32_t compact;       // append visible commands to their bucket instead of using fixed slots
+        uint32_t padding[2];
+    };
+}
+
+void GpuCuller::create(VkDevice device, MemoryAllocator* allocator, const VkPipelineShaderStageCreateInfo& cullStage,
+                       bool drawIndirectCount, bool multiDrawIndirect)
+{
+    this->device = device;
+    this->allocator = allocator;
+    this->drawIndirectCount = drawIndirectCount;
+    this->multiDrawIndirect = multiDrawIndirect;
+
+    // Objects are read by the cull pass and by the vertex shader of the indirect draws
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings = {};
+    for (uint32_t i = 0; i < bindings.size(); ++i)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create cull descriptor set layout!");
+    }
+
+    // One set per frame context, they live as long as the culler
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = MAX_FRAMES_IN_FLIGHT_LIMIT * static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT_LIMIT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create cull descriptor pool!");
+    }
+
+    VkPushConstantRange pushConstantRange = {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(CullConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create cull pipeline layout!");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = cullStage;
+    pipelineInfo.layout = pipelineLayout;
+
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create cull pipeline!");
+    }
+}
+
+void GpuCuller::cleanup()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (FrameBuffers& frame : frames)
+    {
+        destroyFrameBuffers(frame);
+    }
+    frames.clear();
+
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+    pipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    descriptorPool = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+}
+
+GpuObject* GpuCuller::beginFrame(uint32_t frame, uint32_t objectCount, uint32_t bucketCount)
+{
+    if (frame >= frames.size())
+    {
+        frames.resize(frame + 1);
+    }
+    FrameBuffers& buffers = frames[frame];
+
+    // The counts of the last submission are final now that the frame context is free
+    if (buffers.countBuffer != VK_NULL_HANDLE)
+    {
+        const uint32_t* counts = static_cast<const uint32_t*>(buffers.countMemory.mapped);
+        bucketVisibleCounts.assign(counts, counts + buffers.bucketCount);
+        visibleCount = 0;
+        for (uint32_t i = 0; i < buffers.bucketCount; ++i)
+        {
+            visibleCount += counts[i];
+        }
+    }
+
+    // Nothing of this frame context is in flight, outgrown buffers can be replaced right away
+    if (buffers.objectBuffer == VK_NULL_HANDLE || objectCount > buffers.objectCapacity || bucketCount > buffers.bucketCapacity)
+    {
+        uint32_t objectCapacity = std::max(buffers.objectCapacity, DEFAULT_GPU_CULL_OBJECTS);
+        while (objectCapacity < objectCount)
+        {
+            objectCapacity *= 2;
+        }
+        uint32_t bucketCapacity = std::max(buffers.bucketCapacity, DEFAULT_GPU_CULL_BUCKETS);
+        while (bucketCapacity < bucketCount)
+        {
+            bucketCapacity *= 2;
+        }
+        destroyFrameBuffers(buffers);
+        createFrameBuffers(buffers, objectCapacity, bucketCapacity);
+    }
+
+    buffers.objectCount = objectCount;
+    buffers.bucketCount = bucketCount;
+    std::memset(buffers.countMemory.mapped, 0, bucketCount * sizeof(uint32_t));
+    return static_cast<GpuObject*>(buffers.objectMemory.mapped);
+}
+
+void GpuCuller::dispatch(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection)
+{
+    const FrameBuffers& buffers = frames[frame];
+    if (buffers.objectCount == 0)
+    {
+        return;
+    }
+
+    CullConstants constants = {};
+    FrustumCuller::getPlanes(viewProjection, constants.planes);
+    constants.objectCount = buffers.objectCount;
+    constants.compact = drawIndirectCount ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &buffers.descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &constants);
+    vkCmdDispatch(commandBuffer, (buffers.objectCount + GPU_CULL_GROUP_SIZE - 1) / GPU_CULL_GROUP_SIZE, 1, 1);
+
+    // Commands and counts are read as indirect arguments, the counts by the host once the frame is done
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::draw(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t bucket, uint32_t firstCommand,
+                     uint32_t commandCount) const
+{
+    const FrameBuffers& buffers = frames[frame];
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize offset = static_cast<VkDeviceSize>(firstCommand) * stride;
+
+    if (drawIndirectCount)
+    {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, buffers.commandBuffer, offset,
+            buffers.countBuffer, bucket * sizeof(uint32_t), commandCount, stride);
+    }
+    else if (multiDrawIndirect)
+    {
+        vkCmdDrawIndexedIndirect(commandBuffer, buffers.commandBuffer, offset, commandCount, stride);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < commandCount; ++i)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, buffers.commandBuffer, offset + i * stride, 1, stride);
+        }
+    }
+}
+
+uint32_t GpuCuller::getDrawCallCount(uint32_t commandCount) const
+{
+    return drawIndirectCount || multiDrawIndirect ? 1 : commandCount;
+}
+
+void GpuCuller::createFrameBuffers(FrameBuffers& frame, uint32_t objectCapacity, uint32_t bucketCapacity)
+{
+    createBuffer(device, *allocator, objectCapacity * sizeof(GpuObject), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.objectBuffer, frame.objectMemory);
+    createBuffer(device, *allocator, objectCapacity * sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.commandBuffer, frame.commandMemory);
+    createBuffer(device, *allocator, bucketCapacity * sizeof(uint32_t),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.countBuffer, frame.countMemory);
+    frame.objectCapacity = objectCapacity;
+    frame.bucketCapacity = bucketCapacity;
+
+    if (frame.descriptorSet == VK_NULL_HANDLE)
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &setLayout;
+
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate cull descriptor set!");
+        }
+    }
+
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos = {};
+    bufferInfos[0] = { frame.objectBuffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[1] = { frame.commandBuffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[2] = { frame.countBuffer, 0, VK_WHOLE_SIZE };
+
+    std::array<VkWriteDescriptorSet, 3> writes = {};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = frame.descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].descriptorCount = 1;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void GpuCuller::destroyFrameBuffers(FrameBuffers& frame)
+{
+    // The descriptor set is kept and pointed at the new buffers
+    if (frame.objectBuffer != VK_NULL_HANDLE)
+    {
+        destroyBuffer(device, *allocator, frame.objectBuffer, frame.objectMemory);
+        destroyBuffer(device, *allocator, frame.commandBuffer, frame.commandMemory);
+        destroyBuffer(device, *allocator, frame.countBuffer, frame.countMemory);
+    }
+    frame.objectCapacity = 0;
+    frame.bucketCapacity = 0;
+}
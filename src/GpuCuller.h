@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "MemoryAllocator.h"
+
+// Objects culled per compute workgroup, matches local_size_x of cull.comp
+const uint32_t GPU_CULL_GROUP_SIZE = 64;
+
+// Initial capacity of the per frame buffers in objects and draw counts, both grow when exceeded
+const uint32_t DEFAULT_GPU_CULL_OBJECTS = 4096;
+const uint32_t DEFAULT_GPU_CULL_BUCKETS = 64;
+
+// One drawable of the cull pass, read by cull.comp and shader_indirect.vert in std430 layout.
+// Every object produces one indexed draw command, its firstInstance is the object index so the
+// vertex shader finds the object through gl_InstanceIndex
+struct GpuObject
+{
+    glm::mat4 transform;        // world transform
+    glm::vec4 dequantScale;     // packed positions to model space, a scale and offset
+    glm::vec4 dequantOffset;
+    glm::vec4 boundsCenter;     // model space box center, w is the bounding sphere radius
+    glm::vec4 boundsExtent;     // model space half size of the box
+    uint32_t indexCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t bucket;            // draw count the object adds to when visible
+    uint32_t bucketFirst;       // first command of its bucket, where compacted commands go
+    uint32_t command;           // slot of its command when commands are not compacted
+    uint32_t padding[2];
+};
+
+static_assert(sizeof(GpuObject) == 160, "GpuObject must match the std430 layout of the shaders");
+
+// Frustum culling on the GPU that writes indirect draw commands.
+// The CPU only fills an array of objects, grouped into buckets of draws that share their state.
+// A compute pass tests the objects against the frustum and appends a VkDrawIndexedIndirectCommand
+// for every visible one to its bucket, counting them as it goes. Each bucket is then drawn with one
+// vkCmdDrawIndexedIndirectCount. Without draw count support every object keeps a fixed command
+// slot, culled ones get an instance count of 0, and buckets are drawn with multi draw indirect or
+// with one indirect draw per command when that is missing too.
+class GpuCuller
+{
+public:
+    void create(VkDevice device, MemoryAllocator* allocator, const VkPipelineShaderStageCreateInfo& cullStage,
+                bool drawIndirectCount, bool multiDrawIndirect);
+    void cleanup();
+
+    // Objects, commands and counts of a frame, set 2 of the indirect pipeline
+    VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+    VkDescriptorSet getDescriptorSet(uint32_t frame) const { return frames[frame].descriptorSet; }
+
+    // Start a frame context, its previous submission must have finished.
+    // Returns objectCount objects to fill in, valid until the frame is submitted
+    GpuObject* beginFrame(uint32_t frame, uint32_t objectCount, uint32_t bucketCount);
+
+    // Cull the objects of the frame, recorded into a primary outside of a render pass
+    void dispatch(VkCommandBuffer commandBuffer, uint32_t frame, const glm::mat4& viewProjection);
+
+    // Draw the commands of one bucket, commandCount is the number of objects in it
+    void draw(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t bucket, uint32_t firstCommand,
+              uint32_t commandCount) const;
+
+    // Indirect draw calls draw() records for a bucket of commandCount objects
+    uint32_t getDrawCallCount(uint32_t commandCount) const;
+
+    // Objects found visible the last time a frame context was reused, a few frames behind
+    uint32_t getVisibleCount() const { return visibleCount; }
+    // The same per bucket, in the bucket order of that frame context's submission
+    const std::vector<uint32_t>& getBucketVisibleCounts() const { return bucketVisibleCounts; }
+    bool usesDrawCount() const { return drawIndirectCount; }
+
+private:
+    struct FrameBuffers
+    {
+        VkBuffer objectBuffer = VK_NULL_HANDLE;     // host visible, written every frame
+        Allocation objectMemory;
+        VkBuffer commandBuffer = VK_NULL_HANDLE;    // written by the cull pass
+        Allocation commandMemory;
+        VkBuffer countBuffer = VK_NULL_HANDLE;      // host visible, cleared by the CPU, read back for stats
+        Allocation countMemory;
+        uint32_t objectCapacity = 0;
+        uint32_t bucketCapacity = 0;
+
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t objectCount = 0;
+        uint32_t bucketCount = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    bool drawIndirectCount = false;
+    bool multiDrawIndirect = false;
+
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+
+    std::vector<FrameBuffers> frames;
+    uint32_t visibleCount = 0;
+    std::vector<uint32_t> bucketVisibleCounts;
+
+    void createFrameBuffers(FrameBuffers& frame, uint32_t objectCapacity, uint32_t bucketCapacity);
+    void destroyFrameBuffers(FrameBuffers& frame);
+};
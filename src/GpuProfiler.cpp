@@ -0,0 +1,248 @@
+#include "GpuProfiler.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#include "imgui.h"
+#include "Logger.h"
+
+void GpuProfiler::create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t frameCount)
+{
+    this->device = device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    uint32_t validBits = queueFamilyIndex < familyCount ? families[queueFamilyIndex].timestampValidBits : 0;
+    supported = validBits > 0 && timestampPeriod > 0.0;
+    if (!supported)
+    {
+        Logger::warning("Timestamps are not supported on the graphics queue, GPU profiler disabled");
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    frames.resize(frameCount);
+    for (FrameQueries& frame : frames)
+    {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = MAX_GPU_SCOPES * 2;
+
+        if (vkCreateQueryPool(device, &poolInfo, nullptr, &frame.queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create timestamp query pool!");
+        }
+    }
+}
+
+void GpuProfiler::cleanup()
+{
+    for (FrameQueries& frame : frames)
+    {
+        vkDestroyQueryPool(device, frame.queryPool, nullptr);
+    }
+    frames.clear();
+
+    // Command buffers that used the fixed slots are gone with the frames
+    fixedScopes.clear();
+    supported = false;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    if (!supported)
+    {
+        return;
+    }
+
+    FrameQueries& frameQueries = frames[frame];
+    if (frameQueries.recorded)
+    {
+        collect(frameQueries);
+    }
+
+    frameQueries.scopeNames.clear();
+    frameQueries.recorded = true;
+    vkCmdResetQueryPool(commandBuffer, frameQueries.queryPool, 0, MAX_GPU_SCOPES * 2);
+}
+
+uint32_t GpuProfiler::registerFixedScope(const char* name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!supported || fixedScopes.size() >= MAX_GPU_SCOPES)
+    {
+        return INVALID_SCOPE;
+    }
+    fixedScopes.push_back(name);
+    return static_cast<uint32_t>(fixedScopes.size() - 1);
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, uint32_t frame, const char* name)
+{
+    if (!supported)
+    {
+        return INVALID_SCOPE;
+    }
+
+    uint32_t scope;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        FrameQueries& frameQueries = frames[frame];
+        scope = static_cast<uint32_t>(fixedScopes.size() + frameQueries.scopeNames.size());
+        if (scope >= MAX_GPU_SCOPES)
+        {
+            return INVALID_SCOPE;
+        }
+        frameQueries.scopeNames.push_back(name);
+    }
+
+    writeBegin(commandBuffer, frame, scope);
+    return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope)
+{
+    writeEnd(commandBuffer, frame, scope);
+}
+
+void GpuProfiler::writeBegin(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope)
+{
+    if (supported && scope != INVALID_SCOPE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frames[frame].queryPool, scope * 2);
+    }
+}
+
+void GpuProfiler::writeEnd(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope)
+{
+    if (supported && scope != INVALID_SCOPE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[frame].queryPool, scope * 2 + 1);
+    }
+}
+
+double GpuProfiler::getMilliseconds(const std::string& name) const
+{
+    for (const GpuScopeTiming& timing : timings)
+    {
+        if (timing.name == name)
+        {
+            return timing.milliseconds;
+        }
+    }
+    return -1.0;
+}
+
+std::vector<float> GpuProfiler::getHistory(const std::string& name) const
+{
+    for (const History& entry : history)
+    {
+        if (entry.name == name)
+        {
+            return std::vector<float>(entry.milliseconds.begin(), entry.milliseconds.end());
+        }
+    }
+    return {};
+}
+
+void GpuProfiler::drawImGui()
+{
+    ImGui::Begin("GPU Profiler");
+
+    if (!supported)
+    {
+        ImGui::Text("Timestamps are not supported on this device");
+        ImGui::End();
+        return;
+    }
+
+    for (const GpuScopeTiming& timing : timings)
+    {
+        std::vector<float> values = getHistory(timing.name);
+        float average = 0.0f;
+        float peak = 0.0f;
+        for (float value : values)
+        {
+            average += value;
+            peak = std::max(peak, value);
+        }
+        average = values.empty() ? 0.0f : average / values.size();
+
+        ImGui::Text("%-16s %7.3f ms  avg %7.3f  max %7.3f", timing.name.c_str(), timing.milliseconds, average, peak);
+        ImGui::PlotLines(("##" + timing.name).c_str(), values.data(), static_cast<int>(values.size()),
+            0, nullptr, 0.0f, peak * 1.2f, ImVec2(0, 40));
+    }
+
+    ImGui::End();
+}
+
+// Read the timestamps of a frame context, the GPU has finished it so nothing waits
+void GpuProfiler::collect(FrameQueries& frameQueries)
+{
+    uint32_t scopeCount = static_cast<uint32_t>(fixedScopes.size() + frameQueries.scopeNames.size());
+    if (scopeCount == 0)
+    {
+        return;
+    }
+
+    // Value and availability for every query, fixed scopes whose bundle did not run stay unavailable
+    std::vector<uint64_t> results(scopeCount * 2 * 2);
+    VkResult result = vkGetQueryPoolResults(device, frameQueries.queryPool, 0, scopeCount * 2,
+        results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+    {
+        return;
+    }
+
+    timings.clear();
+    collectedFrames++;
+    for (uint32_t scope = 0; scope < scopeCount; ++scope)
+    {
+        const uint64_t* begin = &results[scope * 4];
+        const uint64_t* end = &results[scope * 4 + 2];
+        if (begin[1] == 0 || end[1] == 0)
+        {
+            continue;
+        }
+
+        uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+        double milliseconds = ticks * timestampPeriod / 1000000.0;
+
+        const char* name = scope < fixedScopes.size() ? fixedScopes[scope] : frameQueries.scopeNames[scope - fixedScopes.size()];
+        auto timing = std::find_if(timings.begin(), timings.end(), [&](const GpuScopeTiming& t) { return t.name == name; });
+        if (timing == timings.end())
+        {
+            timings.push_back({ name, 0.0, 0 });
+            timing = timings.end() - 1;
+        }
+        timing->milliseconds += milliseconds;
+        timing->count++;
+    }
+
+    for (const GpuScopeTiming& timing : timings)
+    {
+        auto entry = std::find_if(history.begin(), history.end(), [&](const History& h) { return h.name == timing.name; });
+        if (entry == history.end())
+        {
+            history.push_back({ timing.name, {} });
+            entry = history.end() - 1;
+        }
+        entry->milliseconds.push_back(static_cast<float>(timing.milliseconds));
+        if (entry->milliseconds.size() > GPU_PROFILER_HISTORY)
+        {
+            entry->milliseconds.pop_front();
+        }
+    }
+}
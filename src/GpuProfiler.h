@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+
+// Timestamp scopes per frame context, at most this many per frame
+const uint32_t MAX_GPU_SCOPES = 256;
+// Frames of history kept for every scope name
+const uint32_t GPU_PROFILER_HISTORY = 240;
+
+struct GpuScopeTiming
+{
+    std::string name;
+    double milliseconds = 0.0;      // scopes with the same name are summed
+    uint32_t count = 0;
+};
+
+// Brackets passes and draw groups with timestamp queries, one query pool per frame context.
+// Results are read when the frame context comes around again, its timeline value has signaled by
+// then so reading never stalls.
+class GpuProfiler
+{
+public:
+    static const uint32_t INVALID_SCOPE = UINT32_MAX;
+
+    void create(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, uint32_t frameCount);
+    void cleanup();
+
+    bool isSupported() const { return supported; }
+
+    // Collect what the frame context measured last time and reset its queries.
+    // Recorded into the primary command buffer outside of a render pass.
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frame);
+
+    // A scope that is measured every frame at the same query slots, for command buffers that are
+    // recorded once and executed again (static bundles)
+    uint32_t registerFixedScope(const char* name);
+
+    // Per frame scopes, thread safe so jobs can time what they record
+    uint32_t beginScope(VkCommandBuffer commandBuffer, uint32_t frame, const char* name);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope);
+
+    // For fixed scopes, frame selects the query pool the command buffer belongs to
+    void writeBegin(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope);
+    void writeEnd(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t scope);
+
+    // Timings of the most recently collected frame
+    const std::vector<GpuScopeTiming>& getTimings() const { return timings; }
+    // Latest time of one scope name, negative when it was not measured
+    double getMilliseconds(const std::string& name) const;
+    // Bumped whenever a frame has been collected
+    uint64_t getCollectedFrames() const { return collectedFrames; }
+    // Rolling history of one scope name, oldest first
+    std::vector<float> getHistory(const std::string& name) const;
+
+    void drawImGui();
+
+private:
+    struct FrameQueries
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<const char*> scopeNames;    // per frame scopes, after the fixed ones
+        bool recorded = false;
+    };
+
+    struct History
+    {
+        std::string name;
+        std::deque<float> milliseconds;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    bool supported = false;
+    double timestampPeriod = 1.0;       // nanoseconds per tick
+    uint64_t timestampMask = ~0ull;
+
+    std::vector<FrameQueries> frames;
+    std::vector<const char*> fixedScopes;
+    std::mutex mutex;
+
+    std::vector<GpuScopeTiming> timings;
+    uint64_t collectedFrames = 0;
+    std::vector<History> history;
+
+    void collect(FrameQueries& frameQueries);
+};
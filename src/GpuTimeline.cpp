@@ -0,0 +1,249 @@
+#include "GpuTimeline.h"
+
+#include <stdexcept>
+
+void GpuTimeline::create(VkDevice device, VkQueue queue, bool useTimeline)
+{
+    this->device = device;
+    this->queue = queue;
+    this->useTimeline = useTimeline;
+
+    submittedValue = 0;
+    completedValue = 0;
+
+    if (useTimeline)
+    {
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create frame timeline semaphore!");
+        }
+    }
+}
+
+void GpuTimeline::cleanup()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Everything submitted has to finish before the deferred deletions may run
+    vkQueueWaitIdle(queue);
+    pollCompleted();
+    collect();
+
+    for (PendingFence& pending : pendingFences)
+    {
+        vkDestroyFence(device, pending.fence, nullptr);
+    }
+    pendingFences.clear();
+    for (VkFence fence : freeFences)
+    {
+        vkDestroyFence(device, fence, nullptr);
+    }
+    freeFences.clear();
+
+    if (semaphore != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(device, semaphore, nullptr);
+        semaphore = VK_NULL_HANDLE;
+    }
+
+    device = VK_NULL_HANDLE;
+}
+
+uint64_t GpuTimeline::submit(const VkSubmitInfo& submitInfo, const uint64_t* waitValues)
+{
+    const uint32_t maxSemaphores = 8;
+    if (submitInfo.waitSemaphoreCount > maxSemaphores || submitInfo.signalSemaphoreCount >= maxSemaphores)
+    {
+        throw std::runtime_error("Too many semaphores in timeline submit!");
+    }
+
+    // Values are handed out and submitted under one lock, so they signal in increasing order
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t value = ++submittedValue;
+
+    VkSubmitInfo info = submitInfo;
+
+    if (useTimeline)
+    {
+        // Binary semaphores ignore their value, the timeline is appended to the signals
+        VkSemaphore signalSemaphores[maxSemaphores];
+        uint64_t signalValues[maxSemaphores] = {};
+        for (uint32_t i = 0; i < submitInfo.signalSemaphoreCount; ++i)
+        {
+            signalSemaphores[i] = submitInfo.pSignalSemaphores[i];
+        }
+        signalSemaphores[submitInfo.signalSemaphoreCount] = semaphore;
+        signalValues[submitInfo.signalSemaphoreCount] = value;
+
+        uint64_t waitSemaphoreValues[maxSemaphores] = {};
+        for (uint32_t i = 0; waitValues != nullptr && i < submitInfo.waitSemaphoreCount; ++i)
+        {
+            waitSemaphoreValues[i] = waitValues[i];
+        }
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+        timelineInfo.pWaitSemaphoreValues = waitSemaphoreValues;
+        timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount + 1;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+
+        info.pNext = &timelineInfo;
+        info.signalSemaphoreCount = submitInfo.signalSemaphoreCount + 1;
+        info.pSignalSemaphores = signalSemaphores;
+
+        if (vkQueueSubmit(queue, 1, &info, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit to the frame timeline!");
+        }
+        return value;
+    }
+
+    VkFence fence;
+    if (!freeFences.empty())
+    {
+        fence = freeFences.back();
+        freeFences.pop_back();
+    }
+    else
+    {
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create timeline fence!");
+        }
+    }
+
+    if (vkQueueSubmit(queue, 1, &info, fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit to the frame timeline!");
+    }
+    pendingFences.push_back({ value, fence });
+    return value;
+}
+
+bool GpuTimeline::isComplete(uint64_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return value <= completedValue || value <= pollCompleted();
+}
+
+void GpuTimeline::wait(uint64_t value)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (value <= completedValue || value > submittedValue)
+    {
+        return;
+    }
+
+    if (useTimeline)
+    {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+
+        lock.unlock();
+        vkWaitSemaphores(device, &waitInfo, UINT64_MAX);
+        lock.lock();
+    }
+    else
+    {
+        // The first submission at or past the value, earlier ones are done when it is
+        for (PendingFence& pending : pendingFences)
+        {
+            if (pending.value >= value)
+            {
+                VkFence fence = pending.fence;
+                lock.unlock();
+                vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX);
+                lock.lock();
+                break;
+            }
+        }
+    }
+
+    pollCompleted();
+}
+
+uint64_t GpuTimeline::getSubmittedValue() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return submittedValue;
+}
+
+uint64_t GpuTimeline::getCompletedValue()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return pollCompleted();
+}
+
+void GpuTimeline::defer(std::function<void()> destroy)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    deletions.push_back({ submittedValue, std::move(destroy) });
+}
+
+void GpuTimeline::collect()
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        pollCompleted();
+        while (!deletions.empty() && deletions.front().value <= completedValue)
+        {
+            ready.push_back(std::move(deletions.front().destroy));
+            deletions.pop_front();
+        }
+    }
+
+    // Outside the lock, a deletion may submit or defer again
+    for (auto& destroy : ready)
+    {
+        destroy();
+    }
+}
+
+uint64_t GpuTimeline::pollCompleted()
+{
+    if (useTimeline)
+    {
+        uint64_t counter = 0;
+        if (vkGetSemaphoreCounterValue(device, semaphore, &counter) == VK_SUCCESS && counter > completedValue)
+        {
+            completedValue = counter;
+        }
+        return completedValue;
+    }
+
+    while (!pendingFences.empty() && vkGetFenceStatus(device, pendingFences.front().fence) == VK_SUCCESS)
+    {
+        PendingFence& pending = pendingFences.front();
+        completedValue = pending.value;
+
+        vkResetFences(device, 1, &pending.fence);
+        freeFences.push_back(pending.fence);
+        pendingFences.pop_front();
+    }
+    return completedValue;
+}
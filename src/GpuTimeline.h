@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+// One monotonically increasing value for all work on the graphics queue.
+// Frames and upload batches signal the next value when they are submitted, so asking whether
+// frame N has finished is a single compare against the semaphore counter.
+// Without timeline semaphores every submission gets a fence from a recycled pool instead,
+// submissions complete in order so the values mean the same.
+class GpuTimeline
+{
+public:
+    void create(VkDevice device, VkQueue queue, bool useTimeline);
+    void cleanup();
+
+    // Submit to the queue and signal the next value, which is returned.
+    // Semaphores in the submit info are binary, except waits with a non zero entry in waitValues.
+    uint64_t submit(const VkSubmitInfo& submitInfo, const uint64_t* waitValues = nullptr);
+
+    bool isComplete(uint64_t value);
+    void wait(uint64_t value);
+
+    uint64_t getSubmittedValue() const;
+    uint64_t getCompletedValue();
+
+    // Run destroy once everything submitted so far has finished on the GPU
+    void defer(std::function<void()> destroy);
+
+    // Run the deferred deletions that are safe now
+    void collect();
+
+    bool usesTimelineSemaphore() const { return useTimeline; }
+
+private:
+    struct PendingFence
+    {
+        uint64_t value;
+        VkFence fence;
+    };
+
+    struct Deletion
+    {
+        uint64_t value;
+        std::function<void()> destroy;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    bool useTimeline = false;
+
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    uint64_t submittedValue = 0;
+    uint64_t completedValue = 0;
+
+    // Fence fallback
+    std::deque<PendingFence> pendingFences;
+    std::vector<VkFence> freeFences;
+
+    std::deque<Deletion> deletions;
+
+    mutable std::mutex mutex;
+
+    uint64_t pollCompleted();
+};
@@ -1,135 +1,135 @@
-#include "ImGuiManager.h"
-#include <stdexcept>
-
-
-ImGuiManager::ImGuiManager(SDL_Window* window, VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, uint32_t queueFamily, VkRenderPass renderPass)
-    : window(window), instance(instance), device(device) 
-{
-
-    IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
-    ImGui::StyleColorsDark();
-
-    ImGuiIO& io = ImGui::GetIO();
-    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
-
-    ImGui_ImplSDL3_InitForVulkan(window);
-
-    // Create Vulkan descriptor pool
-    VkDescriptorPoolSize pool_sizes[] = {
-        { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
-        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000 },
-        { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000 }
-    };
-
-    VkDescriptorPoolCreateInfo pool_info = {};
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
-    pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
-    pool_info.pPoolSizes = pool_sizes;
-
-    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptorPool) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create Vulkan descriptor pool");
-    }
-
-    ImGui_ImplVulkan_InitInfo init_info = {};
-    init_info.Instance = instance;
-    init_info.PhysicalDevice = physicalDevice;
-    init_info.Device = device;
-    init_info.Queue = queue;
-    init_info.DescriptorPool = descriptorPool;
-    init_info.MinImageCount = 2;
-    init_info.ImageCount = 2;
-    init_info.RenderPass = renderPass;
-
-    ImGui_ImplVulkan_Init(&init_info);
-
-    initTextEditor(); // Initialize shader editor
-
-    initialized = true;
-}
-
-ImGuiManager::~ImGuiManager() 
-{
-    shutdown();
-}
-
-void ImGuiManager::shutdown() 
-{
-    if (!initialized) return;
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplSDL3_Shutdown();
-    ImGui::DestroyContext();
-    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-}
-
-void ImGuiManager::beginFrame() 
-{
-    if (!initialized) return;
-    ImGui_ImplVulkan_NewFrame();
-    ImGui_ImplSDL3_NewFrame();
-    ImGui::NewFrame();
-}
-
-void ImGuiManager::endFrame(VkCommandBuffer commandBuffer) 
-{
-    if (!initialized) return;
-    ImGui::Render();
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-}
-
-void ImGuiManager::initTextEditor()
-{
-    //shaderEditor.SetLanguageDefinition(TextEditor::LanguageDefinition::GLSL()); // GLSL syntax
-    //shaderEditor.SetText("#version 450\nvoid main() {}"); // Default shader code
-}
-
-void ImGuiManager::drawShaderEditor()
-{
-    ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
-    ImGui::SetNextWindowBgAlpha(0.9f); // Semi-transparent
-
-    ImGui::Begin("Shader Editor", nullptr, ImGuiWindowFlags_NoCollapse);
-
-    // Render the text editor
-    //shaderEditor.Render("GLSL Editor");
-
-    // Buttons for Save/Load
-    if (ImGui::Button("Save"))
-    {
-        saveShaderToFile("shader.glsl");
-    }
-    ImGui::SameLine();
-    if (ImGui::Button("Load")) 
-    {
-        loadShaderFromFile("shader.glsl");
-    }
-
-    ImGui::End();
-}
-
-void ImGuiManager::saveShaderToFile(const std::string& filename)
-{
-    //std::ofstream out(filename);
-    //if (out.is_open())
-   //     out << shaderEditor.GetText();
-}
-
-void ImGuiManager::loadShaderFromFile(const std::string& filename)
-{
-    //std::ifstream in(filename);
-    //if (in.is_open()) 
-    //{
-      //  std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-      //  shaderEditor.SetText(content);
-    //}
-}
+#include "ImGuiManager.h"
+#include <stdexcept>
+
+
+ImGuiManager::ImGuiManager(SDL_Window* window, VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, VkQueue queue, uint32_t queueFamily, VkRenderPass renderPass)
+    : window(window), instance(instance), device(device) 
+{
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::StyleColorsDark();
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+
+    ImGui_ImplSDL3_InitForVulkan(window);
+
+    // Create Vulkan descriptor pool
+    VkDescriptorPoolSize pool_sizes[] = {
+        { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000 },
+        { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000 }
+    };
+
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
+    pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
+    pool_info.pPoolSizes = pool_sizes;
+
+    if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create Vulkan descriptor pool");
+    }
+
+    ImGui_ImplVulkan_InitInfo init_info = {};
+    init_info.Instance = instance;
+    init_info.PhysicalDevice = physicalDevice;
+    init_info.Device = device;
+    init_info.Queue = queue;
+    init_info.DescriptorPool = descriptorPool;
+    init_info.MinImageCount = 2;
+    init_info.ImageCount = 2;
+    init_info.RenderPass = renderPass;
+
+    ImGui_ImplVulkan_Init(&init_info);
+
+    initTextEditor(); // Initialize shader editor
+
+    initialized = true;
+}
+
+ImGuiManager::~ImGuiManager() 
+{
+    shutdown();
+}
+
+void ImGuiManager::shutdown() 
+{
+    if (!initialized) return;
+    ImGui_ImplVulkan_Shutdown();
+    ImGui_ImplSDL3_Shutdown();
+    ImGui::DestroyContext();
+    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+}
+
+void ImGuiManager::beginFrame() 
+{
+    if (!initialized) return;
+    ImGui_ImplVulkan_NewFrame();
+    ImGui_ImplSDL3_NewFrame();
+    ImGui::NewFrame();
+}
+
+void ImGuiManager::endFrame(VkCommandBuffer commandBuffer) 
+{
+    if (!initialized) return;
+    ImGui::Render();
+    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+}
+
+void ImGuiManager::initTextEditor()
+{
+    //shaderEditor.SetLanguageDefinition(TextEditor::LanguageDefinition::GLSL()); // GLSL syntax
+    //shaderEditor.SetText("#version 450\nvoid main() {}"); // Default shader code
+}
+
+void ImGuiManager::drawShaderEditor()
+{
+    ImGui::SetNextWindowSize(ImVec2(600, 400), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.9f); // Semi-transparent
+
+    ImGui::Begin("Shader Editor", nullptr, ImGuiWindowFlags_NoCollapse);
+
+    // Render the text editor
+    //shaderEditor.Render("GLSL Editor");
+
+    // Buttons for Save/Load
+    if (ImGui::Button("Save"))
+    {
+        saveShaderToFile("shader.glsl");
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Load")) 
+    {
+        loadShaderFromFile("shader.glsl");
+    }
+
+    ImGui::End();
+}
+
+void ImGuiManager::saveShaderToFile(const std::string& filename)
+{
+    //std::ofstream out(filename);
+    //if (out.is_open())
+   //     out << shaderEditor.GetText();
+}
+
+void ImGuiManager::loadShaderFromFile(const std::string& filename)
+{
+    //std::ifstream in(filename);
+    //if (in.is_open()) 
+    //{
+      //  std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+      //  shaderEditor.SetText(content);
+    //}
+}
@@ -0,0 +1,113 @@
+#include "JobSystem.h"
+
+#include <string>
+
+#include "CpuProfiler.h"
+
+void JobSystem::create(uint32_t workerCount)
+{
+    stopping = false;
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+    }
+}
+
+void JobSystem::cleanup()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void JobSystem::dispatch(uint32_t jobCount, const std::function<void(uint32_t, uint32_t)>& job)
+{
+    if (jobCount == 0)
+    {
+        return;
+    }
+
+    // Not worth waking anyone
+    if (workers.empty() || jobCount == 1)
+    {
+        for (uint32_t i = 0; i < jobCount; ++i)
+        {
+            job(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &job;
+        this->jobCount = jobCount;
+        nextJob = 0;
+        finishedJobs = 0;
+        generation++;
+    }
+    wake.notify_all();
+
+    runJobs(job, 0);
+
+    // Workers still inside runJobs could otherwise take jobs of the next batch
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return finishedJobs == jobCount && activeWorkers == 0; });
+    current = nullptr;
+}
+
+void JobSystem::workerLoop(uint32_t thread)
+{
+    PROFILE_THREAD("Job worker " + std::to_string(thread));
+
+    uint64_t seen = 0;
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+        {
+            return;
+        }
+        seen = generation;
+
+        // Woke up after the batch was already finished
+        if (current == nullptr)
+        {
+            continue;
+        }
+
+        const std::function<void(uint32_t, uint32_t)>& job = *current;
+        activeWorkers++;
+        lock.unlock();
+
+        runJobs(job, thread);
+
+        lock.lock();
+        activeWorkers--;
+        lock.unlock();
+        done.notify_all();
+    }
+}
+
+void JobSystem::runJobs(const std::function<void(uint32_t, uint32_t)>& job, uint32_t thread)
+{
+    for (;;)
+    {
+        uint32_t index = nextJob.fetch_add(1);
+        if (index >= jobCount)
+        {
+            return;
+        }
+
+        job(index, thread);
+        finishedJobs.fetch_add(1);
+    }
+}
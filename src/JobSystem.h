@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// A fixed set of worker threads that run batches of jobs.
+// dispatch() blocks, the calling thread takes jobs as well until the batch is done.
+// Thread 0 is always the calling thread, workers are 1..getThreadCount()-1, so per thread
+// data can be indexed without locking.
+class JobSystem
+{
+public:
+    void create(uint32_t workerCount);
+    void cleanup();
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+    // Run job(index, thread) for every index below jobCount
+    void dispatch(uint32_t jobCount, const std::function<void(uint32_t, uint32_t)>& job);
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(uint32_t, uint32_t)>* current = nullptr;
+    uint64_t generation = 0;
+    uint32_t jobCount = 0;
+    uint32_t activeWorkers = 0;
+    bool stopping = false;
+
+    std::atomic<uint32_t> nextJob{ 0 };
+    std::atomic<uint32_t> finishedJobs{ 0 };
+
+    void workerLoop(uint32_t thread);
+    void runJobs(const std::function<void(uint32_t, uint32_t)>& job, uint32_t thread);
+};
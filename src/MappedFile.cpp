@@ -0,0 +1,123 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    mapped = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mapped == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapped != nullptr)
+    {
+        UnmapViewOfFile(mapped);
+        mapped = nullptr;
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != nullptr)
+    {
+        CloseHandle(file);
+        file = nullptr;
+    }
+    size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    mapped = static_cast<const char*>(view);
+    size = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mapped != nullptr)
+    {
+        munmap(const_cast<char*>(mapped), size);
+        mapped = nullptr;
+    }
+    if (file >= 0)
+    {
+        ::close(file);
+        file = -1;
+    }
+    size = 0;
+}
+
+#endif
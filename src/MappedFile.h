@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// A whole file mapped read only into memory, unmapped on close or destruction
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // False when the file is missing, empty or cannot be mapped
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return mapped != nullptr; }
+    const char* getData() const { return mapped; }
+    size_t getSize() const { return size; }
+
+private:
+    const char* mapped = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
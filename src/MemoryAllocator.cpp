@@ -0,0 +1,380 @@
+#include "MemoryAllocator.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <string>
+
+#include "Logger.h"
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+void MemoryAllocator::create(VkDevice device, VkPhysicalDevice physicalDevice)
+{
+    this->device = device;
+
+    // Query once, memory types do not change for the lifetime of the device
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    bufferImageGranularity = std::max<VkDeviceSize>(deviceProperties.limits.bufferImageGranularity, 1);
+    maxAllocationCount = deviceProperties.limits.maxMemoryAllocationCount;
+}
+
+void MemoryAllocator::cleanup()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (allocationCount > 0)
+    {
+        Logger::warning(std::to_string(allocationCount) + " device memory allocations were not freed.");
+    }
+
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+    {
+        for (auto& list : blocks[i])
+        {
+            for (auto& block : list)
+            {
+                destroyBlock(block.get());
+            }
+            list.clear();
+        }
+    }
+
+    for (LinearPool& pool : linearPools)
+    {
+        for (auto& block : pool.blocks)
+        {
+            destroyBlock(block.get());
+        }
+    }
+    linearPools.clear();
+
+    allocationCount = 0;
+    dedicatedCount = 0;
+    dedicatedBytes = 0;
+    device = VK_NULL_HANDLE;
+}
+
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType type)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Try every suitable memory type, a heap may be full while another still fits
+    Allocation allocation;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((requirements.memoryTypeBits & (1u << i)) &&
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            if (allocateFromType(i, requirements, type, allocation))
+            {
+                ++allocationCount;
+                return allocation;
+            }
+        }
+    }
+
+    throw std::runtime_error("Failed to allocate device memory!");
+}
+
+void MemoryAllocator::free(Allocation& allocation)
+{
+    if (allocation.memory == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    MemoryBlock* block = allocation.block;
+    if (block == nullptr)
+    {
+        // dedicated allocation
+        vkFreeMemory(device, allocation.memory, nullptr);
+        --deviceAllocationCount;
+        --dedicatedCount;
+        dedicatedBytes -= allocation.size;
+        --allocationCount;
+    }
+    else if (!block->linear)
+    {
+        block->tlsf.free(allocation.node);
+        --allocationCount;
+
+        // Keep one empty block around per list so a load/unload cycle does not hit the driver each time
+        if (block->tlsf.isEmpty())
+        {
+            auto& list = blocks[block->memoryType][static_cast<int>(block->resourceType)];
+            bool otherEmpty = std::any_of(list.begin(), list.end(),
+                [block](const std::unique_ptr<MemoryBlock>& other) { return other.get() != block && other->tlsf.isEmpty(); });
+            if (otherEmpty)
+            {
+                destroyBlock(block);
+                list.erase(std::find_if(list.begin(), list.end(),
+                    [block](const std::unique_ptr<MemoryBlock>& other) { return other.get() == block; }));
+            }
+        }
+    }
+
+    allocation = Allocation{};
+}
+
+uint32_t MemoryAllocator::createLinearPool(VkDeviceSize blockSize)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    LinearPool pool;
+    pool.blockSize = blockSize;
+    linearPools.push_back(std::move(pool));
+    return static_cast<uint32_t>(linearPools.size() - 1);
+}
+
+Allocation MemoryAllocator::allocateLinear(uint32_t pool, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    LinearPool& linearPool = linearPools[pool];
+
+    // Buffers and images may share a linear block, so respect the granularity between them
+    VkDeviceSize alignment = std::max(requirements.alignment, bufferImageGranularity);
+
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if (!(requirements.memoryTypeBits & (1u << i)) ||
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) != properties)
+        {
+            continue;
+        }
+
+        MemoryBlock* target = nullptr;
+        for (auto& block : linearPool.blocks)
+        {
+            if (block->memoryType == i && alignUp(block->linearHead, alignment) + requirements.size <= block->size)
+            {
+                target = block.get();
+                break;
+            }
+        }
+
+        if (target == nullptr)
+        {
+            target = createBlock(i, std::max(linearPool.blockSize, requirements.size), ResourceType::Buffer);
+            if (target == nullptr)
+            {
+                continue;
+            }
+            target->linear = true;
+            linearPool.blocks.emplace_back(target);
+        }
+
+        Allocation allocation;
+        allocation.memory = target->memory;
+        allocation.offset = alignUp(target->linearHead, alignment);
+        allocation.size = requirements.size;
+        allocation.mapped = target->mapped ? static_cast<char*>(target->mapped) + allocation.offset : nullptr;
+        allocation.block = target;
+        target->linearHead = allocation.offset + requirements.size;
+        return allocation;
+    }
+
+    throw std::runtime_error("Failed to allocate linear device memory!");
+}
+
+void MemoryAllocator::resetLinearPool(uint32_t pool)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto& block : linearPools[pool].blocks)
+    {
+        block->linearHead = 0;
+    }
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type!");
+}
+
+MemoryStats MemoryAllocator::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    MemoryStats stats;
+    for (uint32_t i = 0; i < VK_MAX_MEMORY_TYPES; ++i)
+    {
+        for (auto& list : blocks[i])
+        {
+            for (auto& block : list)
+            {
+                stats.blockBytes += block->size;
+                stats.usedBytes += block->size - block->tlsf.getFreeSize();
+                ++stats.blockCount;
+            }
+        }
+    }
+    for (const LinearPool& pool : linearPools)
+    {
+        for (auto& block : pool.blocks)
+        {
+            stats.blockBytes += block->size;
+            stats.usedBytes += block->linearHead;
+            ++stats.blockCount;
+        }
+    }
+
+    stats.blockBytes += dedicatedBytes;
+    stats.usedBytes += dedicatedBytes;
+    stats.allocationCount = allocationCount;
+    stats.dedicatedCount = dedicatedCount;
+    return stats;
+}
+
+VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryType) const
+{
+    // Small heaps (like the host visible device local BAR window) get smaller blocks
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    if (heapSize < 1024ull * 1024 * 1024)
+    {
+        return std::min(DEFAULT_MEMORY_BLOCK_SIZE, alignUp(heapSize / 8, 1024 * 1024));
+    }
+    return DEFAULT_MEMORY_BLOCK_SIZE;
+}
+
+bool MemoryAllocator::allocateFromType(uint32_t memoryType, const VkMemoryRequirements& requirements, ResourceType type, Allocation& allocation)
+{
+    VkDeviceSize blockSize = getBlockSize(memoryType);
+
+    // Large resources would waste most of a block, give them their own memory
+    if (requirements.size > blockSize / 2)
+    {
+        VkDeviceMemory memory = allocateDeviceMemory(memoryType, requirements.size);
+        if (memory == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+
+        allocation.memory = memory;
+        allocation.offset = 0;
+        allocation.size = requirements.size;
+        if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &allocation.mapped);
+        }
+
+        ++dedicatedCount;
+        dedicatedBytes += requirements.size;
+        return true;
+    }
+
+    auto& list = blocks[memoryType][static_cast<int>(type)];
+
+    MemoryBlock* target = nullptr;
+    uint64_t offset = 0;
+    uint32_t node = TlsfAllocator::INVALID_NODE;
+    for (auto& block : list)
+    {
+        node = block->tlsf.allocate(requirements.size, requirements.alignment, offset);
+        if (node != TlsfAllocator::INVALID_NODE)
+        {
+            target = block.get();
+            break;
+        }
+    }
+
+    if (target == nullptr)
+    {
+        target = createBlock(memoryType, blockSize, type);
+        if (target == nullptr)
+        {
+            return false;
+        }
+        list.emplace_back(target);
+
+        node = target->tlsf.allocate(requirements.size, requirements.alignment, offset);
+        if (node == TlsfAllocator::INVALID_NODE)
+        {
+            return false;
+        }
+    }
+
+    allocation.memory = target->memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = target->mapped ? static_cast<char*>(target->mapped) + offset : nullptr;
+    allocation.block = target;
+    allocation.node = node;
+    return true;
+}
+
+MemoryBlock* MemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, ResourceType type)
+{
+    VkDeviceMemory memory = allocateDeviceMemory(memoryType, size);
+    if (memory == VK_NULL_HANDLE)
+    {
+        return nullptr;
+    }
+
+    MemoryBlock* block = new MemoryBlock();
+    block->memory = memory;
+    block->size = size;
+    block->memoryType = memoryType;
+    block->resourceType = type;
+    block->tlsf.init(size);
+
+    // Host visible blocks stay mapped, allocations just offset into the mapping
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to map memory block!");
+        }
+    }
+
+    return block;
+}
+
+void MemoryAllocator::destroyBlock(MemoryBlock* block)
+{
+    // freeing the memory also unmaps it
+    vkFreeMemory(device, block->memory, nullptr);
+    block->memory = VK_NULL_HANDLE;
+    --deviceAllocationCount;
+}
+
+VkDeviceMemory MemoryAllocator::allocateDeviceMemory(uint32_t memoryType, VkDeviceSize size)
+{
+    if (deviceAllocationCount >= maxAllocationCount)
+    {
+        Logger::error("Reached maxMemoryAllocationCount (" + std::to_string(maxAllocationCount) + ")!");
+        return VK_NULL_HANDLE;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(device, &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS)
+    {
+        // out of memory in this heap, the caller may try another memory type
+        return VK_NULL_HANDLE;
+    }
+
+    ++deviceAllocationCount;
+    return memory;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "TlsfAllocator.h"
+
+// Size of the device memory blocks sub-allocations are carved from
+const VkDeviceSize DEFAULT_MEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+const uint32_t INVALID_LINEAR_POOL = UINT32_MAX;
+
+// Buffers and optimal tiling images live in separate blocks,
+// so bufferImageGranularity never has to be respected inside a block.
+enum class ResourceType
+{
+    Buffer,
+    Image
+};
+
+// One vkAllocateMemory, shared by many resources
+struct MemoryBlock
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    uint32_t memoryType = 0;
+    ResourceType resourceType = ResourceType::Buffer;
+    void* mapped = nullptr;         // persistently mapped when the memory type is host visible
+
+    TlsfAllocator tlsf;             // sub-allocation for general blocks
+    bool linear = false;            // linear pool block, bump allocated and reset as a whole
+    VkDeviceSize linearHead = 0;
+};
+
+// A range of device memory handed out by the MemoryAllocator
+struct Allocation
+{
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;         // host pointer to offset, only for host visible memory
+
+    MemoryBlock* block = nullptr;   // null for dedicated allocations
+    uint32_t node = TlsfAllocator::INVALID_NODE;
+};
+
+struct MemoryStats
+{
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize usedBytes = 0;
+    uint32_t blockCount = 0;
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedCount = 0;
+};
+
+// Pools device memory in large blocks per memory type and sub-allocates resources from them,
+// keeping the number of vkAllocateMemory calls far below maxMemoryAllocationCount.
+class MemoryAllocator
+{
+public:
+    void create(VkDevice device, VkPhysicalDevice physicalDevice);
+    void cleanup();
+
+    Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, ResourceType type);
+    void free(Allocation& allocation);
+
+    // Linear pools bump allocate and release everything at once on reset,
+    // for resources that share a lifetime. Freeing a single linear allocation is a no-op.
+    uint32_t createLinearPool(VkDeviceSize blockSize);
+    Allocation allocateLinear(uint32_t pool, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+    void resetLinearPool(uint32_t pool);
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+    MemoryStats getStats() const;
+
+private:
+    struct LinearPool
+    {
+        VkDeviceSize blockSize = 0;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    VkDeviceSize bufferImageGranularity = 1;
+    uint32_t maxAllocationCount = 0;
+    uint32_t deviceAllocationCount = 0;
+
+    // general blocks for every memory type, buffers and images apart
+    std::vector<std::unique_ptr<MemoryBlock>> blocks[VK_MAX_MEMORY_TYPES][2];
+    std::vector<LinearPool> linearPools;
+
+    uint32_t allocationCount = 0;
+    uint32_t dedicatedCount = 0;
+    VkDeviceSize dedicatedBytes = 0;
+
+    mutable std::mutex mutex;
+
+    VkDeviceSize getBlockSize(uint32_t memoryType) const;
+    bool allocateFromType(uint32_t memoryType, const VkMemoryRequirements& requirements, ResourceType type, Allocation& allocation);
+    MemoryBlock* createBlock(uint32_t memoryType, VkDeviceSize size, ResourceType type);
+    void destroyBlock(MemoryBlock* block);
+    VkDeviceMemory allocateDeviceMemory(uint32_t memoryType, VkDeviceSize size);
+};
@@ -1,102 +1,69 @@
-#include "Mesh.h"
-
-#include "Renderer.h"
-#include "Utils.h"
-
-Mesh::Mesh(Device* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const int textureId)
-    : device(device), vertexBuffer(VK_NULL_HANDLE), vertexBufferMemory(VK_NULL_HANDLE),
-    indexBuffer(VK_NULL_HANDLE), indexBufferMemory(VK_NULL_HANDLE), indexCount(indices.size()), vertexCount(vertices.size()), textId(textureId) {
-    createVertexBuffer(vertices);
-    createIndexBuffer(indices);
-    
-    model.model = glm::mat4(1.0f);
-    //texture = renderer->getTexture(texturePath);
-}
-
-Mesh::~Mesh() 
-{
-}
-
-void Mesh::destroyBuffers()
-{
-    if (device)
-    {
-        vkDestroyBuffer(device->getLogicalDevice(), vertexBuffer, nullptr);
-        vkFreeMemory(device->getLogicalDevice(), vertexBufferMemory, nullptr);
-        vkDestroyBuffer(device->getLogicalDevice(), indexBuffer, nullptr);
-        vkFreeMemory(device->getLogicalDevice(), indexBufferMemory, nullptr);
-    }
-}
-
-void Mesh::setModelTransform(glm::mat4 transform)
-{
-    model.model = transform;
-}
-
-Model Mesh::getModel()
-{
-    return model;
-}
-
-void Mesh::createVertexBuffer(const std::vector<Vertex>& vertices) 
-{
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, vertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-    createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBuffer, vertexBufferMemory);
-
-    device->copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-
-    vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
-}
-
-void Mesh::createIndexBuffer(const std::vector<uint32_t>& indices) 
-{
-    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, indices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-    createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), bufferSize,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer, indexBufferMemory);
-
-    device->copyBuffer(stagingBuffer, indexBuffer, bufferSize);
-
-    vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
-}
-
-// Bind the vertex and index buffers to the command buffer.
-void Mesh::bind(VkCommandBuffer commandBuffer)
-{
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-}
-
-void Mesh::draw(VkCommandBuffer commandBuffer) 
-{
-    vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
-}
+#include "Mesh.h"
+
+#include "Renderer.h"
+#include "Utils.h"
+#include "MeshCache.h"
+
+Mesh::Mesh(Device* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const int textureId)
+    : Mesh(device, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), textureId) {
+    //texture = renderer->getTexture(texturePath);
+}
+
+Mesh::Mesh(Device* device, const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const int textureId)
+    : device(device), textId(textureId) {
+    bounds = MeshCache::computeBounds(vertices, vertexCount);
+
+    // Quantized against the bounds, the arena only holds the packed format
+    std::vector<GpuVertex> packed(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        packed[i] = GpuVertex::pack(vertices[i], bounds);
+    }
+    dequantization = GpuVertex::getDequantization(bounds);
+
+    // 16 bit indices whenever every vertex can be addressed with them
+    if (vertexCount <= MAX_INDEX16_VERTEX_COUNT)
+    {
+        std::vector<uint16_t> narrowed(indices, indices + indexCount);
+        geometry = device->getGeometryArena().allocate(packed.data(), vertexCount, narrowed.data(), indexCount);
+    }
+    else
+    {
+        geometry = device->getGeometryArena().allocate(packed.data(), vertexCount, indices, indexCount);
+    }
+
+    model.model = glm::mat4(1.0f);
+}
+
+Mesh::~Mesh() 
+{
+}
+
+void Mesh::destroyBuffers()
+{
+    if (device && geometry != GeometryArena::INVALID_HANDLE)
+    {
+        device->getGeometryArena().free(geometry);
+        geometry = GeometryArena::INVALID_HANDLE;
+    }
+}
+
+void Mesh::setModelTransform(glm::mat4 transform)
+{
+    model.model = transform;
+}
+
+Model Mesh::getModel()
+{
+    return model;
+}
+
+void Mesh::draw(VkCommandBuffer commandBuffer, VkIndexType& boundIndexType, uint32_t instanceCount, uint32_t firstInstance)
+{
+    device->getGeometryArena().draw(commandBuffer, geometry, boundIndexType, instanceCount, firstInstance);
+}
+
+GeometryRange Mesh::getGeometryRange() const
+{
+    return device->getGeometryArena().getRange(geometry);
+}
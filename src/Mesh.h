@@ -1,52 +1,60 @@
-#pragma once
-
-#include <vulkan/vulkan.h>
-#include <vector>
-#include <glm/glm.hpp>
-
-#include "Device.h"
-#include "Vertex.h"
-
-class Renderer;
-struct Texture;
-
-struct Model {
-    glm::mat4 model;
-};
-
-
-class Mesh {
-public:
-    Mesh(Device* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const int textureId);
-    ~Mesh();
-
-    void destroyBuffers();
-
-    void setModelTransform(glm::mat4 transform);
-    Model getModel();
-
-    void bind(VkCommandBuffer commandBuffer);
-    void draw(VkCommandBuffer commandBuffer);
-
-    int getTextId() { return textId; }
-    //Texture* getTexture() { return texture; }
-
-private:
-    void createVertexBuffer(const std::vector<Vertex>& vertices);
-    void createIndexBuffer(const std::vector<uint32_t>& indices);
-
-    Device* device;
-
-    Model model;
-
-    uint32_t vertexCount;
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMemory;
-
-    VkBuffer indexBuffer;
-    VkDeviceMemory indexBufferMemory;
-    uint32_t indexCount;
-
-    int textId;
-    //Texture* texture;
-};
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Device.h"
+#include "Vertex.h"
+#include "SceneGraph.h"
+
+class Renderer;
+struct Texture;
+
+struct Model {
+    glm::mat4 model;
+};
+
+
+class Mesh {
+public:
+    Mesh(Device* device, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const int textureId);
+    // Geometry that is not in vectors, e.g. a mapped mesh cache
+    Mesh(Device* device, const Vertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, const int textureId);
+    ~Mesh();
+
+    void destroyBuffers();
+
+    void setModelTransform(glm::mat4 transform);
+    Model getModel();
+
+    // Draw from the geometry arena, which the frame binds once
+    void draw(VkCommandBuffer commandBuffer, VkIndexType& boundIndexType, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+    GeometryRange getGeometryRange() const;
+    const MeshBounds& getBounds() const { return bounds; }
+
+    // Maps the packed GpuVertex positions back to model space, applied before the model matrix
+    const glm::mat4& getDequantization() const { return dequantization; }
+
+    int getTextId() { return textId; }
+
+    // Scene graph node whose world transform the mesh is drawn with
+    void setSceneNode(uint32_t node) { sceneNode = node; }
+    uint32_t getSceneNode() const { return sceneNode; }
+    //Texture* getTexture() { return texture; }
+
+private:
+    Device* device;
+
+    Model model;
+
+    // Vertices and indices live in the device's geometry arena
+    uint32_t geometry = GeometryArena::INVALID_HANDLE;
+    MeshBounds bounds;
+    glm::mat4 dequantization = glm::mat4(1.0f);
+    uint32_t sceneNode = SceneGraph::INVALID_NODE;
+
+    int textId;
+    //Texture* texture;
+};
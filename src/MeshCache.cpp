@@ -0,0 +1,391 @@
+#include "MeshCache.h"
+
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <functional>
+
+#include "Logger.h"
+#include "CpuProfiler.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+    const uint32_t MESH_CACHE_MAGIC = 0x434d5656;   // "VVMC"
+    const uint64_t DATA_ALIGNMENT = 16;
+
+    // File layout: header, one entry per mesh, material names (length + characters), nodes,
+    // then the vertex and index arrays at the offsets given by the entries
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t importFlags;
+        uint32_t vertexSize;
+        uint32_t meshCount;
+        uint32_t materialCount;
+        uint32_t nodeCount;
+        uint32_t padding;
+    };
+
+    struct FileEntry
+    {
+        uint32_t materialIndex;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t node;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        float boundsMin[3];
+        float boundsMax[3];
+        float boundsRadius;
+        uint32_t padding;
+    };
+
+    struct FileNode
+    {
+        int32_t parent;
+        float transform[16];        // column major
+    };
+
+    // FNV-1a
+    uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t alignUp(uint64_t value)
+    {
+        return (value + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+}
+
+bool MeshCache::open(const std::string& sourcePath)
+{
+    PROFILE_ZONE("MeshCache::open");
+
+    close();
+
+    uint64_t sourceHash = hashSource(sourcePath);
+    if (sourceHash == 0 || !file.open(getCachePath(sourcePath, sourceHash)))
+    {
+        return false;
+    }
+
+    if (!parse(sourceHash))
+    {
+        Logger::warning("Ignoring invalid mesh cache for " + sourcePath);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::close()
+{
+    file.close();
+    materialTextures.clear();
+    meshes.clear();
+    nodes.clear();
+}
+
+bool MeshCache::parse(uint64_t sourceHash)
+{
+    const char* data = file.getData();
+    uint64_t size = file.getSize();
+
+    if (size < sizeof(FileHeader))
+    {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != MESH_CACHE_MAGIC || header.version != MESH_CACHE_VERSION ||
+        header.sourceHash != sourceHash || header.importFlags != MESH_IMPORT_FLAGS ||
+        header.vertexSize != sizeof(Vertex))
+    {
+        return false;
+    }
+
+    uint64_t offset = sizeof(FileHeader);
+    if (offset + uint64_t(header.meshCount) * sizeof(FileEntry) > size)
+    {
+        return false;
+    }
+    const char* entries = data + offset;
+    offset += uint64_t(header.meshCount) * sizeof(FileEntry);
+
+    for (uint32_t i = 0; i < header.materialCount; ++i)
+    {
+        uint32_t length;
+        if (offset + sizeof(length) > size)
+        {
+            return false;
+        }
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+
+        if (offset + length > size)
+        {
+            return false;
+        }
+        materialTextures.emplace_back(data + offset, length);
+        offset += length;
+    }
+
+    if (offset + uint64_t(header.nodeCount) * sizeof(FileNode) > size)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.nodeCount; ++i)
+    {
+        FileNode fileNode;
+        std::memcpy(&fileNode, data + offset, sizeof(fileNode));
+        offset += sizeof(fileNode);
+
+        if (fileNode.parent >= static_cast<int32_t>(i))
+        {
+            return false;
+        }
+
+        DecodedNode node;
+        node.parent = fileNode.parent;
+        for (int column = 0; column < 4; ++column)
+        {
+            for (int row = 0; row < 4; ++row)
+            {
+                node.transform[column][row] = fileNode.transform[column * 4 + row];
+            }
+        }
+        nodes.push_back(node);
+    }
+
+    for (uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        FileEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(FileEntry), sizeof(entry));
+
+        if (entry.vertexOffset % DATA_ALIGNMENT != 0 || entry.indexOffset % DATA_ALIGNMENT != 0 ||
+            entry.vertexOffset + uint64_t(entry.vertexCount) * sizeof(Vertex) > size ||
+            entry.indexOffset + uint64_t(entry.indexCount) * sizeof(uint32_t) > size)
+        {
+            return false;
+        }
+
+        MeshView mesh;
+        mesh.vertices = reinterpret_cast<const Vertex*>(data + entry.vertexOffset);
+        mesh.vertexCount = entry.vertexCount;
+        mesh.indices = reinterpret_cast<const uint32_t*>(data + entry.indexOffset);
+        mesh.indexCount = entry.indexCount;
+        mesh.materialIndex = entry.materialIndex;
+        mesh.node = entry.node < header.nodeCount ? entry.node : 0;
+        mesh.bounds.min = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+        mesh.bounds.max = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+        mesh.bounds.radius = entry.boundsRadius;
+        meshes.push_back(mesh);
+    }
+    return true;
+}
+
+void MeshCache::write(const std::string& sourcePath, const std::vector<std::string>& materialTextures,
+                      const std::vector<DecodedNode>& nodes, const std::vector<DecodedMesh>& meshes)
+{
+    PROFILE_ZONE("MeshCache::write");
+
+    uint64_t sourceHash = hashSource(sourcePath);
+    if (sourceHash == 0)
+    {
+        return;
+    }
+
+    FileHeader header{};
+    header.magic = MESH_CACHE_MAGIC;
+    header.version = MESH_CACHE_VERSION;
+    header.sourceHash = sourceHash;
+    header.importFlags = MESH_IMPORT_FLAGS;
+    header.vertexSize = sizeof(Vertex);
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.materialCount = static_cast<uint32_t>(materialTextures.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+
+    uint64_t offset = sizeof(FileHeader) + meshes.size() * sizeof(FileEntry);
+    for (const std::string& texture : materialTextures)
+    {
+        offset += sizeof(uint32_t) + texture.size();
+    }
+    offset += nodes.size() * sizeof(FileNode);
+
+    std::vector<FileEntry> entries(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const DecodedMesh& mesh = meshes[i];
+        FileEntry& entry = entries[i];
+        entry = FileEntry{};
+        entry.materialIndex = mesh.materialIndex;
+        entry.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        entry.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        entry.node = mesh.node;
+
+        entry.vertexOffset = alignUp(offset);
+        offset = entry.vertexOffset + mesh.vertices.size() * sizeof(Vertex);
+        entry.indexOffset = alignUp(offset);
+        offset = entry.indexOffset + mesh.indices.size() * sizeof(uint32_t);
+
+        MeshBounds bounds = computeBounds(mesh.vertices.data(), entry.vertexCount);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            entry.boundsMin[axis] = bounds.min[axis];
+            entry.boundsMax[axis] = bounds.max[axis];
+        }
+        entry.boundsRadius = bounds.radius;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(MESH_CACHE_DIRECTORY, error);
+
+    // Written under a temporary name and renamed, a reader never maps a partial file.
+    // The name is unique to the write, workers importing the same source each rename a complete file
+    static std::atomic<uint32_t> writeCount{ 0 };
+    std::string cachePath = getCachePath(sourcePath, sourceHash);
+    std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+        "." + std::to_string(writeCount.fetch_add(1)) + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            Logger::warning("Failed to write mesh cache " + cachePath);
+            return;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(FileEntry));
+        for (const std::string& texture : materialTextures)
+        {
+            uint32_t length = static_cast<uint32_t>(texture.size());
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(texture.data(), length);
+        }
+        for (const DecodedNode& node : nodes)
+        {
+            FileNode fileNode;
+            fileNode.parent = node.parent;
+            for (int column = 0; column < 4; ++column)
+            {
+                for (int row = 0; row < 4; ++row)
+                {
+                    fileNode.transform[column * 4 + row] = node.transform[column][row];
+                }
+            }
+            out.write(reinterpret_cast<const char*>(&fileNode), sizeof(fileNode));
+        }
+
+        const char zeros[DATA_ALIGNMENT] = {};
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            uint64_t position = static_cast<uint64_t>(out.tellp());
+            out.write(zeros, entries[i].vertexOffset - position);
+            out.write(reinterpret_cast<const char*>(meshes[i].vertices.data()), meshes[i].vertices.size() * sizeof(Vertex));
+
+            position = static_cast<uint64_t>(out.tellp());
+            out.write(zeros, entries[i].indexOffset - position);
+            out.write(reinterpret_cast<const char*>(meshes[i].indices.data()), meshes[i].indices.size() * sizeof(uint32_t));
+        }
+
+        if (!out)
+        {
+            Logger::warning("Failed to write mesh cache " + cachePath);
+            out.close();
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::vector<MeshView> MeshCache::view(const std::vector<DecodedMesh>& meshes)
+{
+    std::vector<MeshView> views;
+    views.reserve(meshes.size());
+    for (const DecodedMesh& mesh : meshes)
+    {
+        MeshView view;
+        view.vertices = mesh.vertices.data();
+        view.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        view.indices = mesh.indices.data();
+        view.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        view.materialIndex = mesh.materialIndex;
+        view.node = mesh.node;
+        view.bounds = computeBounds(view.vertices, view.vertexCount);
+        views.push_back(view);
+    }
+    return views;
+}
+
+MeshBounds MeshCache::computeBounds(const Vertex* vertices, uint32_t vertexCount)
+{
+    MeshBounds bounds;
+    if (vertexCount == 0)
+    {
+        return bounds;
+    }
+
+    bounds.min = bounds.max = vertices[0].position;
+    for (uint32_t i = 1; i < vertexCount; ++i)
+    {
+        bounds.min = glm::min(bounds.min, vertices[i].position);
+        bounds.max = glm::max(bounds.max, vertices[i].position);
+    }
+
+    // The sphere shares the center of the box, usually tighter than half its diagonal
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        glm::vec3 offset = vertices[i].position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+uint64_t MeshCache::hashSource(const std::string& sourcePath)
+{
+    MappedFile source;
+    if (!source.open(sourcePath))
+    {
+        return 0;
+    }
+
+    uint64_t hash = hashBytes(source.getData(), source.getSize());
+    hash = hashBytes(&MESH_IMPORT_FLAGS, sizeof(MESH_IMPORT_FLAGS), hash);
+    hash = hashBytes(&MESH_OPTIMIZATION_ENABLED, sizeof(MESH_OPTIMIZATION_ENABLED), hash);
+    hash = hashBytes(&MESH_SPLIT_FOR_INDEX16, sizeof(MESH_SPLIT_FOR_INDEX16), hash);
+    uint32_t vertexSize = sizeof(Vertex);
+    hash = hashBytes(&vertexSize, sizeof(vertexSize), hash);
+    return hashBytes(&MESH_CACHE_VERSION, sizeof(MESH_CACHE_VERSION), hash);
+}
+
+std::string MeshCache::getCachePath(const std::string& sourcePath, uint64_t sourceHash)
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(sourceHash));
+    return std::string(MESH_CACHE_DIRECTORY) + std::filesystem::path(sourcePath).filename().string() + "." + hash + ".mesh";
+}
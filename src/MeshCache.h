@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "MeshModel.h"
+#include "MappedFile.h"
+
+// Bump whenever the file layout, the Vertex layout or the import changes
+const uint32_t MESH_CACHE_VERSION = 4;
+
+// Where imported models are cached, relative to the working directory
+const char* const MESH_CACHE_DIRECTORY = "cache/";
+
+// Geometry of one mesh without owning it, either a DecodedMesh or a range of a mapped cache file
+struct MeshView
+{
+    const Vertex* vertices = nullptr;
+    uint32_t vertexCount = 0;
+    const uint32_t* indices = nullptr;
+    uint32_t indexCount = 0;
+    uint32_t materialIndex = 0;
+    uint32_t node = 0;
+    MeshBounds bounds;
+};
+
+// Post import geometry of a model file, so Assimp only runs the first time a file is seen.
+// Entries are keyed by a hash of the source file, the import flags, whether meshes are
+// optimized or split and MESH_CACHE_VERSION.
+// Material files referenced by the source are not part of the key, the cache directory can
+// simply be deleted after editing them.
+// An open cache maps the whole file, its views point into the mapping and are copied straight
+// into the staging ring by the uploads.
+class MeshCache
+{
+public:
+    // Map the entry of sourcePath, false when there is none or it does not match
+    bool open(const std::string& sourcePath);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+
+    // Diffuse texture per material, empty without one
+    const std::vector<std::string>& getMaterialTextures() const { return materialTextures; }
+    const std::vector<MeshView>& getMeshes() const { return meshes; }
+    const std::vector<DecodedNode>& getNodes() const { return nodes; }
+
+    // Store an import, failures only log a warning since the cache is optional
+    static void write(const std::string& sourcePath, const std::vector<std::string>& materialTextures,
+                      const std::vector<DecodedNode>& nodes, const std::vector<DecodedMesh>& meshes);
+
+    static std::vector<MeshView> view(const std::vector<DecodedMesh>& meshes);
+    static MeshBounds computeBounds(const Vertex* vertices, uint32_t vertexCount);
+
+private:
+    MappedFile file;
+    std::vector<std::string> materialTextures;
+    std::vector<MeshView> meshes;
+    std::vector<DecodedNode> nodes;
+
+    bool parse(uint64_t sourceHash);
+
+    // 0 when the source cannot be read
+    static uint64_t hashSource(const std::string& sourcePath);
+    static std::string getCachePath(const std::string& sourcePath, uint64_t sourceHash);
+};
@@ -1,133 +1,224 @@
-#include "MeshModel.h"
-
-
-MeshModel::MeshModel()
-{
-
-	model.model = glm::mat4(1.0f);
-}
-
-MeshModel::MeshModel(std::vector<Mesh> newMeshList)
-{
-	meshList = newMeshList;
-	model.model = glm::mat4(1.0f);
-}
-
-size_t MeshModel::getMeshCount()
-{
-	return meshList.size();
-}
-
-Mesh* MeshModel::getMesh(size_t index)
-{
-	if (index >= meshList.size())
-	{
-		throw std::runtime_error("Attempted to access invalid mesh index!");
-	}
-
-	return &meshList[index];
-}
-
-Model MeshModel::getModel()
-{
-	return model;
-}
-
-void MeshModel::setModel(glm::mat4 m)
-{
-	model.model = m;
-}
-
-void MeshModel::destroyMeshModel()
-{
-	for (auto& mesh : meshList)
-	{
-		mesh.destroyBuffers();
-	}
-}
-
-std::vector<std::string> MeshModel::loadMaterials(const aiScene* scene)
-{
-	std::vector<std::string> textures(scene->mNumMaterials);
-
-	for (size_t i = 0; i < scene->mNumMaterials; ++i)
-	{
-		aiMaterial* material = scene->mMaterials[i];
-		textures[i] = "";
-
-		// check for a diffuse texture and save fileName
-		if (material->GetTextureCount(aiTextureType_DIFFUSE))
-		{
-			aiString path;
-			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
-			{
-				int idx = std::string(path.data).rfind("\\");
-				std::string fileName = std::string(path.data).substr(idx + 1);
-
-				textures[i] = fileName;
-			}
-		}
-	}
-
-	return textures;
-}
-
-std::vector<Mesh> MeshModel::LoadNode(Device* device, aiNode* node, const aiScene* scene, std::vector<int> matToTex)
-{
-	std::vector<Mesh> meshList;
-
-	for(size_t i = 0; i< node->mNumMeshes; ++i)
-	{
-		meshList.push_back( 
-							loadMesh(device,
-									scene->mMeshes[node->mMeshes[i]], 
-									scene, 
-									matToTex)
-							);
-	}
-
-	for (size_t i = 0; i < node->mNumChildren; ++i)
-	{
-		std::vector<Mesh> newList = LoadNode(device, node->mChildren[i], scene, matToTex);
-		meshList.insert(meshList.end(), newList.begin(), newList.end());
-	}
-	return meshList;
-}
-
-Mesh MeshModel::loadMesh(Device* device, aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex)
-{
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-
-	vertices.resize(mesh->mNumVertices);
-	for (size_t i = 0; i < mesh->mNumVertices; ++i)
-	{
-		vertices[i].position = { mesh->mVertices[i].x, mesh->mVertices[i].y , mesh->mVertices[i].z };
-		
-		if (mesh->mTextureCoords[0])
-		{
-			vertices[i].texCoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
-		}
-		else {
-			vertices[i].texCoord = { 0.0f, 0.0f };
-		}
-
-		vertices[i].color = { 1.0f, 1.0f, 1.0f };
-	}
-
-	for (size_t i = 0; i < mesh->mNumFaces; ++i)
-	{
-		aiFace face = mesh->mFaces[i];
-		for (size_t j = 0; j < face.mNumIndices; ++j)
-		{
-			indices.push_back(face.mIndices[j]);
-		}
-	}
-
-	Mesh newMesh = Mesh(device, vertices, indices, matToTex[mesh->mMaterialIndex]);
-	return newMesh;
-}
-
-MeshModel::~MeshModel()
-{
-}
+#include "MeshModel.h"
+
+#include <cmath>
+
+
+MeshModel::MeshModel()
+{
+
+	model.model = glm::mat4(1.0f);
+}
+
+MeshModel::MeshModel(std::vector<Mesh> newMeshList)
+{
+	meshList = newMeshList;
+	model.model = glm::mat4(1.0f);
+}
+
+size_t MeshModel::getMeshCount()
+{
+	return meshList.size();
+}
+
+Mesh* MeshModel::getMesh(size_t index)
+{
+	if (index >= meshList.size())
+	{
+		throw std::runtime_error("Attempted to access invalid mesh index!");
+	}
+
+	return &meshList[index];
+}
+
+Model MeshModel::getModel()
+{
+	return model;
+}
+
+void MeshModel::setModel(glm::mat4 m)
+{
+	model.model = m;
+	revision++;
+}
+
+void MeshModel::replaceMeshes(std::vector<Mesh> newMeshList)
+{
+	destroyMeshModel();
+	meshList = newMeshList;
+	revision++;
+}
+
+void MeshModel::setSceneNodes(uint32_t root, uint32_t content)
+{
+	sceneNode = root;
+	contentNode = content;
+	revision++;
+}
+
+void MeshModel::setStatic(bool isStatic)
+{
+	staticModel = isStatic;
+	revision++;
+}
+
+uint32_t MeshModel::addInstance(const glm::mat4& transform)
+{
+	instances.push_back({ transform });
+	revision++;
+	return static_cast<uint32_t>(instances.size() - 1);
+}
+
+void MeshModel::setInstanceTransform(uint32_t instance, const glm::mat4& transform)
+{
+	if (instance >= instances.size())
+	{
+		throw std::runtime_error("Attempted to access invalid instance index!");
+	}
+
+	instances[instance].transform = transform;
+	revision++;
+}
+
+void MeshModel::removeInstance(uint32_t instance)
+{
+	if (instance >= instances.size())
+	{
+		throw std::runtime_error("Attempted to access invalid instance index!");
+	}
+
+	instances[instance] = instances.back();
+	instances.pop_back();
+	revision++;
+}
+
+void MeshModel::clearInstances()
+{
+	instances.clear();
+	revision++;
+}
+
+void MeshModel::destroyMeshModel()
+{
+	for (auto& mesh : meshList)
+	{
+		mesh.destroyBuffers();
+	}
+}
+
+std::vector<std::string> MeshModel::loadMaterials(const aiScene* scene)
+{
+	std::vector<std::string> textures(scene->mNumMaterials);
+
+	for (size_t i = 0; i < scene->mNumMaterials; ++i)
+	{
+		aiMaterial* material = scene->mMaterials[i];
+		textures[i] = "";
+
+		// check for a diffuse texture and save fileName
+		if (material->GetTextureCount(aiTextureType_DIFFUSE))
+		{
+			aiString path;
+			if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == AI_SUCCESS)
+			{
+				int idx = std::string(path.data).rfind("\\");
+				std::string fileName = std::string(path.data).substr(idx + 1);
+
+				textures[i] = fileName;
+			}
+		}
+	}
+
+	return textures;
+}
+
+void MeshModel::decodeNode(aiNode* node, const aiScene* scene, std::vector<DecodedMesh>& meshes,
+	std::vector<DecodedNode>& nodes, int32_t parent)
+{
+	// Assimp matrices are row major
+	const aiMatrix4x4& m = node->mTransformation;
+	DecodedNode decoded;
+	decoded.parent = parent;
+	decoded.transform = glm::mat4(
+		m.a1, m.b1, m.c1, m.d1,
+		m.a2, m.b2, m.c2, m.d2,
+		m.a3, m.b3, m.c3, m.d3,
+		m.a4, m.b4, m.c4, m.d4);
+	uint32_t index = static_cast<uint32_t>(nodes.size());
+	nodes.push_back(decoded);
+
+	for (size_t i = 0; i < node->mNumMeshes; ++i)
+	{
+		meshes.push_back(decodeMesh(scene->mMeshes[node->mMeshes[i]]));
+		meshes.back().node = index;
+	}
+
+	for (size_t i = 0; i < node->mNumChildren; ++i)
+	{
+		decodeNode(node->mChildren[i], scene, meshes, nodes, static_cast<int32_t>(index));
+	}
+}
+
+DecodedMesh MeshModel::decodeMesh(aiMesh* mesh)
+{
+	DecodedMesh decoded;
+	std::vector<Vertex>& vertices = decoded.vertices;
+	std::vector<uint32_t>& indices = decoded.indices;
+	decoded.materialIndex = mesh->mMaterialIndex;
+
+	vertices.resize(mesh->mNumVertices);
+	for (size_t i = 0; i < mesh->mNumVertices; ++i)
+	{
+		vertices[i].position = { mesh->mVertices[i].x, mesh->mVertices[i].y , mesh->mVertices[i].z };
+		
+		if (mesh->mTextureCoords[0])
+		{
+			vertices[i].texCoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+		}
+		else {
+			vertices[i].texCoord = { 0.0f, 0.0f };
+		}
+
+		vertices[i].color = { 1.0f, 1.0f, 1.0f };
+	}
+
+	for (size_t i = 0; i < mesh->mNumFaces; ++i)
+	{
+		aiFace face = mesh->mFaces[i];
+		for (size_t j = 0; j < face.mNumIndices; ++j)
+		{
+			indices.push_back(face.mIndices[j]);
+		}
+	}
+
+	return decoded;
+}
+
+DecodedMesh MeshModel::createBoxMesh(glm::vec3 center, float halfSize)
+{
+	static const glm::vec3 normals[6] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+	static const glm::vec2 corners[4] = { {0, 0}, {1, 0}, {1, 1}, {0, 1} };
+
+	DecodedMesh box;
+	for (const glm::vec3& normal : normals)
+	{
+		glm::vec3 tangent = std::abs(normal.y) > 0.5f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+
+		uint32_t base = static_cast<uint32_t>(box.vertices.size());
+		for (const glm::vec2& corner : corners)
+		{
+			glm::vec2 offset(corner.x * 2.0f - 1.0f, corner.y * 2.0f - 1.0f);
+			Vertex vertex{};
+			vertex.position = center + (normal + tangent * offset.x + bitangent * offset.y) * halfSize;
+			vertex.color = { 1.0f, 1.0f, 1.0f };
+			vertex.texCoord = corner;
+			box.vertices.push_back(vertex);
+		}
+		box.indices.insert(box.indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+	}
+	return box;
+}
+
+MeshModel::~MeshModel()
+{
+}
@@ -1,38 +1,104 @@
-#pragma once
-
-#include <vector>
-
-#include <glm/glm.hpp>
-#include <assimp/scene.h>
-
-#include "Mesh.h"
-#include "Device.h"
-
-class MeshModel
-{
-public:
-	MeshModel();
-	MeshModel(std::vector<Mesh> newMeshList);
-
-	size_t getMeshCount();
-	Mesh* getMesh(size_t index);
-
-	Model getModel();
-	void setModel(glm::mat4 m);
-
-	void destroyMeshModel();
-
-	static std::vector<std::string> loadMaterials(const aiScene* scene);
-	static std::vector<Mesh> LoadNode(Device* device,aiNode* node, const aiScene* scene, std::vector<int> matToTex);
-	static Mesh loadMesh(Device* device, aiMesh* mesh, const aiScene* scene, std::vector<int> matToTex);
-
-	std::vector<std::string> getTextures() { return textures; }
-
-	~MeshModel();
-private:
-	std::vector<Mesh> meshList;
-	Model model;
-
-	std::vector<std::string> textures;
-};
-
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "Mesh.h"
+#include "Device.h"
+#include "SceneGraph.h"
+
+// Post processing of every model import, part of the mesh cache key
+const uint32_t MESH_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices;
+
+// Geometry of one mesh on the CPU, before it is uploaded into the arena
+struct DecodedMesh
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	uint32_t materialIndex = 0;
+	uint32_t node = 0;				// index into the model's nodes
+};
+
+// Node of a model file's hierarchy, listed depth first so parents come before their children
+struct DecodedNode
+{
+	int32_t parent = -1;
+	glm::mat4 transform = glm::mat4(1.0f);		// relative to the parent
+};
+
+// Per instance data of an instanced model, in the std430 layout shader_instanced.vert reads
+struct InstanceData
+{
+	glm::mat4 transform;		// in front of the model's own transform
+};
+
+class MeshModel
+{
+public:
+	MeshModel();
+	MeshModel(std::vector<Mesh> newMeshList);
+
+	size_t getMeshCount();
+	Mesh* getMesh(size_t index);
+
+	Model getModel();
+	void setModel(glm::mat4 m);
+
+	// Swap in new meshes, e.g. once a background load is resident. The old ones are destroyed,
+	// the arena keeps their ranges until the frames drawing them are done
+	void replaceMeshes(std::vector<Mesh> newMeshList);
+
+	// Static models are recorded once into a cached command bundle
+	void setStatic(bool isStatic);
+	bool isStatic() const { return staticModel; }
+
+	// Draw the model once for every instance instead of once, each mesh becomes one instanced draw.
+	// Static instanced models go into the bundles with the instances that passed culling
+	uint32_t addInstance(const glm::mat4& transform);
+	void setInstanceTransform(uint32_t instance, const glm::mat4& transform);
+	// The last instance takes the index of the removed one
+	void removeInstance(uint32_t instance);
+	void clearInstances();
+	uint32_t getInstanceCount() const { return static_cast<uint32_t>(instances.size()); }
+	const std::vector<InstanceData>& getInstances() const { return instances; }
+	bool isInstanced() const { return !instances.empty(); }
+
+	// Changes whenever the transform, the instances or the static flag do
+	uint32_t getRevision() const { return revision; }
+
+	// The model's transform is the local transform of its scene node. The meshes hang off the
+	// content node below it, which is replaced together with them
+	void setSceneNodes(uint32_t root, uint32_t content);
+	uint32_t getSceneNode() const { return sceneNode; }
+	uint32_t getContentNode() const { return contentNode; }
+
+	void destroyMeshModel();
+
+	static std::vector<std::string> loadMaterials(const aiScene* scene);
+
+	// CPU only part of the import, safe to run on any thread
+	static void decodeNode(aiNode* node, const aiScene* scene, std::vector<DecodedMesh>& meshes,
+		std::vector<DecodedNode>& nodes, int32_t parent = -1);
+	static DecodedMesh decodeMesh(aiMesh* mesh);
+
+	// Box with its own vertices per face, used for placeholders
+	static DecodedMesh createBoxMesh(glm::vec3 center, float halfSize);
+
+	std::vector<std::string> getTextures() { return textures; }
+
+	~MeshModel();
+private:
+	std::vector<Mesh> meshList;
+	Model model;
+	bool staticModel = false;
+	uint32_t revision = 0;
+	uint32_t sceneNode = SceneGraph::INVALID_NODE;
+	uint32_t contentNode = SceneGraph::INVALID_NODE;
+	std::vector<InstanceData> instances;
+
+	std::vector<std::string> textures;
+};
+
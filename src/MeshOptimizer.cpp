@@ -0,0 +1,437 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Logger.h"
+#include "CpuProfiler.h"
+
+namespace
+{
+    // Approximate cache used while reordering: a vertex is cached when fewer than cacheSize
+    // vertices were transformed since it was. Advancing the timestamp by more than cacheSize
+    // empties it
+    struct TimestampCache
+    {
+        std::vector<uint32_t> timestamps;
+        uint32_t timestamp;
+        uint32_t size;
+
+        TimestampCache(size_t vertexCount, uint32_t cacheSize)
+            : timestamps(vertexCount, 0), timestamp(cacheSize + 1), size(cacheSize)
+        {
+        }
+
+        bool contains(uint32_t vertex) const { return timestamp - timestamps[vertex] <= size; }
+
+        uint32_t misses(const uint32_t* triangle)
+        {
+            uint32_t count = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                if (!contains(triangle[k]))
+                {
+                    timestamps[triangle[k]] = timestamp++;
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        void flush() { timestamp += size + 1; }
+    };
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3)
+    {
+        return stats;
+    }
+
+    // inserted holds the miss number that put a vertex into the cache, the cache holds the last cacheSize of them
+    std::vector<uint32_t> inserted(vertexCount, 0);
+    uint32_t misses = 0;
+    uint32_t referenced = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t vertex = indices[i];
+        if (inserted[vertex] != 0 && inserted[vertex] + cacheSize > misses)
+        {
+            continue;
+        }
+        referenced += inserted[vertex] == 0 ? 1 : 0;
+        inserted[vertex] = ++misses;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(referenced);
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, std::vector<uint32_t>* clusters, uint32_t cacheSize)
+{
+    if (clusters)
+    {
+        clusters->clear();
+    }
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Triangles around each vertex
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+    {
+        offsets[index + 1]++;
+    }
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // Triangles not emitted yet around each vertex
+    std::vector<uint32_t> live(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+    {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    TimestampCache cache(vertexCount, cacheSize);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    deadEnds.reserve(indices.size());
+    result.reserve(indices.size());
+
+    // Recently used vertices first, they may still be cached, then the next one in input order
+    uint32_t cursor = 0;
+    auto skipDeadEnd = [&]() -> int64_t
+    {
+        while (!deadEnds.empty())
+        {
+            uint32_t vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; ++cursor)
+        {
+            if (live[cursor] > 0)
+            {
+                return cursor;
+            }
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    if (clusters)
+    {
+        clusters->push_back(0);
+    }
+
+    while (fanning >= 0)
+    {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+        {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle])
+            {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            const uint32_t* corners = &indices[triangle * 3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                result.push_back(corners[k]);
+                deadEnds.push_back(corners[k]);
+                candidates.push_back(corners[k]);
+                live[corners[k]]--;
+            }
+            cache.misses(corners);
+        }
+
+        // Continue with the oldest candidate that stays cached while its triangles are emitted
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t vertex : candidates)
+        {
+            if (live[vertex] == 0)
+            {
+                continue;
+            }
+
+            int64_t priority = 0;
+            uint32_t age = cache.timestamp - cache.timestamps[vertex];
+            if (age + 2 * live[vertex] <= cacheSize)
+            {
+                priority = age;
+            }
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0)
+        {
+            // Dead end, the cache is likely cold from here on
+            next = skipDeadEnd();
+            if (next >= 0 && clusters)
+            {
+                clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+            }
+        }
+        fanning = next;
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || clusters.empty())
+    {
+        return;
+    }
+
+    // Split each cluster wherever the ACMR since the last split is back within threshold of the cluster's
+    TimestampCache cache(vertices.size(), cacheSize);
+    std::vector<uint32_t> starts;
+    for (size_t c = 0; c < clusters.size(); ++c)
+    {
+        size_t start = clusters[c];
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        cache.flush();
+        uint32_t clusterMisses = 0;
+        for (size_t t = start; t < end; ++t)
+        {
+            clusterMisses += cache.misses(&indices[t * 3]);
+        }
+        float target = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+        cache.flush();
+        starts.push_back(static_cast<uint32_t>(start));
+        uint32_t runningMisses = 0;
+        uint32_t runningTriangles = 0;
+        for (size_t t = start; t + 1 < end; ++t)
+        {
+            runningMisses += cache.misses(&indices[t * 3]);
+            runningTriangles++;
+            if (static_cast<float>(runningMisses) <= target * static_cast<float>(runningTriangles))
+            {
+                starts.push_back(static_cast<uint32_t>(t + 1));
+                cache.flush();
+                runningMisses = 0;
+                runningTriangles = 0;
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of every cluster
+    struct Cluster
+    {
+        uint32_t start;
+        uint32_t end;
+        glm::vec3 centroid;
+        glm::vec3 normal;
+        float area;
+        float key;
+    };
+    std::vector<Cluster> sorted(starts.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < starts.size(); ++c)
+    {
+        Cluster& cluster = sorted[c];
+        cluster.start = starts[c];
+        cluster.end = c + 1 < starts.size() ? starts[c + 1] : static_cast<uint32_t>(triangleCount);
+        cluster.centroid = glm::vec3(0.0f);
+        cluster.normal = glm::vec3(0.0f);
+        cluster.area = 0.0f;
+
+        for (uint32_t t = cluster.start; t < cluster.end; ++t)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal) * 0.5f;
+            cluster.centroid += (p0 + p1 + p2) * (area / 3.0f);
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+
+        meshCentroid += cluster.centroid;
+        meshArea += cluster.area;
+        cluster.centroid = cluster.area > 0.0f ? cluster.centroid / cluster.area : glm::vec3(0.0f);
+    }
+    if (meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters far out along their normal occlude the rest from most view directions
+    for (Cluster& cluster : sorted)
+    {
+        float length = glm::length(cluster.normal);
+        cluster.key = length > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : sorted)
+    {
+        result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
+
+void optimizeMeshes(std::vector<DecodedMesh>& meshes, const std::string& name)
+{
+    PROFILE_ZONE("optimizeMeshes");
+
+    // Totals over the model, a vertex counts once per mesh it is referenced by
+    double missesBefore = 0.0;
+    double missesAfter = 0.0;
+    double triangles = 0.0;
+    double referenced = 0.0;
+
+    for (DecodedMesh& mesh : meshes)
+    {
+        size_t triangleCount = mesh.indices.size() / 3;
+        if (triangleCount == 0)
+        {
+            continue;
+        }
+
+        uint32_t vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        missesBefore += analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount).acmr * triangleCount;
+
+        std::vector<uint32_t> clusters;
+        optimizeVertexCache(mesh.indices, vertexCount, &clusters);
+        optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+        optimizeVertexFetch(mesh.vertices, mesh.indices);
+
+        vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        missesAfter += analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), vertexCount).acmr * triangleCount;
+        triangles += triangleCount;
+        referenced += vertexCount;
+    }
+
+    if (triangles == 0.0)
+    {
+        return;
+    }
+
+    char message[256];
+    std::snprintf(message, sizeof(message), "Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+        name.c_str(), missesBefore / triangles, missesAfter / triangles, missesBefore / referenced, missesAfter / referenced);
+    Logger::info(message);
+}
+
+void splitMeshes(std::vector<DecodedMesh>& meshes, uint32_t maxVertices)
+{
+    std::vector<DecodedMesh> result;
+    for (DecodedMesh& mesh : meshes)
+    {
+        if (mesh.vertices.size() <= maxVertices)
+        {
+            result.push_back(std::move(mesh));
+            continue;
+        }
+
+        // Index of each source vertex in the current piece, reset through the piece's own vertex list
+        std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+        std::vector<uint32_t> used;
+        DecodedMesh piece;
+        piece.materialIndex = mesh.materialIndex;
+        piece.node = mesh.node;
+
+        auto finishPiece = [&]()
+        {
+            for (uint32_t vertex : used)
+            {
+                remap[vertex] = UINT32_MAX;
+            }
+            used.clear();
+            result.push_back(std::move(piece));
+            piece = DecodedMesh{};
+            piece.materialIndex = mesh.materialIndex;
+            piece.node = mesh.node;
+        };
+
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            const uint32_t* triangle = &mesh.indices[i];
+            uint32_t added = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+                added += remap[triangle[k]] == UINT32_MAX && !repeated ? 1 : 0;
+            }
+            if (piece.vertices.size() + added > maxVertices)
+            {
+                finishPiece();
+            }
+
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t vertex = triangle[k];
+                if (remap[vertex] == UINT32_MAX)
+                {
+                    remap[vertex] = static_cast<uint32_t>(piece.vertices.size());
+                    piece.vertices.push_back(mesh.vertices[vertex]);
+                    used.push_back(vertex);
+                }
+                piece.indices.push_back(remap[vertex]);
+            }
+        }
+        if (!piece.indices.empty())
+        {
+            finishPiece();
+        }
+    }
+    meshes.swap(result);
+}
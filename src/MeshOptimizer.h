@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshModel.h"
+
+// Imported meshes are reordered for the vertex cache, overdraw and vertex fetch before they
+// are cached and uploaded. Part of the mesh cache key
+const bool MESH_OPTIMIZATION_ENABLED = true;
+
+// Imported meshes with more vertices than 16 bit indices address are split into pieces that fit.
+// Part of the mesh cache key
+const bool MESH_SPLIT_FOR_INDEX16 = true;
+
+// Post transform cache the optimizations and statistics assume, FIFO like most GPUs
+const uint32_t VERTEX_CACHE_SIZE = 16;
+
+// Clusters are split for overdraw sorting as long as their ACMR stays within this factor
+// of the vertex cache order, 1 keeps the cache order as it is
+const float OVERDRAW_THRESHOLD = 1.05f;
+
+struct VertexCacheStats
+{
+    float acmr = 0.0f;      // transformed vertices per triangle, 0.5 at best, 3 at worst
+    float atvr = 0.0f;      // transformed vertices per referenced vertex, 1 at best
+};
+
+// Simulate a FIFO cache of cacheSize entries over the triangle list
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, uint32_t vertexCount,
+                                    uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Reorder triangles for the post transform cache (Tipsify, Sander et al. 2007).
+// clusters receives the first triangle of each run that starts with a cold cache
+void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount,
+                         std::vector<uint32_t>* clusters = nullptr, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Sort the clusters of a vertex cache order so outward facing ones are drawn first, after
+// splitting them further where that costs at most threshold times their ACMR
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                      const std::vector<uint32_t>& clusters, float threshold = OVERDRAW_THRESHOLD,
+                      uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+// Renumber vertices in the order the indices first use them and drop unreferenced ones
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// All three passes in order, logs the ACMR and ATVR of the model before and after
+void optimizeMeshes(std::vector<DecodedMesh>& meshes, const std::string& name);
+
+// Cut meshes into runs of triangles that use at most maxVertices vertices each, keeping the
+// triangle order. Vertices are renumbered per piece in first use order
+void splitMeshes(std::vector<DecodedMesh>& meshes, uint32_t maxVertices);
@@ -0,0 +1,117 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE2
+#include <emmintrin.h>
+#endif
+
+uint32_t getMipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    for (uint32_t extent = std::max(width, height); extent > 1; extent >>= 1)
+    {
+        levels++;
+    }
+    return levels;
+}
+
+uint32_t getMipExtent(uint32_t extent, uint32_t level)
+{
+    return std::max(1u, extent >> level);
+}
+
+size_t getMipLevelSize(uint32_t width, uint32_t height, uint32_t level, const ImageBlock& block)
+{
+    size_t blocksWide = (getMipExtent(width, level) + block.width - 1) / block.width;
+    size_t blocksHigh = (getMipExtent(height, level) + block.height - 1) / block.height;
+    return blocksWide * blocksHigh * block.bytes;
+}
+
+size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t levelCount, uint32_t texelSize)
+{
+    size_t size = 0;
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        size += static_cast<size_t>(getMipExtent(width, level)) * getMipExtent(height, level) * texelSize;
+    }
+    return size;
+}
+
+void downsampleRgba8(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight, unsigned char* dst)
+{
+    uint32_t dstWidth = std::max(1u, srcWidth / 2);
+    uint32_t dstHeight = std::max(1u, srcHeight / 2);
+
+    for (uint32_t y = 0; y < dstHeight; ++y)
+    {
+        // A single row or column is averaged with itself
+        const unsigned char* row0 = src + static_cast<size_t>(std::min(y * 2, srcHeight - 1)) * srcWidth * 4;
+        const unsigned char* row1 = src + static_cast<size_t>(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * 4;
+        unsigned char* out = dst + static_cast<size_t>(y) * dstWidth * 4;
+
+        uint32_t x = 0;
+#ifdef MIP_CHAIN_SSE2
+        // Four output texels from eight input texels of both rows. The sums are widened to 16 bits
+        // and rounded once, bit identical to the scalar tail
+        if (srcWidth >= 2)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i two = _mm_set1_epi16(2);
+            for (; x + 4 <= dstWidth; x += 4)
+            {
+                __m128i top0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                __m128i top1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8 + 16));
+                __m128i bottom0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                __m128i bottom1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8 + 16));
+
+                // Vertical sums, two texels of four 16 bit channels each
+                __m128i sum0 = _mm_add_epi16(_mm_unpacklo_epi8(top0, zero), _mm_unpacklo_epi8(bottom0, zero));
+                __m128i sum1 = _mm_add_epi16(_mm_unpackhi_epi8(top0, zero), _mm_unpackhi_epi8(bottom0, zero));
+                __m128i sum2 = _mm_add_epi16(_mm_unpacklo_epi8(top1, zero), _mm_unpacklo_epi8(bottom1, zero));
+                __m128i sum3 = _mm_add_epi16(_mm_unpackhi_epi8(top1, zero), _mm_unpackhi_epi8(bottom1, zero));
+
+                // The odd texel is added to the even one in the low half
+                sum0 = _mm_add_epi16(sum0, _mm_srli_si128(sum0, 8));
+                sum1 = _mm_add_epi16(sum1, _mm_srli_si128(sum1, 8));
+                sum2 = _mm_add_epi16(sum2, _mm_srli_si128(sum2, 8));
+                sum3 = _mm_add_epi16(sum3, _mm_srli_si128(sum3, 8));
+
+                __m128i first = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum0, sum1), two), 2);
+                __m128i second = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sum2, sum3), two), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(first, second));
+            }
+        }
+#endif
+        for (; x < dstWidth; ++x)
+        {
+            uint32_t x0 = std::min(x * 2, srcWidth - 1) * 4;
+            uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1) * 4;
+            for (uint32_t channel = 0; channel < 4; ++channel)
+            {
+                uint32_t sum = row0[x0 + channel] + row0[x1 + channel] + row1[x0 + channel] + row1[x1 + channel];
+                out[x * 4 + channel] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+std::vector<unsigned char> buildMipChainRgba8(const void* pixels, uint32_t width, uint32_t height, uint32_t levelCount)
+{
+    std::vector<unsigned char> chain(getMipChainSize(width, height, levelCount, 4));
+    std::memcpy(chain.data(), pixels, static_cast<size_t>(width) * height * 4);
+
+    size_t offset = 0;
+    for (uint32_t level = 1; level < levelCount; ++level)
+    {
+        uint32_t srcWidth = getMipExtent(width, level - 1);
+        uint32_t srcHeight = getMipExtent(height, level - 1);
+        size_t next = offset + static_cast<size_t>(srcWidth) * srcHeight * 4;
+
+        downsampleRgba8(chain.data() + offset, srcWidth, srcHeight, chain.data() + next);
+        offset = next;
+    }
+    return chain;
+}
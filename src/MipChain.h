@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Texel blocks of an image format, a single texel for uncompressed formats
+struct ImageBlock
+{
+    uint32_t width = 1;
+    uint32_t height = 1;
+    uint32_t bytes = 4;
+};
+
+// Levels of a full mip chain down to 1x1
+uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+
+// Size of one level, halved per level and never below 1
+uint32_t getMipExtent(uint32_t extent, uint32_t level);
+
+// Bytes of one level stored as tightly packed rows of blocks
+size_t getMipLevelSize(uint32_t width, uint32_t height, uint32_t level, const ImageBlock& block);
+
+// Bytes of the first levelCount levels stored back to back
+size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t levelCount, uint32_t texelSize);
+
+// Box filter one RGBA8 level into the next, SSE2 where available.
+// Odd rows and columns at the end are dropped like a linear blit does.
+// Filters in the stored encoding, for sRGB data this is slightly darker than a blit
+void downsampleRgba8(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight, unsigned char* dst);
+
+// CPU built mip chain, for formats the GPU cannot blit with linear filtering
+std::vector<unsigned char> buildMipChainRgba8(const void* pixels, uint32_t width, uint32_t height, uint32_t levelCount);
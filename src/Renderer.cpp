@@ -1,1710 +1,3127 @@
-#include "Renderer.h"
-
-#include <stdexcept>
-#include <fstream>
-#include <vector>
-#include <array>
-
-#include <glm/gtc/matrix_transform.hpp>
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
-#include "Utils.h"
-#include "Device.h"
-#include "Swapchain.h"
-#include "Window.h"
-#include "Mesh.h"
-#include "Vertex.h"
-#include "Logger.h"
-
-
-Renderer::~Renderer()
-{
-    cleanup();
-}
-
-void Renderer::setup(Device* device,  Swapchain* swapchain, Window* window, Instance* instance)
-{
-    this->device = device;          // Store pointer to Device
-    this->swapchain = swapchain;    // Store pointer to Swapchain
-    this->window = window;          // and window..
-    this->instance = instance;
-
-    device->createCommandPool();
-
-    createRenderPass();
-    createDescriptorSetLayout();
-    createPushConstantRange();
-    
-    createGraphicsPipeline();
-
-    // create image buffers
-    createColorBufferImage();
-    createDepthBufferImage();
-    
-    createFramebuffers();
-
-    createCommandBuffers();
-    createTextureSampler();
-    createSyncObjects();
-
-    // Set minimum uniform buffer offset
-    VkPhysicalDeviceProperties deviceProperties;
-    vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &deviceProperties);
-    
-    // not in use with push constants
-    //minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
-    
-    // not called with push constants, use this with uniform dynamic buffers.
-    //allocateDynamicBufferTransferSpace();
-
-    // view projection
-    uboViewProjection.projection = glm::perspective(glm::radians(45.0f), (float)swapchain->getExtent().width / (float)swapchain->getExtent().height, 0.1f, 100.0f);
-    
-    uboViewProjection.view = glm::lookAt(
-        glm::vec3(0.0f, 3.0f, 5.0f),  
-        glm::vec3(0.0f, 1.0f, 0.0f),   
-        glm::vec3(0.0f, 1.0f, 0.0f)
-    );
-    uboViewProjection.projection[1][1] *= -1;
-
-    createUniformBuffers();
-    createDescriptorPools();
-    createDescriptorSets();
-    createInputDescriptorSets();
-
-    if (initImGui() == EXIT_FAILURE)
-    {
-        throw std::runtime_error("Failed to init ImGui!");
-    }
-}
-
-void Renderer::finalizeSetup()
-{
-    //createDescriptorPools();
-    //createDescriptorSets();
-}
-
-
-void Renderer::drawFrame()
-{
-
-    vkWaitForFences(device->getLogicalDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(device->getLogicalDevice(), 1, &inFlightFences[currentFrame]);
-
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(device->getLogicalDevice(), swapchain->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        recreateSwapchain(swapchain->getExtent());
-        return;
-    }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("Failed to acquire swap chain image!");
-    }
-
-    // Record commands to command buffer (for this specific image)
-    updateUniformBuffers(imageIndex);
-    recordCommandBuffer(commandBuffers[imageIndex], imageIndex);
-
-    // Set up submit info for queue submission
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-
-    if (vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to submit draw command buffer!");
-    }
-
-    // Present the image
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
-
-    VkSwapchainKHR swapchains[] = { swapchain->getSwapchain() };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapchains;
-    presentInfo.pImageIndices = &imageIndex;
-
-    result = vkQueuePresentKHR(device->getPresentQueue(), &presentInfo);
-
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        recreateSwapchain(window->getExtent());
-    }
-    else if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to present swap chain image!");
-    }
-
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-}
-
-void Renderer::update(float deltaTime) 
-{
-    const float rotationSpeed = 45.0f; // Rotate 45 degrees per second
-
-    // Calculate rotation angle in radians based on deltaTime
-    float rotationAngle = glm::radians(rotationSpeed * deltaTime);
-
-    for (size_t i = 0; i < modelList.size(); i++)
-    {
-        glm::mat4 model = modelList[i].getModel().model;
-
-        float direction = (i == 0) ? -1.0f : 1.0f;
-        model = glm::rotate(model, rotationAngle * direction, glm::vec3(0.0f, 1.0f, 0.0f));
-
-        //modelList[i].setModel(model);
-    }
-}
-
-void Renderer::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
-{
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-    
-    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) 
-    {
-        throw std::runtime_error("Failed to begin command buffer!");
-    }
-    
-    // Render pass begin
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = renderPass;
-    renderPassInfo.framebuffer = framebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = swapchain->getExtent();
-
-    std::array<VkClearValue, 3> clearValues = {};
-    clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-    clearValues[1].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-    clearValues[2].depthStencil.depth = 1.0f;
-
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
-
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // Bind graphics pipeline
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-    
-    // Iterate over all models and draw them
-    for (size_t i = 0; i < modelList.size(); i++) 
-    {
-        // push constants to given shader.
-        MeshModel meshModel = modelList[i];
-        Model model = meshModel.getModel();
-        vkCmdPushConstants(commandBuffer,
-            pipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            0,
-            sizeof(Model),
-            &model);
-
-        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
-        {
-
-            // Bind mesh index and vertex buffers       
-            meshModel.getMesh(j)->bind(commandBuffer);
-
-            // Dynamic offset amount
-            //uint32_t dynamicOffset = static_cast<uint32_t>(modelUniformAlignment) * i;
-
-            std::array<VkDescriptorSet, 2> descriptorSetGroup = {
-                                                                descriptorSets[imageIndex],
-                                                                samplerDescriptorSets[meshModel.getMesh(j)->getTextId()]
-            };
-
-            // bind descriptor sets
-            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
-                0, static_cast<uint32_t>(descriptorSetGroup.size()), descriptorSetGroup.data(), 0, nullptr);
-
-
-            meshModel.getMesh(j)->draw(commandBuffer);  // Issue indexed draw call
-        }
-    }
-
-    // Start ImGui frame
-    imguiManager->beginFrame();
-
-    // Render ImGui UI
-    ImGui::Begin("Vulkan Engine");
-    ImGui::Text("Hello from ImGui!");
-    float speed = 2.0f;
-    ImGui::SliderFloat("Camera Speed", &speed, 0.1f, 10.0f);
-    ImGui::End();
-
-    // Draw the shader editor UI
-    imguiManager->drawShaderEditor();
-
-    imguiManager->endFrame(commandBuffer);
-
-    // start second subpass
-    vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
-
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, secondPipeline);
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, secondPipelineLayout,
-        0, 1, &inputDescriptorSets[imageIndex], 0, nullptr);
-    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
-
-    // end the render pass
-    vkCmdEndRenderPass(commandBuffer);
-
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to record command buffer!");
-    }
-}
-
-void Renderer::createInputDescriptorSets()
-{
-    inputDescriptorSets.resize(swapchain->getImageCount());
-
-    std::vector<VkDescriptorSetLayout> setLayouts(swapchain->getImageCount(), inputSetLayout);
-
-    VkDescriptorSetAllocateInfo setAllocInfo = {};
-    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    setAllocInfo.descriptorPool = inputDescriptorPool;
-    setAllocInfo.descriptorSetCount = static_cast<uint32_t>(swapchain->getImageCount());
-    setAllocInfo.pSetLayouts = setLayouts.data();
-
-    // Alocate descriptor sets
-    VkResult result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, inputDescriptorSets.data());
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to allocate input descriptor sets!");
-    }
-
-    // update each descriptor set with input attachment
-    for (size_t i = 0; i < swapchain->getImageCount(); ++i)
-    {
-        // color attachment
-        VkDescriptorImageInfo colourAttachmentDescriptor = {};
-        colourAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        colourAttachmentDescriptor.imageView = colorBufferImageViews[i];
-        colourAttachmentDescriptor.sampler = VK_NULL_HANDLE;
-
-        // color attachment desc write
-        VkWriteDescriptorSet colorWrite = {};
-        colorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        colorWrite.dstSet = inputDescriptorSets[i];
-        colorWrite.dstBinding = 0;
-        colorWrite.dstArrayElement = 0;
-        colorWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-        colorWrite.descriptorCount = 1;
-        colorWrite.pImageInfo = &colourAttachmentDescriptor;
-
-        // depth attachment
-        VkDescriptorImageInfo depthAttachmentDescimageInfo = {};
-        depthAttachmentDescimageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        depthAttachmentDescimageInfo.imageView = depthBufferImageViews[i];
-        depthAttachmentDescimageInfo.sampler = VK_NULL_HANDLE;
-
-        // depth attachment desc write
-        VkWriteDescriptorSet depthWrite = {};
-        depthWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        depthWrite.dstSet = inputDescriptorSets[i];
-        depthWrite.dstBinding = 1;
-        depthWrite.dstArrayElement = 0;
-        depthWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-        depthWrite.descriptorCount = 1;
-        depthWrite.pImageInfo = &depthAttachmentDescimageInfo;
-
-        std::vector<VkWriteDescriptorSet> setWrites = { colorWrite, depthWrite };
-        vkUpdateDescriptorSets(device->getLogicalDevice(), static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
-    }
-
-}
-
-
-void Renderer::recreateSwapchain(VkExtent2D windowExtent) 
-{
-    // Wait until the device is idle
-    vkDeviceWaitIdle(device->getLogicalDevice());
-    // Cleanup swapchain-related resources
-    cleanupSwapchain();
-
-    // Recreate swapchain with the updated extent
-    swapchain->create(device, window->getSurface(), windowExtent);
-    createRenderPass();
-    createGraphicsPipeline();
-    createFramebuffers();
-    createCommandBuffers();
-}
-
-Texture* Renderer::getTexture(const std::string& texturePath)
-{
-    if (textures.find(texturePath) != textures.end()) 
-    {
-        // return existing texture
-        return &textures[texturePath]; 
-    }
-
-    // Load new texture
-    Texture texture;
-    loadTexture(texturePath, texture);
-    textures[texturePath] = texture;
-
-    return &textures[texturePath];
-}
-
-void Renderer::cleanupTextures() 
-{
-    for (auto& pair : textures) 
-    {
-        vkDestroyImageView(device->getLogicalDevice(), pair.second.imageView, nullptr);
-        vkDestroyImage(device->getLogicalDevice(), pair.second.image, nullptr);
-        vkFreeMemory(device->getLogicalDevice(), pair.second.memory, nullptr);
-    }
-    textures.clear();
-}
-void Renderer::cleanupSwapchain() 
-{
-    // Destroy framebuffers for each swapchain image view
-    for (auto framebuffer : framebuffers) {
-        vkDestroyFramebuffer(device->getLogicalDevice(), framebuffer, nullptr);
-    }
-    framebuffers.clear();
-
-    // Destroy the graphics pipeline and pipeline layout, as they may depend on swapchain format or extent
-    if (graphicsPipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device->getLogicalDevice(), graphicsPipeline, nullptr);
-        graphicsPipeline = VK_NULL_HANDLE;
-    }
-
-    if (pipelineLayout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(device->getLogicalDevice(), pipelineLayout, nullptr);
-        pipelineLayout = VK_NULL_HANDLE;
-    }
-
-    // Destroy render pass
-    if (renderPass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(device->getLogicalDevice(), renderPass, nullptr);
-        renderPass = VK_NULL_HANDLE;
-    }
-
-    // Free command buffers, as they are tied to the old swapchain images
-    if (!commandBuffers.empty()) {
-        vkFreeCommandBuffers(device->getLogicalDevice(), device->getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-        commandBuffers.clear();
-    }
-
-    // Call the swapchains own cleanup function to destroy swapchain and associated image views
-    if (swapchain != nullptr) {
-        swapchain->cleanup();
-    }
-}
-
-
-VkCommandBuffer Renderer::getCurrentCommandBuffer() const
-{
-    return commandBuffers[currentFrame];
-}
-
-// Create the render pass
-void Renderer::createRenderPass()
-{
-    // subpasses
-    std::array<VkSubpassDescription, 2> subpasses = {};
-
-    // SUBPASS 1 attachments, input attachments and reference
-    // Color attachment (Input)
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.format = findColorFormat();
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // depth attachment (Input)
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format = findDepthFormat();
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Color attachment input reference to subpass
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 1; // The index of the color attachment
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // Depth attachment input reference
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 2; // index of the depth attachment
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Setting up subpass 1.
-    subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpasses[0].colorAttachmentCount = 1;
-    subpasses[0].pColorAttachments = &colorAttachmentRef;
-    subpasses[0].pDepthStencilAttachment = &depthAttachmentRef;
-
-    // SUBPASS 2 attachments and references.
-    // Swapchain color attachment.
-    VkAttachmentDescription swapchainColorAttachment{};
-    swapchainColorAttachment.format = swapchain->getImageFormat();               // Format of the swapchain image
-    swapchainColorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;                    // Number of samples to write for multisampling
-    swapchainColorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;               // Clear the attachment at the beginning
-    swapchainColorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;             // Store the result of the rendering
-    swapchainColorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    swapchainColorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    swapchainColorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    swapchainColorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;      // The swapchain image is ready for presentation
-
-    // Swapchain color attachment reference to subpass
-    VkAttachmentReference swapchainColorAttachmentRef{};
-    swapchainColorAttachmentRef.attachment = 0; // The index of the color attachment
-    swapchainColorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // references to the attachments that subpass will take input from.
-    std::array<VkAttachmentReference, 2> inputReferences;
-    inputReferences[0].attachment = 1;
-    inputReferences[0].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    inputReferences[1].attachment = 2;
-    inputReferences[1].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-    // setting up subpass 2.
-    subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpasses[1].colorAttachmentCount = 1;
-    subpasses[1].pColorAttachments = &swapchainColorAttachmentRef;
-    subpasses[1].inputAttachmentCount = static_cast<uint32_t>(inputReferences.size());
-    subpasses[1].pInputAttachments = inputReferences.data();
-
-    // SUBPASS DEPENDENCIES
-    // determine when layout transitions occur using subpass dependencies
-    std::array<VkSubpassDependency, 3> subpassDependencies;
-
-    // conversion from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-    subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-    subpassDependencies[0].dstSubpass = 0;
-    subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpassDependencies[0].dependencyFlags = 0;
-
-    // Subpass 1 layout (color/depth) to subpass 2 layout (shader read)
-    subpassDependencies[1].srcSubpass = 0;
-    subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpassDependencies[1].dstSubpass = 1;
-    subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    subpassDependencies[1].dependencyFlags = 0;
-
-    // conversion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-    subpassDependencies[2].srcSubpass = 0;
-    subpassDependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    subpassDependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    subpassDependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
-    subpassDependencies[2].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-    subpassDependencies[2].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-    subpassDependencies[2].dependencyFlags = 0;
-
-    // Create render pass info.
-    std::array<VkAttachmentDescription, 3> attachments = { swapchainColorAttachment, colorAttachment, depthAttachment };
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments = attachments.data();
-    renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
-    renderPassInfo.pSubpasses = subpasses.data();
-    renderPassInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
-    renderPassInfo.pDependencies = subpassDependencies.data();
-
-    if (vkCreateRenderPass(device->getLogicalDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create render pass!");
-    }
-}
-
-void Renderer::createDescriptorSetLayout()
-{
-    VkDescriptorSetLayoutBinding vpLayoutBinding{};
-    vpLayoutBinding.binding = 0; // Binding point in shader, the binding number in shader.
-    vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    vpLayoutBinding.descriptorCount = 1;
-    vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    vpLayoutBinding.pImmutableSamplers = nullptr;
-
-    // Model binding info
-    /* need to define with uniform dynamic buffer not in use with push constants.
-    VkDescriptorSetLayoutBinding modelLayoutBinding = {};
-    modelLayoutBinding.binding = 1;
-    modelLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    modelLayoutBinding.descriptorCount = 1;
-    modelLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    modelLayoutBinding.pImmutableSamplers = nullptr;
-
-    std::vector< VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding, modelLayoutBinding };
-    */
-    std::vector< VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding };
-
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-    layoutInfo.pBindings = layoutBindings.data();
-
-    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create descriptor set layout!");
-    }
-
-    // Create texture sampler descriptor set layout
-    VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-    samplerLayoutBinding.binding = 0;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-
-    VkDescriptorSetLayoutCreateInfo textureLayoutCreateInfo = {};
-    textureLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    textureLayoutCreateInfo.bindingCount = 1;
-    textureLayoutCreateInfo.pBindings = &samplerLayoutBinding;
-
-    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &textureLayoutCreateInfo, nullptr, &samplerSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create a sampler descriptor set layout!");
-    }
-
-    // input attachment image descriptor set layout
-    VkDescriptorSetLayoutBinding colorInputLayoutBinding = {};
-    colorInputLayoutBinding.binding = 0;
-    colorInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-    colorInputLayoutBinding.descriptorCount = 1;
-    colorInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    // depth input binding
-    VkDescriptorSetLayoutBinding depthInputLayoutBinding = {};
-    depthInputLayoutBinding.binding = 1;
-    depthInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-    depthInputLayoutBinding.descriptorCount = 1;
-    depthInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    std::vector<VkDescriptorSetLayoutBinding> inputBindings = { colorInputLayoutBinding, depthInputLayoutBinding };
-    VkDescriptorSetLayoutCreateInfo inputLayoutCreateInfo = {};
-    inputLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    inputLayoutCreateInfo.bindingCount = static_cast<uint32_t>(inputBindings.size());
-    inputLayoutCreateInfo.pBindings = inputBindings.data();
-
-    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &inputLayoutCreateInfo, nullptr, &inputSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create a input descriptor set layout!");
-    }
-
-}
-
-void Renderer::createPushConstantRange()
-{
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(Model);
-}
-
-
-// Create the pipeline
-void Renderer::createGraphicsPipeline() 
-{
-    // Shader stages.
-    VkPipelineShaderStageCreateInfo shaderStages[2];
-    shaderStages[0] = createShaderStage("shaders/vertex_shader.spv", VK_SHADER_STAGE_VERTEX_BIT);
-    shaderStages[1] = createShaderStage("shaders/fragment_shader.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
-
-    // Vertex input state
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    std::vector<VkVertexInputBindingDescription> bindingDescriptions = Vertex::getBindingDescriptions();
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = Vertex::getAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    // Input assembly state
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    // Viewport and scissor state
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)swapchain->getExtent().width;
-    viewport.height = (float)swapchain->getExtent().height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = { 0, 0 };
-    scissor.extent = swapchain->getExtent();
-
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    // Rasterizer state
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-
-    // Multisample state
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;               // enabling multisampling or not
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT; // number of samples to use per fragment
-
-    // Color blend state
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    // (srcColorBlendFactor * new colour) colorBlendOp (dstColorBlendFactor * old color)
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f;
-    colorBlending.blendConstants[1] = 0.0f;
-    colorBlending.blendConstants[2] = 0.0f;
-    colorBlending.blendConstants[3] = 0.0f;
-
-    // Pipeline layout
-    std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts = { descriptorSetLayout  , samplerSetLayout };
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
-    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    // Add descriptor set layouts if you have any
-    if (vkCreatePipelineLayout(device->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create pipeline layout!");
-    }
-
-
-    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo{};
-    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencilCreateInfo.depthTestEnable = VK_TRUE;             // Enable depth testing
-    depthStencilCreateInfo.depthWriteEnable = VK_TRUE;            // Enable depth writing
-    depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;   // Allows and allows overwrite in front
-    depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
-    depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
-
-    // Create the graphics pipeline
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2; // Number of shader stages
-    pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pDynamicState = nullptr;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = &depthStencilCreateInfo; // enable depth test
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass; // Ensure renderPass is created and not null
-    pipelineInfo.subpass = 0;
-
-    VkResult result = vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
-    if (result != VK_SUCCESS) 
-    {
-        std::cerr << "Failed to create graphics pipeline! Error code: " << result << std::endl;
-        throw std::runtime_error("Failed to create graphics pipeline!");
-    }
-
-    // SECOND PASS PIPELINE
-    VkPipelineShaderStageCreateInfo secondPassShaderStages[2];
-    secondPassShaderStages[0] = createShaderStage("shaders/second_pass_vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
-    secondPassShaderStages[1] = createShaderStage("shaders/second_pass_frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
-
-    vertexInputInfo.vertexBindingDescriptionCount = 0;
-    vertexInputInfo.pVertexBindingDescriptions = nullptr;
-    vertexInputInfo.vertexAttributeDescriptionCount = 0;
-    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
-
-    depthStencilCreateInfo.depthWriteEnable = VK_FALSE;
-    
-    VkPipelineLayoutCreateInfo secondPipelineLayoutCreateInfo = {};
-    secondPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    secondPipelineLayoutCreateInfo.setLayoutCount = 1;
-    secondPipelineLayoutCreateInfo.pSetLayouts = &inputSetLayout;
-    secondPipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-    secondPipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
-
-    result = vkCreatePipelineLayout(device->getLogicalDevice(), &secondPipelineLayoutCreateInfo, nullptr, &secondPipelineLayout);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create second pipeline layout!");
-    }
-
-    pipelineInfo.pStages = secondPassShaderStages;
-    pipelineInfo.layout = secondPipelineLayout;
-    pipelineInfo.subpass = 1;
-
-    // create second pass pipeline
-    result = vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &secondPipeline);
-    if (result != VK_SUCCESS)
-    {
-        std::cerr << "Failed to create graphics pipeline! Error code: " << result << std::endl;
-        throw std::runtime_error("Failed to create graphics pipeline!");
-    }
-}
-
-void Renderer::createColorBufferImage()
-{
-    colorBufferImages.resize(swapchain->getImageCount());
-    colorBufferImageMemory.resize(swapchain->getImageCount());
-    colorBufferImageViews.resize(swapchain->getImageCount());
-
-    VkFormat colorFormat = findColorFormat();
-
-    for (size_t i = 0; i < swapchain->getImageCount(); i++)
-    {
-        createImage(swapchain->getExtent().width,
-                    swapchain->getExtent().height,
-                    colorFormat,
-                    VK_IMAGE_TILING_OPTIMAL,
-                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                    &colorBufferImages[i],
-                    &colorBufferImageMemory[i]);
-
-        colorBufferImageViews[i] = createImageView(colorBufferImages[i], colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
-    }
-}
-
-void Renderer::createDepthBufferImage()
-{
-
-    depthBufferImages.resize(swapchain->getImageCount());
-    depthBufferImageMemory.resize(swapchain->getImageCount());
-    depthBufferImageViews.resize(swapchain->getImageCount());
-
-    VkFormat depthFormat = findDepthFormat();
-
-    for (size_t i = 0; i < swapchain->getImageCount(); i++)
-    {
-        createImage(swapchain->getExtent().width, swapchain->getExtent().height,
-            depthFormat,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            &depthBufferImages[i],
-            &depthBufferImageMemory[i]);
-        depthBufferImageViews[i] = createImageView(depthBufferImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-    }
-}
-
-// Create framebuffers for each swapchain image view
-void Renderer::createFramebuffers() 
-{
-    framebuffers.resize(swapchain->getImageCount());
-
-    for (size_t i = 0; i < framebuffers.size(); i++) 
-    {
-        std::array<VkImageView, 3> attachments = {  swapchain->getImageView(i),
-                                                    colorBufferImageViews[i],
-                                                    depthBufferImageViews[i]
-                                                 };
-
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebufferInfo.pAttachments = attachments.data();
-        framebufferInfo.width = swapchain->getExtent().width;
-        framebufferInfo.height = swapchain->getExtent().height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device->getLogicalDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("Failed to create framebuffer!");
-        }
-    }
-}
-
-void Renderer::createCommandBuffers() 
-{
-    commandBuffers.resize(framebuffers.size());
-
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = device->getCommandPool();
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-    if (vkAllocateCommandBuffers(device->getLogicalDevice(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers!");
-    }
-}
-
-void Renderer::createTextureSampler() {
-    VkPhysicalDeviceProperties properties{};
-    vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
-
-    VkSamplerCreateInfo samplerInfo{};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    samplerInfo.anisotropyEnable = VK_TRUE;
-    samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
-    samplerInfo.mipLodBias = 0.0f;
-
-    // Allocate memory for sampler
-    
-    if (vkCreateSampler(device->getLogicalDevice(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create texture sampler!");
-    }
-
-}
-
-
-// Create semaphores and fences for frame synchronization
-void Renderer::createSyncObjects()
-{
-    // Ensure the vectors have the correct size
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    // Create semaphores and fences for each frame
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (vkCreateSemaphore(device->getLogicalDevice(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device->getLogicalDevice(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(device->getLogicalDevice(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create synchronization objects for a frame!");
-        }
-    }
-}
-
-void Renderer::createDescriptorPools()
-{
-    // create uniform descriptor pool
-
-    // ViewProjection pool
-    VkDescriptorPoolSize vpPoolSize = {};
-    vpPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    vpPoolSize.descriptorCount = static_cast<uint32_t>(vpUniformBuffers.size());
-
-    // Model pool dynamic
-    /* used with model dynamic buffers
-    VkDescriptorPoolSize modelPoolSize = {};
-    modelPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    modelPoolSize.descriptorCount = static_cast<uint32_t>(modelDynUniformBuffers.size());
-
-    std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize, modelPoolSize };
-*/
-    std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize };
-    VkDescriptorPoolCreateInfo poolCreateInfo = {};
-    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolCreateInfo.maxSets = static_cast<uint32_t>(swapchain->getImageCount());
-    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-    poolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
-    
-    VkResult result = vkCreateDescriptorPool(device->getLogicalDevice(), &poolCreateInfo, nullptr, &descriptorPool);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a descriptor pool!");
-    }
-
-    // create texture sampler pool
-    VkDescriptorPoolSize samplerPoolSize = {};
-    samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerPoolSize.descriptorCount = MAX_OBJECTS;
-    
-    VkDescriptorPoolCreateInfo samplerPoolCreateInfo = {};
-    samplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    samplerPoolCreateInfo.maxSets = MAX_OBJECTS;
-    samplerPoolCreateInfo.poolSizeCount = 1;
-    samplerPoolCreateInfo.pPoolSizes = &samplerPoolSize;
-
-    result = vkCreateDescriptorPool(device->getLogicalDevice(), &samplerPoolCreateInfo, nullptr, &samplerDescriptorPool);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a sampler descriptor pool!");
-    }
-
-    // create input attachment descriptor pool
-    VkDescriptorPoolSize colorInputPoolSize = {};
-    colorInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-    colorInputPoolSize.descriptorCount = static_cast<uint32_t>(colorBufferImageViews.size());
-
-    VkDescriptorPoolSize depthInputPoolSize = {};
-    depthInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-    depthInputPoolSize.descriptorCount = static_cast<uint32_t>(depthBufferImageViews.size());
-
-    std::vector<VkDescriptorPoolSize> inputPoolSizes = { colorInputPoolSize, depthInputPoolSize };
-
-    VkDescriptorPoolCreateInfo inputPoolCreateInfo = {};
-    inputPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    inputPoolCreateInfo.maxSets = swapchain->getImageCount();
-    inputPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(inputPoolSizes.size());
-    inputPoolCreateInfo.pPoolSizes = inputPoolSizes.data();
-    result = vkCreateDescriptorPool(device->getLogicalDevice(), &inputPoolCreateInfo, nullptr, &inputDescriptorPool);
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create a input descriptor pool!");
-    }
-}
-
-void Renderer::createDescriptorSets()
-{
-    descriptorSets.resize(swapchain->getImageCount());
-
-    std::vector<VkDescriptorSetLayout> setLayouts(swapchain->getImageCount(), descriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo setAllocInfo = {};
-    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    setAllocInfo.descriptorPool = descriptorPool;
-    setAllocInfo.descriptorSetCount = static_cast<uint32_t>(swapchain->getImageCount());
-    setAllocInfo.pSetLayouts = setLayouts.data();
-
-    // Alocate descriptor sets
-    VkResult result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, descriptorSets.data());
-    if (result != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to allocate descriptor sets!");
-    }
-
-    // Update all of descriptor set buffer bindings
-    for (size_t i = 0; i < swapchain->getImageCount(); ++i)
-    {
-        // ViewProjection Descriptor.
-        VkDescriptorBufferInfo vpBufferInfo = {};
-        vpBufferInfo.buffer = vpUniformBuffers[i];
-        vpBufferInfo.offset = 0;
-        vpBufferInfo.range = sizeof(UboViewProjection);
-
-        VkWriteDescriptorSet vpSetWrite = {};
-        vpSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        vpSetWrite.dstSet = descriptorSets[i];
-        vpSetWrite.dstBinding = 0;
-        vpSetWrite.dstArrayElement = 0;
-        vpSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        vpSetWrite.descriptorCount = 1;
-        vpSetWrite.pBufferInfo = &vpBufferInfo;
-
-        // Model descriptor.
-        /* left for example if dynamic buffer usage, not in use with push constant for model transform
-        VkDescriptorBufferInfo modelBufferInfo = {};
-        modelBufferInfo.buffer = modelDynUniformBuffers[i];
-        modelBufferInfo.offset = 0;
-        modelBufferInfo.range = modelUniformAlignment;
-
-        VkWriteDescriptorSet modelSetWrite = {};
-        modelSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        modelSetWrite.dstSet = descriptorSets[i];
-        modelSetWrite.dstBinding = 1;
-        modelSetWrite.dstArrayElement = 0;
-        modelSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        modelSetWrite.descriptorCount = 1;
-        modelSetWrite.pBufferInfo = &modelBufferInfo;
-        
-        std::vector< VkWriteDescriptorSet> setWrites = { vpSetWrite, modelSetWrite };
-        */
-        std::vector< VkWriteDescriptorSet> setWrites = { vpSetWrite };
-
-        // update the descriptor sets with new buffer/binding info.
-        vkUpdateDescriptorSets(device->getLogicalDevice(),
-                                static_cast<uint32_t>(setWrites.size()), 
-                                setWrites.data(), 
-                                0, nullptr);
-    }
-}
-
-int Renderer::createTextureDescriptor(VkImageView textureImage)
-{
-    VkDescriptorSet descriptorSet;
-    
-    VkDescriptorSetAllocateInfo setAllocateInfo = {};
-    setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    setAllocateInfo.descriptorPool = samplerDescriptorPool;
-    setAllocateInfo.descriptorSetCount = 1;
-    setAllocateInfo.pSetLayouts = &samplerSetLayout;
-
-    VkResult result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocateInfo, &descriptorSet);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate texture descriptor set!");
-    }
-
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = textureImage;
-    imageInfo.sampler = textureSampler;
-
-    VkWriteDescriptorSet descriptorWrite = {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = descriptorSet;
-    descriptorWrite.dstBinding = 0;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pImageInfo = &imageInfo;
-
-    vkUpdateDescriptorSets(device->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
-    
-    samplerDescriptorSets.push_back(descriptorSet);
-
-    return samplerDescriptorSets.size() - 1;
-}
-
-int Renderer::createMeshModel(std::string modelPath, std::string modelFile)
-{
-    Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(modelPath + modelFile, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
-
-    if (!scene)
-    {
-        throw std::runtime_error("Failed to load model! (" + modelPath + modelFile +")");
-    }
-
-    std::vector<std::string> textureNames = MeshModel::loadMaterials(scene);
-
-    // Create textures
-    std::vector<int> matToTex(textureNames.size());
-    for (size_t i = 0; i < textureNames.size(); ++i)
-    {
-        if (textureNames[i].empty())
-        {
-            matToTex[i] = 0;
-        }
-        else
-        {
-            Texture* texture = getTexture(modelPath + textureNames[i]);
-            matToTex[i] = texture->textId;
-        }
-    }
-
-    // Load all the meshes
-    std::vector<Mesh> modelMeshes = MeshModel::LoadNode(device, scene->mRootNode, scene, matToTex);
-
-    MeshModel meshModel = MeshModel(modelMeshes);
-    modelList.push_back(meshModel);
-    return modelList.size() - 1;
-}
-
-void Renderer::createUniformBuffers()
-{
-    // viewProjection buffer size.
-    VkDeviceSize vpBufferSize = sizeof(UboViewProjection);
-
-    // model buffer size
-    //VkDeviceSize modelBufferSize = modelUniformAlignment * MAX_OBJECTS;
-
-    vpUniformBuffers.resize(swapchain->getImageCount());
-    vpUniformBuffersMemory.resize(swapchain->getImageCount());
-
-    //modelDynUniformBuffers.resize(swapchain->getImageCount());
-    //modelDynUniformBuffersMemory.resize(swapchain->getImageCount());
-
-    for (size_t i = 0; i < swapchain->getImageCount(); ++i)
-    {
-        createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), vpBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            vpUniformBuffers[i], vpUniformBuffersMemory[i]);
-
-        /*
-        createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), modelBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            modelDynUniformBuffers[i], modelDynUniformBuffersMemory[i]);
-            */
-    }
-
-}
-
-void Renderer::updateUniformBuffers(uint32_t imageIndex)
-{
-    if (vpUniformBuffersMemory.empty() || imageIndex >= vpUniformBuffersMemory.size()) {
-        // Skip updating if no uniform buffers are available or index is out of range
-        return;
-    }
-
-    // ViewProjection data
-    void* data;
-    VkResult result = vkMapMemory(device->getLogicalDevice(), vpUniformBuffersMemory[imageIndex], 0, sizeof(UboViewProjection), 0, &data);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to map uniform buffer memory!");
-    }
-    memcpy(data, &uboViewProjection, sizeof(UboViewProjection));
-    vkUnmapMemory(device->getLogicalDevice(), vpUniformBuffersMemory[imageIndex]);
-
-    // Model data
-
-    /* this is not in use now, left for example of updating uniform dynamic buffer!
-    for (size_t i = 0; i < meshes.size(); ++i)
-    {
-        Model* model = (Model*)((uint64_t)modelTransferSpace + (i * modelUniformAlignment));
-        *model = meshes[i]->getModel();
-    }
-
-    result = vkMapMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[imageIndex], 0, modelUniformAlignment * meshes.size(), 0, &data);
-    if (result != VK_SUCCESS) {
-        throw std::runtime_error("Failed to map model uniform buffer memory!");
-    }
-    memcpy(data, modelTransferSpace, modelUniformAlignment * meshes.size());
-    vkUnmapMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[imageIndex]);
-    */
-}
-
-
-VkPipelineShaderStageCreateInfo Renderer::createShaderStage(const std::string& filepath, VkShaderStageFlagBits stage)
-{
-    // Read the shader code from file
-    std::ifstream file(filepath, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open shader file: " + filepath);
-    }
-
-    size_t fileSize = (size_t)file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-    file.close();
-
-    // Create shader module
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = buffer.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
-
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device->getLogicalDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create shader module: " + filepath);
-    }
-
-    // Store the shader module for later cleanup
-    shaderModules.push_back(shaderModule); // Add the created shader module to the vector
-
-    // Create shader stage info
-    VkPipelineShaderStageCreateInfo shaderStageInfo{};
-    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    shaderStageInfo.stage = stage;
-    shaderStageInfo.module = shaderModule;
-    shaderStageInfo.pName = "main";  // Entry point for the shader
-
-    return shaderStageInfo; // Return the created shader stage info
-}
-
-void Renderer::allocateDynamicBufferTransferSpace()
-{
-    /*
-    modelUniformAlignment = (sizeof(Model) + minUniformBufferOffset - 1) & ~(minUniformBufferOffset - 1);
-
-    // create space in memory to hold dynamic buffer aligned to required alignment and hold max objects.
-    modelTransferSpace = (Model*)_aligned_malloc(modelUniformAlignment * MAX_OBJECTS, modelUniformAlignment);
-    if (!modelTransferSpace) {
-        throw std::runtime_error("Failed to allocate aligned memory for modelTransferSpace.");
-    }
-    */
-}
-
-void Renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkImage* image, VkDeviceMemory* imageMemory)
-{
-
-    VkImageCreateInfo imageInfo{};
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.extent.width = width;
-    imageInfo.extent.height = height;
-    imageInfo.extent.depth = 1;                             // Single layer
-    imageInfo.mipLevels = 1;                                // number of mipmap levels
-    imageInfo.arrayLayers = 1;                              // Single image
-    imageInfo.format = format;                              // Format (e.g., depth format)
-    imageInfo.tiling = tiling;                              // Tiling (e.g., optimal tiling)
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;    // Initial layout
-    imageInfo.usage = usageFlags;                           // Usage flags (e.g., depth-stencil attachment)
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;              // Single sample (no multisampling)
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;      // Exclusive access, wether image can be shared between queues
-
-    // Create the image
-    if (vkCreateImage(device->getLogicalDevice(), &imageInfo, nullptr, image) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create image!");
-    }
-
-    // Get memory requirements
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(device->getLogicalDevice(), *image, &memRequirements);
-
-    // Allocate memory
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size; // Required memory size
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, memoryPropertyFlags, device->getPhysicalDevice());
-
-    if (vkAllocateMemory(device->getLogicalDevice(), &allocInfo, nullptr, imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate image memory!");
-    }
-
-    // Bind memory to the image
-    vkBindImageMemory(device->getLogicalDevice(), *image, *imageMemory, 0);
-
-}
-
-VkImageView Renderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
-    VkImageViewCreateInfo viewInfo{};
-    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    viewInfo.format = format;
-
-    // Define the subresource range (for depth, color, etc.)
-    viewInfo.subresourceRange.aspectMask = aspectFlags;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
-    viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
-
-    VkImageView imageView;
-    if (vkCreateImageView(device->getLogicalDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) 
-    {
-        throw std::runtime_error("Failed to create image view!");
-    }
-
-    return imageView;
-}
-
-VkFormat Renderer::findDepthFormat()
-{
-    return findSupportedFormat(
-        { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
-    );
-}
-
-VkFormat Renderer::findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
-{
-    for (VkFormat format : candidates)
-    {
-        VkFormatProperties props;
-        vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), format, &props);
-
-        if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) 
-        {
-            return format;
-        }
-        else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
-        {
-            return format;
-        }
-    }
-
-    throw std::runtime_error("Failed to find a supported depth format!");
-}
-
-void Renderer::loadTexture(const std::string& filePath, Texture& texture)
-{
-    loadTextureImage(filePath, texture);
-    texture.imageView = createImageView(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
-
-    int descriptorLoc = createTextureDescriptor(texture.imageView);
-    texture.textId = descriptorLoc;
-}
-
-void Renderer::loadTextureImage(const std::string& filePath, Texture &texture)
-{
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(filePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-
-    VkDeviceSize imageSize = texWidth * texHeight * 4; // RGBA (4 bytes per pixel)
-
-    if (!pixels) 
-    {
-        throw std::runtime_error("Failed to load texture image!");
-    }
-
-    // Create staging buffer and copy image data to it
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device->getLogicalDevice(), stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device->getLogicalDevice(), stagingBufferMemory);
-
-    stbi_image_free(pixels);
-
-    // Create Vulkan image
-    createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB,
-        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture.image, &texture.memory);
-
-    // Transition image to be ready for data copy
-    transitionImageLayout(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    
-    // Copy buffer to the new created image
-    copyBufferToImage(stagingBuffer, texture.image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    
-    // Transition image for shader sampling
-    transitionImageLayout(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    // Cleanup staging buffer
-    vkDestroyBuffer(device->getLogicalDevice(), stagingBuffer, nullptr);
-    vkFreeMemory(device->getLogicalDevice(), stagingBufferMemory, nullptr);
-}
-
-void Renderer::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout)
-{
-    VkCommandBuffer commandBuffer = beginCommandBuffer(device->getLogicalDevice(), device->getCommandPool());
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    }
-    else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    }
-    else {
-        throw std::runtime_error("Unsupported layout transition!");
-    }
-
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceStage, destinationStage,
-        0, 0, nullptr, 0, nullptr, 1, &barrier
-    );
-
-    endAndSubmitCommandBuffer(device->getLogicalDevice(), device->getGraphicsQueue(), device->getCommandPool(), commandBuffer);
-}
-
-void Renderer::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
-{
-    VkCommandBuffer commandBuffer = beginCommandBuffer(device->getLogicalDevice(), device->getCommandPool());
-
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = { width, height, 1 };
-
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        buffer,
-        image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        1,
-        &region
-    );
-
-    endAndSubmitCommandBuffer(device->getLogicalDevice(), device->getGraphicsQueue(), device->getCommandPool(), commandBuffer);
-}
-
-int Renderer::initImGui()
-{
-    try {
-        imguiManager = new ImGuiManager(window->getSDLWindow(),
-            instance->getInstance(),
-            device->getLogicalDevice(),
-            device->getPhysicalDevice(),
-            device->getGraphicsQueue(),
-            device->getGraphicsQueueFamilyIndex(),
-            getRenderPass());
-
-    }
-    catch (std::runtime_error& e) {
-        Logger::error("Failed to initialize ImGui: " + std::string(e.what()));
-        return EXIT_FAILURE;
-    }
-    return 0;
-}
-
-VkFormat Renderer::findColorFormat()
-{
-    return findSupportedFormat(
-        { VK_FORMAT_R8G8B8A8_UNORM },
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-    );
-}
-
-void Renderer::cleanup()
-{
-    
-    //if (modelTransferSpace) {
-    //    _aligned_free(modelTransferSpace);
-    //    modelTransferSpace = nullptr;
-    //}
-
-
-    if (imguiManager)
-    {
-        delete imguiManager;
-        imguiManager = nullptr;
-    }
-
-    if (device)
-    {
-        vkDeviceWaitIdle(device->getLogicalDevice());
-
-        for (size_t i = 0; i < modelList.size(); ++i)
-        {
-            modelList[i].destroyMeshModel();
-        }
-
-        vkDestroyDescriptorPool(device->getLogicalDevice(), samplerDescriptorPool, nullptr);
-        vkDestroyDescriptorSetLayout(device->getLogicalDevice(), samplerSetLayout, nullptr);
-
-        for (size_t i = 0; i < depthBufferImages.size(); i++)
-        {
-            vkDestroyImageView(device->getLogicalDevice(), depthBufferImageViews[i], nullptr);
-            vkDestroyImage(device->getLogicalDevice(), depthBufferImages[i], nullptr);
-            vkFreeMemory(device->getLogicalDevice(), depthBufferImageMemory[i], nullptr);
-        }
-
-        for (size_t i = 0; i < colorBufferImages.size(); i++)
-        {
-            vkDestroyImageView(device->getLogicalDevice(), colorBufferImageViews[i], nullptr);
-            vkDestroyImage(device->getLogicalDevice(), colorBufferImages[i], nullptr);
-            vkFreeMemory(device->getLogicalDevice(), colorBufferImageMemory[i], nullptr);
-        }
-
-        cleanupTextures();
-        vkDestroySampler(device->getLogicalDevice(), textureSampler, nullptr);
-
-        if (descriptorPool != VK_NULL_HANDLE) 
-        {
-            Logger::info("Destroying descriptor pool.");
-            vkDestroyDescriptorPool(device->getLogicalDevice(), descriptorPool, nullptr);
-            descriptorPool = VK_NULL_HANDLE;
-        }
-        else {
-            Logger::warning("Descriptor pool is already null.");
-        }
-
-        vkDestroyDescriptorPool(device->getLogicalDevice(), inputDescriptorPool, nullptr);
-        if (inputSetLayout != VK_NULL_HANDLE)
-        {
-            Logger::info("Destroying input descriptor set layout.");
-            vkDestroyDescriptorSetLayout(device->getLogicalDevice(), inputSetLayout, nullptr);
-            inputSetLayout = VK_NULL_HANDLE;
-        }
-
-        if (descriptorSetLayout != VK_NULL_HANDLE)
-        {
-            Logger::info("Destroying descriptor set layout.");
-            vkDestroyDescriptorSetLayout(device->getLogicalDevice(), descriptorSetLayout, nullptr);
-            descriptorSetLayout = VK_NULL_HANDLE;
-        }
-        else {
-            Logger::warning("Descriptor set layout is already null.");
-        }
-
-        for (size_t i = 0; i < vpUniformBuffers.size(); ++i)
-        {
-            if (vpUniformBuffers[i] != VK_NULL_HANDLE) 
-            {
-                Logger::info("Destroying uniform buffer at index " + std::to_string(i));
-                vkDestroyBuffer(device->getLogicalDevice(), vpUniformBuffers[i], nullptr);
-                vpUniformBuffers[i] = VK_NULL_HANDLE;
-            }
-            else {
-                Logger::warning("VP Uniform buffer at index " + std::to_string(i) + " is already null.");
-            }
-        }
-
-        for (size_t i = 0; i < vpUniformBuffersMemory.size(); ++i) 
-        {
-            if (vpUniformBuffersMemory[i] != VK_NULL_HANDLE)
-            {
-                Logger::info("Freeing uniform buffer memory at index " + std::to_string(i));
-                vkFreeMemory(device->getLogicalDevice(), vpUniformBuffersMemory[i], nullptr);
-                vpUniformBuffersMemory[i] = VK_NULL_HANDLE;
-            }
-            else {
-                Logger::warning("VP Uniform buffer memory at index " + std::to_string(i) + " is already null.");
-            }
-        }
-
-        for (size_t i = 0; i < modelDynUniformBuffers.size(); ++i)
-        {
-            if (modelDynUniformBuffers[i] != VK_NULL_HANDLE)
-            {
-                Logger::info("Destroying uniform buffer at index " + std::to_string(i));
-                vkDestroyBuffer(device->getLogicalDevice(), modelDynUniformBuffers[i], nullptr);
-                modelDynUniformBuffers[i] = VK_NULL_HANDLE;
-            }
-            else {
-                Logger::warning("Model dynamic Uniform buffer at index " + std::to_string(i) + " is already null.");
-            }
-        }
-
-        for (size_t i = 0; i < modelDynUniformBuffersMemory.size(); ++i)
-        {
-            if (modelDynUniformBuffersMemory[i] != VK_NULL_HANDLE)
-            {
-                Logger::info("Freeing uniform buffer memory at index " + std::to_string(i));
-                vkFreeMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[i], nullptr);
-                modelDynUniformBuffersMemory[i] = VK_NULL_HANDLE;
-            }
-            else {
-                Logger::warning("Model Dynamic Uniform buffer memory at index " + std::to_string(i) + " is already null.");
-            }
-        }
-
-        // Destroy graphics pipelines
-
-        if (secondPipeline != VK_NULL_HANDLE)
-        {
-            vkDestroyPipeline(device->getLogicalDevice(), secondPipeline, nullptr);
-            secondPipeline = VK_NULL_HANDLE;
-        }
-
-        // Destroy pipeline layout
-        if (secondPipelineLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyPipelineLayout(device->getLogicalDevice(), secondPipelineLayout, nullptr);
-            secondPipelineLayout = VK_NULL_HANDLE;
-        }
-
-        if (graphicsPipeline != VK_NULL_HANDLE) 
-        {
-            vkDestroyPipeline(device->getLogicalDevice(), graphicsPipeline, nullptr);
-            graphicsPipeline = VK_NULL_HANDLE;
-        }
-
-        // Destroy pipeline layout
-        if (pipelineLayout != VK_NULL_HANDLE)
-        {
-            vkDestroyPipelineLayout(device->getLogicalDevice(), pipelineLayout, nullptr);
-            pipelineLayout = VK_NULL_HANDLE;
-        }
-
-        // Destroy render pass
-        if (renderPass != VK_NULL_HANDLE) 
-        {
-            vkDestroyRenderPass(device->getLogicalDevice(), renderPass, nullptr);
-            renderPass = VK_NULL_HANDLE;
-        }
-
-        // Destroy framebuffers
-        for (auto framebuffer : framebuffers) 
-        {
-            if (framebuffer != VK_NULL_HANDLE)
-            {
-                vkDestroyFramebuffer(device->getLogicalDevice(), framebuffer, nullptr);
-            }
-        }
-        framebuffers.clear();
-
-        // Cleanup synchronization objects (semaphores and fences)
-        for (size_t i = 0; i < inFlightFences.size(); i++) 
-        {
-            if (renderFinishedSemaphores[i] != VK_NULL_HANDLE) 
-            {
-                vkDestroySemaphore(device->getLogicalDevice(), renderFinishedSemaphores[i], nullptr);
-            }
-            if (imageAvailableSemaphores[i] != VK_NULL_HANDLE) 
-            {
-                vkDestroySemaphore(device->getLogicalDevice(), imageAvailableSemaphores[i], nullptr);
-            }
-            if (inFlightFences[i] != VK_NULL_HANDLE) 
-            {
-                vkDestroyFence(device->getLogicalDevice(), inFlightFences[i], nullptr);
-            }
-        }
-        renderFinishedSemaphores.clear();
-        imageAvailableSemaphores.clear();
-        inFlightFences.clear();
-
-        // Destroy shader modules
-        for (auto shaderModule : shaderModules)
-        {
-            if (shaderModule != VK_NULL_HANDLE) 
-            {
-                vkDestroyShaderModule(device->getLogicalDevice(), shaderModule, nullptr);
-            }
-        }
-        shaderModules.clear();
-
-        this->device = nullptr;
-    }
-}
+#include "Renderer.h"
+
+#include <stdexcept>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Utils.h"
+#include "Device.h"
+#include "Swapchain.h"
+#include "Window.h"
+#include "Mesh.h"
+#include "Vertex.h"
+#include "Logger.h"
+#include "CpuProfiler.h"
+#include "MeshCache.h"
+#include "MipChain.h"
+
+
+Renderer::~Renderer()
+{
+    cleanup();
+}
+
+void Renderer::setup(Device* device,  Swapchain* swapchain, Window* window, Instance* instance, uint32_t framesInFlight)
+{
+    this->device = device;          // Store pointer to Device
+    this->swapchain = swapchain;    // Store pointer to Swapchain
+    this->window = window;          // and window..
+    this->instance = instance;
+
+    device->createCommandPool();
+
+    createRenderPass();
+    createDescriptorSetLayout();
+    createGpuCuller();
+    createPushConstantRange();
+    
+    createGraphicsPipeline();
+
+    // create image buffers
+    attachmentMemoryPool = device->getAllocator().createLinearPool(DEFAULT_MEMORY_BLOCK_SIZE);
+    createColorBufferImage();
+    createDepthBufferImage();
+    
+    createFramebuffers();
+
+    createTextureSampler();
+
+    // Set minimum uniform buffer offset
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &deviceProperties);
+    
+    // not in use with push constants
+    //minUniformBufferOffset = deviceProperties.limits.minUniformBufferOffsetAlignment;
+    
+    // not called with push constants, use this with uniform dynamic buffers.
+    //allocateDynamicBufferTransferSpace();
+
+    // view projection
+    uboViewProjection.projection = glm::perspective(glm::radians(45.0f), (float)swapchain->getExtent().width / (float)swapchain->getExtent().height, 0.1f, 100.0f);
+    
+    uboViewProjection.view = glm::lookAt(
+        glm::vec3(0.0f, 3.0f, 5.0f),  
+        glm::vec3(0.0f, 1.0f, 0.0f),   
+        glm::vec3(0.0f, 1.0f, 0.0f)
+    );
+    uboViewProjection.projection[1][1] *= -1;
+
+    createDescriptorPools();
+    createInputDescriptorSets();
+
+    // Stands in for models that are still loading
+    createPlaceholderTexture();
+    assetLoader.create();
+
+    // Worker threads for command recording, the frame contexts get a command pool for each
+    uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    jobSystem.create(std::min(hardwareThreads, MAX_RECORDING_THREADS) - 1);
+
+    // per frame command pools, uniform slices, descriptors and sync objects
+    createFrameContexts(framesInFlight);
+
+    // Headless rendering has no window for ImGui to take input from
+    if (window != nullptr && initImGui() == EXIT_FAILURE)
+    {
+        throw std::runtime_error("Failed to init ImGui!");
+    }
+}
+
+void Renderer::finalizeSetup()
+{
+    //createDescriptorPools();
+    //createDescriptorSets();
+}
+
+
+void Renderer::drawFrame()
+{
+    PROFILE_ZONE("Renderer::drawFrame");
+
+    // Apply a pending frames in flight change before any frame context is touched
+    if (requestedFramesInFlight != 0)
+    {
+        vkDeviceWaitIdle(device->getLogicalDevice());
+        destroyFrameContexts();
+        createFrameContexts(requestedFramesInFlight);
+        requestedFramesInFlight = 0;
+    }
+
+    // Free staging memory of upload batches that have completed, and whatever else waited for the GPU
+    device->getUploadEngine().collect();
+    device->getGpuTimeline().collect();
+
+    // Ranges of unloaded models have just come back, only defragment once they leave the free space split up
+    device->getGeometryArena().compactIfFragmented();
+
+    processLoadedModels();
+    updateScene();
+    updateTextureStreaming();
+
+    FrameContext& frame = frames[currentFrame];
+    GpuTimeline& gpuTimeline = device->getGpuTimeline();
+
+    // Wait until the GPU has finished the last frame that used this context
+    gpuTimeline.wait(frame.timelineValue);
+
+    uint32_t imageIndex;
+    VkResult result = swapchain->acquireNextImage(frame.imageAvailableSemaphore, imageIndex);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreateSwapchain(swapchain->getExtent());
+        return;
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("Failed to acquire swap chain image!");
+    }
+
+    // The image may still be rendered to by an older frame context
+    gpuTimeline.wait(imagesInFlight[imageIndex]);
+
+    // GPU is done with this context, recycle its command buffers and transient descriptors
+    vkResetCommandPool(device->getLogicalDevice(), frame.commandPool, 0);
+    for (ThreadCommands& thread : frame.threadCommands)
+    {
+        vkResetCommandPool(device->getLogicalDevice(), thread.commandPool, 0);
+        thread.used = 0;
+    }
+    vkResetDescriptorPool(device->getLogicalDevice(), frame.descriptorArena, 0);
+
+    // Record commands to the command buffer of this frame (for this specific image)
+    updateUniformBuffers(frame);
+    recordCommandBuffer(frame, imageIndex);
+
+    // Set up submit info for queue submission
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+    // Offscreen images are neither acquired nor presented, the timeline alone orders their reuse
+    uint32_t semaphoreCount = swapchain->isOffscreen() ? 0 : 1;
+
+    VkSemaphore waitSemaphores[] = { frame.imageAvailableSemaphore };
+    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    submitInfo.waitSemaphoreCount = semaphoreCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
+
+    VkSemaphore signalSemaphores[] = { frame.renderFinishedSemaphore };
+    submitInfo.signalSemaphoreCount = semaphoreCount;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+
+    // Takes the next timeline value, the frame context and the image are free again once it signals
+    frame.timelineValue = gpuTimeline.submit(submitInfo);
+    imagesInFlight[imageIndex] = frame.timelineValue;
+
+    // Present the image
+    result = swapchain->present(device->getPresentQueue(), frame.renderFinishedSemaphore, imageIndex);
+
+    currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size());
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        recreateSwapchain(window->getExtent());
+    }
+    else if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to present swap chain image!");
+    }
+}
+
+void Renderer::update(float deltaTime) 
+{
+    PROFILE_ZONE("Renderer::update");
+
+    const float rotationSpeed = 45.0f; // Rotate 45 degrees per second
+
+    // Calculate rotation angle in radians based on deltaTime
+    float rotationAngle = glm::radians(rotationSpeed * deltaTime);
+
+    for (size_t i = 0; i < modelList.size(); i++)
+    {
+        glm::mat4 model = modelList[i].getModel().model;
+
+        float direction = (i == 0) ? -1.0f : 1.0f;
+        model = glm::rotate(model, rotationAngle * direction, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        //modelList[i].setModel(model);
+    }
+}
+
+void Renderer::recordCommandBuffer(FrameContext& frame, uint32_t imageIndex)
+{
+    PROFILE_ZONE("Renderer::recordCommandBuffer");
+
+    VkCommandBuffer commandBuffer = frame.commandBuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) 
+    {
+        throw std::runtime_error("Failed to begin command buffer!");
+    }
+
+    // Results of the last use of this frame context are complete, read them and start over
+    gpuProfiler.beginFrame(commandBuffer, currentFrame);
+    uint32_t frameScope = gpuProfiler.beginScope(commandBuffer, currentFrame, "Frame");
+    
+    // Render pass begin
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = framebuffers[imageIndex];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = swapchain->getExtent();
+
+    std::array<VkClearValue, 3> clearValues = {};
+    clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+    clearValues[1].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
+    clearValues[2].depthStencil.depth = 1.0f;
+
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    // The scene becomes draw lists culled on the CPU, or objects the GPU culls into indirect draws
+    drawList.clear();
+    staticDrawList.clear();
+    staticModelRevisions.clear();
+    staticVisibleDraws.clear();
+    instancedDrawList.clear();
+    frameInstances.clear();
+    staticInstancedDrawList.clear();
+    staticInstances.clear();
+    indirectDrawCallCount = 0;
+    bool gpuCulling = usesGpuCulling();
+    if (gpuCulling)
+    {
+        prepareIndirectDraws(frame);
+    }
+    else
+    {
+        prepareDrawLists();
+    }
+    requestTextureLevels();
+
+    PROFILE_COUNTER("Draws", cullingStats.visible);
+    PROFILE_COUNTER("Culled draws", cullingStats.tested - cullingStats.visible);
+
+    // Static draws are only recorded again when something they depend on has changed
+    StaticBundle& staticBundle = getStaticBundle(frame, graphicsPipeline);
+    if (!isStaticBundleCurrent(staticBundle))
+    {
+        recordStaticBundle(frame, staticBundle);
+    }
+
+    // Record the chunks in parallel, each into a secondary from the pool of the thread running it
+    uint32_t jobCount = static_cast<uint32_t>((drawList.size() + DRAWS_PER_RECORDING_JOB - 1) / DRAWS_PER_RECORDING_JOB);
+    secondaryCommands.resize(jobCount);
+    jobSystem.dispatch(jobCount, [&](uint32_t job, uint32_t thread)
+    {
+        PROFILE_ZONE("Record draws");
+        size_t first = static_cast<size_t>(job) * DRAWS_PER_RECORDING_JOB;
+        size_t count = std::min<size_t>(DRAWS_PER_RECORDING_JOB, drawList.size() - first);
+
+        VkCommandBuffer secondary = beginSecondaryCommandBuffer(frame, thread, imageIndex);
+        uint32_t scope = gpuProfiler.beginScope(secondary, currentFrame, "Scene draws");
+        recordDraws(secondary, frame, drawList, first, count);
+        gpuProfiler.endScope(secondary, currentFrame, scope);
+        if (vkEndCommandBuffer(secondary) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record secondary command buffer!");
+        }
+        secondaryCommands[job] = secondary;
+    });
+
+    if (!instancedDrawList.empty())
+    {
+        secondaryCommands.push_back(recordInstancedDraws(frame, imageIndex));
+    }
+
+    if (gpuCulling && !drawBuckets.empty())
+    {
+        secondaryCommands.push_back(recordIndirectDraws(frame, imageIndex));
+    }
+
+    // Headless there is no window to show the UI in
+    if (imguiManager != nullptr)
+    {
+        secondaryCommands.push_back(recordImGui(frame, imageIndex, staticBundle, jobCount));
+    }
+
+    if (staticBundle.drawCount > 0)
+    {
+        secondaryCommands.insert(secondaryCommands.begin(), staticBundle.commandBuffer);
+    }
+
+    // The cull pass writes the indirect commands of the first subpass, compute may not run inside the render pass
+    if (gpuCulling)
+    {
+        uint32_t cullScope = gpuProfiler.beginScope(commandBuffer, currentFrame, "GPU culling");
+        gpuCuller.dispatch(commandBuffer, currentFrame, uboViewProjection.projection * uboViewProjection.view);
+        gpuProfiler.endScope(commandBuffer, currentFrame, cullScope);
+    }
+
+    // The first subpass only executes the secondaries, in draw order.
+    // Its draw groups are timed inside the secondaries, the primary may not record anything there
+    uint32_t firstSubpassScope = gpuProfiler.beginScope(commandBuffer, currentFrame, "Subpass 0");
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommands.size()), secondaryCommands.data());
+
+    // start second subpass
+    vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+    gpuProfiler.endScope(commandBuffer, currentFrame, firstSubpassScope);
+    uint32_t secondSubpassScope = gpuProfiler.beginScope(commandBuffer, currentFrame, "Fullscreen pass");
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, secondPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, secondPipelineLayout,
+        0, 1, &inputDescriptorSets[imageIndex], 0, nullptr);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+    // end the render pass
+    vkCmdEndRenderPass(commandBuffer);
+    gpuProfiler.endScope(commandBuffer, currentFrame, secondSubpassScope);
+    gpuProfiler.endScope(commandBuffer, currentFrame, frameScope);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record command buffer!");
+    }
+}
+
+// Build the UI and record it into a secondary, ImGui is not thread safe so this runs on the calling thread
+VkCommandBuffer Renderer::recordImGui(FrameContext& frame, uint32_t imageIndex, const StaticBundle& staticBundle, uint32_t jobCount)
+{
+    // Start ImGui frame
+    imguiManager->beginFrame();
+
+    // Render ImGui UI
+    ImGui::Begin("Vulkan Engine");
+    ImGui::Text("Hello from ImGui!");
+    float speed = 2.0f;
+    ImGui::SliderFloat("Camera Speed", &speed, 0.1f, 10.0f);
+    int framesInFlight = static_cast<int>(frames.size());
+    if (ImGui::SliderInt("Frames in flight", &framesInFlight, 1, static_cast<int>(MAX_FRAMES_IN_FLIGHT_LIMIT)))
+    {
+        setFramesInFlight(static_cast<uint32_t>(framesInFlight));
+    }
+    GpuTimeline& gpuTimeline = device->getGpuTimeline();
+    ImGui::Text("GPU timeline: %llu submitted, %llu completed (%s)",
+        static_cast<unsigned long long>(gpuTimeline.getSubmittedValue()),
+        static_cast<unsigned long long>(gpuTimeline.getCompletedValue()),
+        gpuTimeline.usesTimelineSemaphore() ? "timeline semaphore" : "fences");
+    MemoryStats memoryStats = device->getAllocator().getStats();
+    ImGui::Text("GPU memory: %.1f / %.1f MB in %u blocks, %u allocations",
+        memoryStats.usedBytes / (1024.0 * 1024.0), memoryStats.blockBytes / (1024.0 * 1024.0),
+        memoryStats.blockCount, memoryStats.allocationCount);
+    GeometryStats geometryStats = device->getGeometryArena().getStats();
+    ImGui::Text("Geometry: %u meshes (%u with 16 bit indices), %u / %u vertices, %.1f / %.1f MB of indices",
+        geometryStats.meshCount, geometryStats.index16MeshCount, geometryStats.vertexCount, geometryStats.vertexCapacity,
+        geometryStats.indexBytes / (1024.0 * 1024.0), geometryStats.indexByteCapacity / (1024.0 * 1024.0));
+    ImGui::Text("Scene: %u nodes, %u world transforms updated", sceneGraph.getNodeCount(), sceneNodesUpdated);
+    ImGui::Checkbox("Frustum culling", &frustumCullingEnabled);
+    if (gpuCullingSupported)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("On the GPU", &gpuCullingEnabled);
+    }
+    ImGui::Text("Culling: %u / %u draws visible, %u culled%s", cullingStats.visible, cullingStats.tested,
+        cullingStats.tested - cullingStats.visible, usesGpuCulling() ? " on the GPU" : "");
+    if (usesGpuCulling())
+    {
+        ImGui::Text("Indirect: %zu buckets in %u draw calls (%s)", drawBuckets.size(), indirectDrawCallCount,
+            gpuCuller.usesDrawCount() ? "draw count" : "fixed slots");
+    }
+    ImGui::Text("Recording: %zu draws in %u jobs on %u threads", drawList.size(), jobCount, jobSystem.getThreadCount());
+    ImGui::Text("Instancing: %zu draws of %zu instances", instancedDrawList.size(), frameInstances.size());
+    bool cacheStatic = staticBundlesEnabled;
+    if (ImGui::Checkbox("Cache static draws", &cacheStatic))
+    {
+        setStaticBundlesEnabled(cacheStatic);
+    }
+    ImGui::Text("Static bundle: %u draws, recorded %u times", staticBundle.drawCount, staticBundleRecordCount);
+    ImGui::Text("Assets: %zu models loading", loadingModels.size());
+    ImGui::Text("Texture streaming: %.1f / %.1f MB for %u textures, %u changes pending",
+        textureStreamer.getResidentBytes() / (1024.0 * 1024.0), textureStreamer.getBudget() / (1024.0 * 1024.0),
+        textureStreamer.getStreamedCount(), textureStreamer.getPendingCount());
+#ifdef VULKANOVISTA_PROFILER
+    if (ImGui::Button("Save CPU trace"))
+    {
+        CpuProfiler::writeChromeTrace(CPU_TRACE_FILE);
+    }
+#endif
+    ImGui::End();
+
+    // Draw the shader editor UI
+    imguiManager->drawShaderEditor();
+
+    gpuProfiler.drawImGui();
+
+    VkCommandBuffer uiCommands = beginSecondaryCommandBuffer(frame, 0, imageIndex);
+    uint32_t uiScope = gpuProfiler.beginScope(uiCommands, currentFrame, "ImGui");
+    imguiManager->endFrame(uiCommands);
+    gpuProfiler.endScope(uiCommands, currentFrame, uiScope);
+    if (vkEndCommandBuffer(uiCommands) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record secondary command buffer!");
+    }
+    return uiCommands;
+}
+
+VkCommandBuffer Renderer::beginSecondaryCommandBuffer(FrameContext& frame, uint32_t thread, uint32_t imageIndex)
+{
+    ThreadCommands& commands = frame.threadCommands[thread];
+    if (commands.used == commands.secondaries.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commands.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer secondary;
+        if (vkAllocateCommandBuffers(device->getLogicalDevice(), &allocInfo, &secondary) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+        commands.secondaries.push_back(secondary);
+    }
+    VkCommandBuffer commandBuffer = commands.secondaries[commands.used++];
+
+    beginInheritingCommandBuffer(commandBuffer, framebuffers[imageIndex], VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    return commandBuffer;
+}
+
+// Begin a secondary that continues the first subpass of the scene render pass.
+// The framebuffer may be null when the same recording is used with every swapchain image.
+void Renderer::beginInheritingCommandBuffer(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkCommandBufferUsageFlags flags)
+{
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin secondary command buffer!");
+    }
+}
+
+StaticBundle& Renderer::getStaticBundle(FrameContext& frame, VkPipeline pipeline)
+{
+    for (StaticBundle& bundle : frame.staticBundles)
+    {
+        if (bundle.pipeline == pipeline)
+        {
+            return bundle;
+        }
+    }
+
+    // Bundles of a pipeline that no longer exists are reused, they are stale anyway
+    StaticBundle* bundle = nullptr;
+    for (StaticBundle& candidate : frame.staticBundles)
+    {
+        if (candidate.sceneRevision != staticRevision)
+        {
+            bundle = &candidate;
+            break;
+        }
+    }
+    if (bundle == nullptr)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frame.staticCommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        frame.staticBundles.emplace_back();
+        bundle = &frame.staticBundles.back();
+        if (vkAllocateCommandBuffers(device->getLogicalDevice(), &allocInfo, &bundle->commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to allocate static bundle command buffer!");
+        }
+    }
+
+    bundle->pipeline = pipeline;
+    bundle->recorded = false;
+    return *bundle;
+}
+
+bool Renderer::isStaticBundleCurrent(const StaticBundle& bundle) const
+{
+    return bundle.recorded &&
+        bundle.sceneRevision == staticRevision &&
+        bundle.geometryRevision == device->getGeometryArena().getRevision() &&
+        bundle.modelRevisions == staticModelRevisions &&
+        bundle.visibleDraws == staticVisibleDraws;
+}
+
+// Record the static draw list into the bundle, waiting for the frame timeline value guarantees it is not in use
+void Renderer::recordStaticBundle(FrameContext& frame, StaticBundle& bundle)
+{
+    bundle.sceneRevision = staticRevision;
+    bundle.geometryRevision = device->getGeometryArena().getRevision();
+    bundle.modelRevisions = staticModelRevisions;
+    bundle.visibleDraws = staticVisibleDraws;
+    bundle.drawCount = static_cast<uint32_t>(staticDrawList.size() + staticInstancedDrawList.size());
+    bundle.recorded = true;
+
+    if (bundle.drawCount == 0)
+    {
+        return;
+    }
+
+    // Instances are written once here and read every time the bundle is replayed
+    if (!staticInstancedDrawList.empty())
+    {
+        if (bundle.instanceSet == VK_NULL_HANDLE)
+        {
+            VkDescriptorSetAllocateInfo setAllocInfo = {};
+            setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            setAllocInfo.descriptorPool = frame.staticDescriptorPool;
+            setAllocInfo.descriptorSetCount = 1;
+            setAllocInfo.pSetLayouts = &instanceSetLayout;
+
+            if (vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, &bundle.instanceSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to allocate static bundle instance set!");
+            }
+            writeInstanceBuffer(staticInstances, bundle.instanceBuffer, bundle.instanceMemory, bundle.instanceCapacity);
+            writeInstanceSet(bundle.instanceSet, bundle.instanceBuffer);
+        }
+        else if (writeInstanceBuffer(staticInstances, bundle.instanceBuffer, bundle.instanceMemory, bundle.instanceCapacity))
+        {
+            writeInstanceSet(bundle.instanceSet, bundle.instanceBuffer);
+        }
+    }
+
+    // No framebuffer, the bundle is executed with whichever swapchain image the frame gets
+    beginInheritingCommandBuffer(bundle.commandBuffer, VK_NULL_HANDLE, 0);
+    // The bundle is replayed for many frames, so it writes the same queries of its frame context every time
+    gpuProfiler.writeBegin(bundle.commandBuffer, currentFrame, staticDrawScope);
+    if (!staticDrawList.empty())
+    {
+        recordDraws(bundle.commandBuffer, frame, staticDrawList, 0, staticDrawList.size());
+    }
+    if (!staticInstancedDrawList.empty())
+    {
+        recordInstancedDrawList(bundle.commandBuffer, frame, bundle.instanceSet, staticInstancedDrawList);
+    }
+    gpuProfiler.writeEnd(bundle.commandBuffer, currentFrame, staticDrawScope);
+    if (vkEndCommandBuffer(bundle.commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record static bundle!");
+    }
+
+    staticBundleRecordCount++;
+}
+
+void Renderer::setStaticBundlesEnabled(bool enabled)
+{
+    staticBundlesEnabled = enabled;
+    invalidateStaticBundles();
+}
+
+// Flatten the scene so it can be cut into equal chunks, static models go to their own list.
+// Instanced models are culled per instance and drawn once per mesh
+void Renderer::prepareDrawLists()
+{
+    drawCandidates.clear();
+    instancedCandidates.clear();
+    frustumCuller.begin(uboViewProjection.projection * uboViewProjection.view);
+    for (MeshModel& meshModel : modelList)
+    {
+        if (meshModel.isInstanced())
+        {
+            continue;
+        }
+        if (staticBundlesEnabled && meshModel.isStatic())
+        {
+            staticModelRevisions.push_back(meshModel.getRevision());
+        }
+        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
+        {
+            Mesh* mesh = meshModel.getMesh(j);
+            drawCandidates.push_back({ &meshModel, mesh });
+            frustumCuller.add(mesh->getBounds(), sceneGraph.getWorldTransform(mesh->getSceneNode()));
+        }
+    }
+
+    // Instances are tested after every single draw, each mesh remembers where its own start
+    uint32_t cullIndex = static_cast<uint32_t>(drawCandidates.size());
+    for (MeshModel& meshModel : modelList)
+    {
+        if (!meshModel.isInstanced())
+        {
+            continue;
+        }
+        if (staticBundlesEnabled && meshModel.isStatic())
+        {
+            staticModelRevisions.push_back(meshModel.getRevision());
+        }
+        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
+        {
+            Mesh* mesh = meshModel.getMesh(j);
+            const glm::mat4& world = sceneGraph.getWorldTransform(mesh->getSceneNode());
+            instancedCandidates.push_back({ &meshModel, mesh, cullIndex, meshModel.getInstanceCount() });
+            for (const InstanceData& instance : meshModel.getInstances())
+            {
+                frustumCuller.add(mesh->getBounds(), instance.transform * world);
+            }
+            cullIndex += meshModel.getInstanceCount();
+        }
+    }
+
+    // Only the draws that survive culling are recorded
+    if (frustumCullingEnabled)
+    {
+        frustumCuller.cull();
+    }
+    uint32_t staticCandidate = 0;
+    for (uint32_t i = 0; i < drawCandidates.size(); ++i)
+    {
+        const DrawItem& item = drawCandidates[i];
+        bool cached = staticBundlesEnabled && item.model->isStatic();
+        bool visible = !frustumCullingEnabled || frustumCuller.isVisible(i);
+        if (cached)
+        {
+            if (visible)
+            {
+                staticVisibleDraws.push_back(staticCandidate);
+            }
+            staticCandidate++;
+        }
+        if (visible)
+        {
+            (cached ? staticDrawList : drawList).push_back(item);
+        }
+    }
+
+    // The visible instances of a mesh are copied next to each other, the draw covers them all.
+    // Static instances are numbered after the static draws, the bundle is recorded again when they change
+    for (const InstancedDraw& candidate : instancedCandidates)
+    {
+        bool cached = staticBundlesEnabled && candidate.model->isStatic();
+        std::vector<InstanceData>& visibleInstances = cached ? staticInstances : frameInstances;
+        const std::vector<InstanceData>& instances = candidate.model->getInstances();
+        uint32_t firstInstance = static_cast<uint32_t>(visibleInstances.size());
+        for (uint32_t k = 0; k < candidate.instanceCount; ++k)
+        {
+            if (!frustumCullingEnabled || frustumCuller.isVisible(candidate.firstInstance + k))
+            {
+                visibleInstances.push_back(instances[k]);
+                if (cached)
+                {
+                    staticVisibleDraws.push_back(staticCandidate);
+                }
+            }
+            staticCandidate += cached ? 1 : 0;
+        }
+        uint32_t instanceCount = static_cast<uint32_t>(visibleInstances.size()) - firstInstance;
+        if (instanceCount > 0)
+        {
+            (cached ? staticInstancedDrawList : instancedDrawList).push_back({ candidate.model, candidate.mesh, firstInstance, instanceCount });
+        }
+    }
+    cullingStats.tested = cullIndex;
+    cullingStats.visible = static_cast<uint32_t>(drawList.size() + staticDrawList.size() + frameInstances.size() + staticInstances.size());
+}
+
+// Every mesh becomes an object of the cull pass, once per instance of instanced models. Objects are grouped
+// into buckets of the same texture and index type, each bucket gets a contiguous range of commands and
+// is drawn with one indirect call
+void Renderer::prepareIndirectDraws(FrameContext& frame)
+{
+    drawBuckets.clear();
+    drawBucketLookup.assign(samplerDescriptorSets.size() * 2, UINT32_MAX);
+    uint32_t objectCount = 0;
+    for (MeshModel& meshModel : modelList)
+    {
+        uint32_t copies = meshModel.isInstanced() ? meshModel.getInstanceCount() : 1;
+        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
+        {
+            Mesh* mesh = meshModel.getMesh(j);
+            VkIndexType indexType = mesh->getGeometryRange().indexType;
+            uint32_t& bucket = drawBucketLookup[mesh->getTextId() * 2 + (indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0)];
+            if (bucket == UINT32_MAX)
+            {
+                bucket = static_cast<uint32_t>(drawBuckets.size());
+                drawBuckets.push_back({ mesh->getTextId(), indexType, 0, 0 });
+            }
+            drawBuckets[bucket].commandCount += copies;
+            objectCount += copies;
+        }
+    }
+
+    // Counted first so the buckets can be laid out back to back, then filled in again
+    uint32_t firstCommand = 0;
+    for (DrawBucket& bucket : drawBuckets)
+    {
+        bucket.firstCommand = firstCommand;
+        firstCommand += bucket.commandCount;
+        bucket.commandCount = 0;
+    }
+
+    GpuObject* objects = gpuCuller.beginFrame(currentFrame, objectCount, static_cast<uint32_t>(drawBuckets.size()));
+
+    // Textures the last submission of this context drew, the buckets of then may differ from the ones of now
+    const std::vector<uint32_t>& bucketCounts = gpuCuller.getBucketVisibleCounts();
+    gpuVisibleTextures.assign(samplerDescriptorSets.size(), 0);
+    for (size_t i = 0; i < std::min(bucketCounts.size(), frame.cullBucketTextures.size()); ++i)
+    {
+        int textureId = frame.cullBucketTextures[i];
+        if (bucketCounts[i] > 0 && textureId < static_cast<int>(gpuVisibleTextures.size()))
+        {
+            gpuVisibleTextures[textureId] = 1;
+        }
+    }
+    frame.cullBucketTextures.clear();
+    for (const DrawBucket& bucket : drawBuckets)
+    {
+        frame.cullBucketTextures.push_back(bucket.textureId);
+    }
+
+    uint32_t object = 0;
+    for (MeshModel& meshModel : modelList)
+    {
+        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
+        {
+            Mesh* mesh = meshModel.getMesh(j);
+            GeometryRange range = mesh->getGeometryRange();
+            uint32_t bucket = drawBucketLookup[mesh->getTextId() * 2 + (range.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0)];
+            DrawBucket& drawBucket = drawBuckets[bucket];
+
+            // The dequantization is a scale and an offset, see Vertex.cpp
+            const glm::mat4& dequantization = mesh->getDequantization();
+            const MeshBounds& bounds = mesh->getBounds();
+
+            // Built on the stack, the object buffer is write combined memory
+            const glm::mat4& world = sceneGraph.getWorldTransform(mesh->getSceneNode());
+            GpuObject gpuObject = {};
+            gpuObject.transform = world;
+            gpuObject.dequantScale = glm::vec4(dequantization[0][0], dequantization[1][1], dequantization[2][2], 0.0f);
+            gpuObject.dequantOffset = dequantization[3];
+            gpuObject.boundsCenter = glm::vec4((bounds.min + bounds.max) * 0.5f, bounds.radius);
+            gpuObject.boundsExtent = glm::vec4((bounds.max - bounds.min) * 0.5f, 0.0f);
+            gpuObject.indexCount = range.indexCount;
+            gpuObject.firstIndex = range.firstIndex;
+            gpuObject.vertexOffset = range.vertexOffset;
+            gpuObject.bucket = bucket;
+            gpuObject.bucketFirst = drawBucket.firstCommand;
+            if (!meshModel.isInstanced())
+            {
+                gpuObject.command = drawBucket.firstCommand + drawBucket.commandCount++;
+                objects[object++] = gpuObject;
+                continue;
+            }
+
+            // Instances only differ in their transform
+            for (const InstanceData& instance : meshModel.getInstances())
+            {
+                gpuObject.transform = instance.transform * world;
+                gpuObject.command = drawBucket.firstCommand + drawBucket.commandCount++;
+                objects[object++] = gpuObject;
+            }
+        }
+    }
+
+    // What the GPU found visible is only known once the frame context comes around again
+    cullingStats.tested = objectCount;
+    cullingStats.visible = std::min(gpuCuller.getVisibleCount(), objectCount);
+}
+
+// Record the indirect draws of every bucket into one secondary, the commands are written by the cull pass
+VkCommandBuffer Renderer::recordIndirectDraws(FrameContext& frame, uint32_t imageIndex)
+{
+    VkCommandBuffer commandBuffer = beginSecondaryCommandBuffer(frame, 0, imageIndex);
+    uint32_t scope = gpuProfiler.beginScope(commandBuffer, currentFrame, "Indirect draws");
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipeline);
+    VkIndexType boundIndexType;
+    device->getGeometryArena().bind(commandBuffer, boundIndexType);
+
+    VkDescriptorSet objectSet = gpuCuller.getDescriptorSet(currentFrame);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipelineLayout,
+        0, 1, &frame.vpDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipelineLayout,
+        2, 1, &objectSet, 0, nullptr);
+
+    for (uint32_t i = 0; i < drawBuckets.size(); ++i)
+    {
+        const DrawBucket& bucket = drawBuckets[i];
+        device->getGeometryArena().bindIndexType(commandBuffer, bucket.indexType, boundIndexType);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipelineLayout,
+            1, 1, &samplerDescriptorSets[bucket.textureId], 0, nullptr);
+        gpuCuller.draw(commandBuffer, currentFrame, i, bucket.firstCommand, bucket.commandCount);
+        indirectDrawCallCount += gpuCuller.getDrawCallCount(bucket.commandCount);
+    }
+
+    gpuProfiler.endScope(commandBuffer, currentFrame, scope);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record indirect draws!");
+    }
+    return commandBuffer;
+}
+
+// Copy the instances of the frame into its instance buffer and record one draw per instanced mesh
+VkCommandBuffer Renderer::recordInstancedDraws(FrameContext& frame, uint32_t imageIndex)
+{
+    // Nothing of the frame context is in flight, an outgrown buffer can be replaced right away
+    writeInstanceBuffer(frameInstances, frame.instanceBuffer, frame.instanceMemory, frame.instanceCapacity);
+    VkDescriptorSet instanceSet = allocateFrameDescriptorSet(frame, instanceSetLayout);
+    writeInstanceSet(instanceSet, frame.instanceBuffer);
+
+    VkCommandBuffer commandBuffer = beginSecondaryCommandBuffer(frame, 0, imageIndex);
+    uint32_t scope = gpuProfiler.beginScope(commandBuffer, currentFrame, "Instanced draws");
+    recordInstancedDrawList(commandBuffer, frame, instanceSet, instancedDrawList);
+    gpuProfiler.endScope(commandBuffer, currentFrame, scope);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record instanced draws!");
+    }
+    return commandBuffer;
+}
+
+// Record instanced draws whose instances are in the buffer of instanceSet
+void Renderer::recordInstancedDrawList(VkCommandBuffer commandBuffer, FrameContext& frame, VkDescriptorSet instanceSet,
+                                       const std::vector<InstancedDraw>& draws)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipeline);
+    VkIndexType boundIndexType;
+    device->getGeometryArena().bind(commandBuffer, boundIndexType);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+        0, 1, &frame.vpDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+        2, 1, &instanceSet, 0, nullptr);
+
+    for (const InstancedDraw& draw : draws)
+    {
+        Model model;
+        model.model = sceneGraph.getWorldTransform(draw.mesh->getSceneNode()) * draw.mesh->getDequantization();
+        vkCmdPushConstants(commandBuffer, instancedPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Model), &model);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, instancedPipelineLayout,
+            1, 1, &samplerDescriptorSets[draw.mesh->getTextId()], 0, nullptr);
+        draw.mesh->draw(commandBuffer, boundIndexType, draw.instanceCount, draw.firstInstance);
+    }
+}
+
+// Copy instances into a host visible buffer, replaced when outgrown. Returns whether it was replaced,
+// the old one must not be in use anymore
+bool Renderer::writeInstanceBuffer(const std::vector<InstanceData>& instances, VkBuffer& buffer, Allocation& memory, uint32_t& capacity)
+{
+    uint32_t instanceCount = static_cast<uint32_t>(instances.size());
+    bool replaced = false;
+    if (instanceCount > capacity)
+    {
+        uint32_t newCapacity = std::max(capacity, DEFAULT_FRAME_INSTANCES);
+        while (newCapacity < instanceCount)
+        {
+            newCapacity *= 2;
+        }
+        if (buffer != VK_NULL_HANDLE)
+        {
+            destroyBuffer(device->getLogicalDevice(), device->getAllocator(), buffer, memory);
+        }
+        createBuffer(device->getLogicalDevice(), device->getAllocator(), newCapacity * sizeof(InstanceData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer, memory);
+        capacity = newCapacity;
+        replaced = true;
+    }
+    memcpy(memory.mapped, instances.data(), instanceCount * sizeof(InstanceData));
+    return replaced;
+}
+
+void Renderer::writeInstanceSet(VkDescriptorSet instanceSet, VkBuffer buffer)
+{
+    VkDescriptorBufferInfo bufferInfo = { buffer, 0, VK_WHOLE_SIZE };
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = instanceSet;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device->getLogicalDevice(), 1, &write, 0, nullptr);
+}
+
+// Record a chunk of the draw list, a secondary inherits no state so everything is bound again
+void Renderer::recordDraws(VkCommandBuffer commandBuffer, FrameContext& frame, const std::vector<DrawItem>& items, size_t first, size_t count)
+{
+    // Bind graphics pipeline
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+
+    // All meshes share the arena buffers, bind them once for the whole chunk
+    VkIndexType boundIndexType;
+    device->getGeometryArena().bind(commandBuffer, boundIndexType);
+
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const DrawItem& item = items[i];
+
+        // push constants to given shader, every mesh has its own node and dequantization of the packed positions
+        Model model;
+        model.model = sceneGraph.getWorldTransform(item.mesh->getSceneNode()) * item.mesh->getDequantization();
+        vkCmdPushConstants(commandBuffer,
+            pipelineLayout,
+            VK_SHADER_STAGE_VERTEX_BIT,
+            0,
+            sizeof(Model),
+            &model);
+
+        std::array<VkDescriptorSet, 2> descriptorSetGroup = {
+                                                            frame.vpDescriptorSet,
+                                                            samplerDescriptorSets[item.mesh->getTextId()]
+        };
+
+        // bind descriptor sets
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout,
+            0, static_cast<uint32_t>(descriptorSetGroup.size()), descriptorSetGroup.data(), 0, nullptr);
+
+        item.mesh->draw(commandBuffer, boundIndexType);  // Issue indexed draw call
+    }
+}
+
+void Renderer::createInputDescriptorSets()
+{
+    inputDescriptorSets.resize(swapchain->getImageCount());
+
+    std::vector<VkDescriptorSetLayout> setLayouts(swapchain->getImageCount(), inputSetLayout);
+
+    VkDescriptorSetAllocateInfo setAllocInfo = {};
+    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocInfo.descriptorPool = inputDescriptorPool;
+    setAllocInfo.descriptorSetCount = static_cast<uint32_t>(swapchain->getImageCount());
+    setAllocInfo.pSetLayouts = setLayouts.data();
+
+    // Alocate descriptor sets
+    VkResult result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, inputDescriptorSets.data());
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate input descriptor sets!");
+    }
+
+    // update each descriptor set with input attachment
+    for (size_t i = 0; i < swapchain->getImageCount(); ++i)
+    {
+        // color attachment
+        VkDescriptorImageInfo colourAttachmentDescriptor = {};
+        colourAttachmentDescriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        colourAttachmentDescriptor.imageView = colorBufferImageViews[i];
+        colourAttachmentDescriptor.sampler = VK_NULL_HANDLE;
+
+        // color attachment desc write
+        VkWriteDescriptorSet colorWrite = {};
+        colorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        colorWrite.dstSet = inputDescriptorSets[i];
+        colorWrite.dstBinding = 0;
+        colorWrite.dstArrayElement = 0;
+        colorWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        colorWrite.descriptorCount = 1;
+        colorWrite.pImageInfo = &colourAttachmentDescriptor;
+
+        // depth attachment
+        VkDescriptorImageInfo depthAttachmentDescimageInfo = {};
+        depthAttachmentDescimageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        depthAttachmentDescimageInfo.imageView = depthBufferImageViews[i];
+        depthAttachmentDescimageInfo.sampler = VK_NULL_HANDLE;
+
+        // depth attachment desc write
+        VkWriteDescriptorSet depthWrite = {};
+        depthWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        depthWrite.dstSet = inputDescriptorSets[i];
+        depthWrite.dstBinding = 1;
+        depthWrite.dstArrayElement = 0;
+        depthWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        depthWrite.descriptorCount = 1;
+        depthWrite.pImageInfo = &depthAttachmentDescimageInfo;
+
+        std::vector<VkWriteDescriptorSet> setWrites = { colorWrite, depthWrite };
+        vkUpdateDescriptorSets(device->getLogicalDevice(), static_cast<uint32_t>(setWrites.size()), setWrites.data(), 0, nullptr);
+    }
+
+}
+
+
+void Renderer::recreateSwapchain(VkExtent2D windowExtent) 
+{
+    // Wait until the device is idle
+    vkDeviceWaitIdle(device->getLogicalDevice());
+    // Cleanup swapchain-related resources
+    cleanupSwapchain();
+
+    // Recreate swapchain with the updated extent, headless the offscreen images are resized
+    if (swapchain->isOffscreen())
+    {
+        swapchain->createOffscreen(device, windowExtent);
+    }
+    else
+    {
+        swapchain->create(device, window->getSurface(), windowExtent);
+    }
+    createRenderPass();
+    createGraphicsPipeline();
+    createFramebuffers();
+
+    // image count may have changed and no frame is in flight anymore
+    imagesInFlight.assign(swapchain->getImageCount(), 0);
+
+    // Render pass and pipeline are new, cached bundles refer to the old ones
+    invalidateStaticBundles();
+}
+
+void Renderer::setFramesInFlight(uint32_t count)
+{
+    count = std::max(1u, std::min(count, MAX_FRAMES_IN_FLIGHT_LIMIT));
+    if (count == frames.size())
+    {
+        requestedFramesInFlight = 0;
+        return;
+    }
+
+    // Resizing the ring needs an idle GPU, defer it to the start of the next frame
+    requestedFramesInFlight = count;
+}
+
+Texture* Renderer::getTexture(const std::string& texturePath)
+{
+    if (textures.find(texturePath) != textures.end()) 
+    {
+        // return existing texture
+        return &textures[texturePath]; 
+    }
+
+    // Load new texture, KTX2 and DDS files are uploaded as stored, anything else is decoded with stb_image
+    return createTexture(AssetLoader::decodeImage(texturePath));
+}
+
+void Renderer::cleanupTextures() 
+{
+    for (auto& pair : textures) 
+    {
+        vkDestroyImageView(device->getLogicalDevice(), pair.second.imageView, nullptr);
+        vkDestroyImage(device->getLogicalDevice(), pair.second.image, nullptr);
+        device->getAllocator().free(pair.second.memory);
+    }
+    textures.clear();
+}
+void Renderer::cleanupSwapchain() 
+{
+    // Destroy framebuffers for each swapchain image view
+    for (auto framebuffer : framebuffers) {
+        vkDestroyFramebuffer(device->getLogicalDevice(), framebuffer, nullptr);
+    }
+    framebuffers.clear();
+
+    // Destroy the graphics pipeline and pipeline layout, as they may depend on swapchain format or extent
+    if (graphicsPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device->getLogicalDevice(), graphicsPipeline, nullptr);
+        graphicsPipeline = VK_NULL_HANDLE;
+    }
+
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device->getLogicalDevice(), pipelineLayout, nullptr);
+        pipelineLayout = VK_NULL_HANDLE;
+    }
+
+    if (indirectPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device->getLogicalDevice(), indirectPipeline, nullptr);
+        indirectPipeline = VK_NULL_HANDLE;
+    }
+
+    if (indirectPipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device->getLogicalDevice(), indirectPipelineLayout, nullptr);
+        indirectPipelineLayout = VK_NULL_HANDLE;
+    }
+
+    if (instancedPipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device->getLogicalDevice(), instancedPipeline, nullptr);
+        instancedPipeline = VK_NULL_HANDLE;
+    }
+
+    if (instancedPipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device->getLogicalDevice(), instancedPipelineLayout, nullptr);
+        instancedPipelineLayout = VK_NULL_HANDLE;
+    }
+
+    // Destroy render pass
+    if (renderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device->getLogicalDevice(), renderPass, nullptr);
+        renderPass = VK_NULL_HANDLE;
+    }
+
+    // Call the swapchains own cleanup function to destroy swapchain and associated image views
+    if (swapchain != nullptr) {
+        swapchain->cleanup();
+    }
+}
+
+
+VkCommandBuffer Renderer::getCurrentCommandBuffer() const
+{
+    return frames[currentFrame].commandBuffer;
+}
+
+// Create the render pass
+void Renderer::createRenderPass()
+{
+    // subpasses
+    std::array<VkSubpassDescription, 2> subpasses = {};
+
+    // SUBPASS 1 attachments, input attachments and reference
+    // Color attachment (Input)
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.format = findColorFormat();
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    // depth attachment (Input)
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = findDepthFormat();
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // Color attachment input reference to subpass
+    VkAttachmentReference colorAttachmentRef{};
+    colorAttachmentRef.attachment = 1; // The index of the color attachment
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    // Depth attachment input reference
+    VkAttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 2; // index of the depth attachment
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // Setting up subpass 1.
+    subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[0].colorAttachmentCount = 1;
+    subpasses[0].pColorAttachments = &colorAttachmentRef;
+    subpasses[0].pDepthStencilAttachment = &depthAttachmentRef;
+
+    // SUBPASS 2 attachments and references.
+    // Swapchain color attachment.
+    VkAttachmentDescription swapchainColorAttachment{};
+    swapchainColorAttachment.format = swapchain->getImageFormat();               // Format of the swapchain image
+    swapchainColorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;                    // Number of samples to write for multisampling
+    swapchainColorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;               // Clear the attachment at the beginning
+    swapchainColorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;             // Store the result of the rendering
+    swapchainColorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    swapchainColorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    swapchainColorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    swapchainColorAttachment.finalLayout = swapchain->getFinalLayout();          // Ready for presentation, or to be copied out when offscreen
+
+    // Swapchain color attachment reference to subpass
+    VkAttachmentReference swapchainColorAttachmentRef{};
+    swapchainColorAttachmentRef.attachment = 0; // The index of the color attachment
+    swapchainColorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    // references to the attachments that subpass will take input from.
+    std::array<VkAttachmentReference, 2> inputReferences;
+    inputReferences[0].attachment = 1;
+    inputReferences[0].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    inputReferences[1].attachment = 2;
+    inputReferences[1].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    // setting up subpass 2.
+    subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[1].colorAttachmentCount = 1;
+    subpasses[1].pColorAttachments = &swapchainColorAttachmentRef;
+    subpasses[1].inputAttachmentCount = static_cast<uint32_t>(inputReferences.size());
+    subpasses[1].pInputAttachments = inputReferences.data();
+
+    // SUBPASS DEPENDENCIES
+    // determine when layout transitions occur using subpass dependencies
+    std::array<VkSubpassDependency, 3> subpassDependencies;
+
+    // conversion from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    subpassDependencies[0].dstSubpass = 0;
+    subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependencies[0].dependencyFlags = 0;
+
+    // Subpass 1 layout (color/depth) to subpass 2 layout (shader read)
+    subpassDependencies[1].srcSubpass = 0;
+    subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependencies[1].dstSubpass = 1;
+    subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    subpassDependencies[1].dependencyFlags = 0;
+
+    // conversion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+    subpassDependencies[2].srcSubpass = 0;
+    subpassDependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    subpassDependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    subpassDependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
+    subpassDependencies[2].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    subpassDependencies[2].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    subpassDependencies[2].dependencyFlags = 0;
+
+    // Create render pass info.
+    std::array<VkAttachmentDescription, 3> attachments = { swapchainColorAttachment, colorAttachment, depthAttachment };
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+    renderPassInfo.pSubpasses = subpasses.data();
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+    renderPassInfo.pDependencies = subpassDependencies.data();
+
+    if (vkCreateRenderPass(device->getLogicalDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create render pass!");
+    }
+}
+
+void Renderer::createDescriptorSetLayout()
+{
+    VkDescriptorSetLayoutBinding vpLayoutBinding{};
+    vpLayoutBinding.binding = 0; // Binding point in shader, the binding number in shader.
+    vpLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    vpLayoutBinding.descriptorCount = 1;
+    vpLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    vpLayoutBinding.pImmutableSamplers = nullptr;
+
+    // Model binding info
+    /* need to define with uniform dynamic buffer not in use with push constants.
+    VkDescriptorSetLayoutBinding modelLayoutBinding = {};
+    modelLayoutBinding.binding = 1;
+    modelLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    modelLayoutBinding.descriptorCount = 1;
+    modelLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    modelLayoutBinding.pImmutableSamplers = nullptr;
+
+    std::vector< VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding, modelLayoutBinding };
+    */
+    std::vector< VkDescriptorSetLayoutBinding> layoutBindings = { vpLayoutBinding };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create descriptor set layout!");
+    }
+
+    // Create texture sampler descriptor set layout
+    VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
+    samplerLayoutBinding.binding = 0;
+    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerLayoutBinding.descriptorCount = 1;
+    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    samplerLayoutBinding.pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo textureLayoutCreateInfo = {};
+    textureLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    textureLayoutCreateInfo.bindingCount = 1;
+    textureLayoutCreateInfo.pBindings = &samplerLayoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &textureLayoutCreateInfo, nullptr, &samplerSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create a sampler descriptor set layout!");
+    }
+
+    // input attachment image descriptor set layout
+    VkDescriptorSetLayoutBinding colorInputLayoutBinding = {};
+    colorInputLayoutBinding.binding = 0;
+    colorInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    colorInputLayoutBinding.descriptorCount = 1;
+    colorInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // depth input binding
+    VkDescriptorSetLayoutBinding depthInputLayoutBinding = {};
+    depthInputLayoutBinding.binding = 1;
+    depthInputLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    depthInputLayoutBinding.descriptorCount = 1;
+    depthInputLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    std::vector<VkDescriptorSetLayoutBinding> inputBindings = { colorInputLayoutBinding, depthInputLayoutBinding };
+    VkDescriptorSetLayoutCreateInfo inputLayoutCreateInfo = {};
+    inputLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    inputLayoutCreateInfo.bindingCount = static_cast<uint32_t>(inputBindings.size());
+    inputLayoutCreateInfo.pBindings = inputBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &inputLayoutCreateInfo, nullptr, &inputSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create a input descriptor set layout!");
+    }
+
+    // instance data of the instanced draws
+    VkDescriptorSetLayoutBinding instanceLayoutBinding = {};
+    instanceLayoutBinding.binding = 0;
+    instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    instanceLayoutBinding.descriptorCount = 1;
+    instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo instanceLayoutCreateInfo = {};
+    instanceLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    instanceLayoutCreateInfo.bindingCount = 1;
+    instanceLayoutCreateInfo.pBindings = &instanceLayoutBinding;
+
+    if (vkCreateDescriptorSetLayout(device->getLogicalDevice(), &instanceLayoutCreateInfo, nullptr, &instanceSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create an instance descriptor set layout!");
+    }
+
+}
+
+// The indirect vertex shader finds its object through firstInstance, without it the CPU culls
+void Renderer::createGpuCuller()
+{
+    gpuCullingSupported = device->supportsDrawIndirectFirstInstance();
+    if (!gpuCullingSupported)
+    {
+        Logger::info("Indirect draws without firstInstance, culling on the CPU");
+        return;
+    }
+
+    gpuCuller.create(device->getLogicalDevice(), &device->getAllocator(),
+        createShaderStage("shaders/cull_comp.spv", VK_SHADER_STAGE_COMPUTE_BIT),
+        device->supportsDrawIndirectCount(), device->supportsMultiDrawIndirect());
+    Logger::info(std::string("GPU culling with ") + (device->supportsDrawIndirectCount() ? "indirect draw count" :
+        device->supportsMultiDrawIndirect() ? "multi draw indirect" : "one indirect draw per mesh"));
+}
+
+void Renderer::createPushConstantRange()
+{
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(Model);
+}
+
+
+// Create the pipeline
+void Renderer::createGraphicsPipeline() 
+{
+    // Shader stages.
+    VkPipelineShaderStageCreateInfo shaderStages[2];
+    shaderStages[0] = createShaderStage("shaders/vertex_shader.spv", VK_SHADER_STAGE_VERTEX_BIT);
+    shaderStages[1] = createShaderStage("shaders/fragment_shader.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    // Vertex input state
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    // Generated at compile time from the arena's vertex format
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &VertexLayout<GpuVertex>::binding;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexLayout<GpuVertex>::attributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = VertexLayout<GpuVertex>::attributes.data();
+
+    // Input assembly state
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor state
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)swapchain->getExtent().width;
+    viewport.height = (float)swapchain->getExtent().height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = swapchain->getExtent();
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    // Rasterizer state
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    // Multisample state
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;               // enabling multisampling or not
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT; // number of samples to use per fragment
+
+    // Color blend state
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    // (srcColorBlendFactor * new colour) colorBlendOp (dstColorBlendFactor * old color)
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f;
+    colorBlending.blendConstants[1] = 0.0f;
+    colorBlending.blendConstants[2] = 0.0f;
+    colorBlending.blendConstants[3] = 0.0f;
+
+    // Pipeline layout
+    std::array<VkDescriptorSetLayout, 2> descriptorSetLayouts = { descriptorSetLayout  , samplerSetLayout };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    // Add descriptor set layouts if you have any
+    if (vkCreatePipelineLayout(device->getLogicalDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout!");
+    }
+
+
+    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo{};
+    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilCreateInfo.depthTestEnable = VK_TRUE;             // Enable depth testing
+    depthStencilCreateInfo.depthWriteEnable = VK_TRUE;            // Enable depth writing
+    depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;   // Allows and allows overwrite in front
+    depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
+    depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
+
+    // Create the graphics pipeline
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2; // Number of shader stages
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pDynamicState = nullptr;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencilCreateInfo; // enable depth test
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.renderPass = renderPass; // Ensure renderPass is created and not null
+    pipelineInfo.subpass = 0;
+
+    VkResult result = vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline);
+    if (result != VK_SUCCESS) 
+    {
+        std::cerr << "Failed to create graphics pipeline! Error code: " << result << std::endl;
+        throw std::runtime_error("Failed to create graphics pipeline!");
+    }
+
+    // Same state for the instanced draws, with the frame's instances as a third set
+    std::array<VkDescriptorSetLayout, 3> instancedSetLayouts = { descriptorSetLayout, samplerSetLayout, instanceSetLayout };
+
+    VkPipelineLayoutCreateInfo instancedLayoutInfo = pipelineLayoutInfo;
+    instancedLayoutInfo.setLayoutCount = static_cast<uint32_t>(instancedSetLayouts.size());
+    instancedLayoutInfo.pSetLayouts = instancedSetLayouts.data();
+
+    if (vkCreatePipelineLayout(device->getLogicalDevice(), &instancedLayoutInfo, nullptr, &instancedPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create instanced pipeline layout!");
+    }
+
+    VkPipelineShaderStageCreateInfo instancedShaderStages[2];
+    instancedShaderStages[0] = createShaderStage("shaders/vertex_shader_instanced.spv", VK_SHADER_STAGE_VERTEX_BIT);
+    instancedShaderStages[1] = shaderStages[1];
+    pipelineInfo.pStages = instancedShaderStages;
+    pipelineInfo.layout = instancedPipelineLayout;
+
+    if (vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &instancedPipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create instanced graphics pipeline!");
+    }
+
+    // Same state for the GPU culled draws, the model comes from the cull objects instead of a push constant
+    if (gpuCullingSupported)
+    {
+        std::array<VkDescriptorSetLayout, 3> indirectSetLayouts = { descriptorSetLayout, samplerSetLayout, gpuCuller.getSetLayout() };
+
+        VkPipelineLayoutCreateInfo indirectLayoutInfo{};
+        indirectLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        indirectLayoutInfo.setLayoutCount = static_cast<uint32_t>(indirectSetLayouts.size());
+        indirectLayoutInfo.pSetLayouts = indirectSetLayouts.data();
+
+        if (vkCreatePipelineLayout(device->getLogicalDevice(), &indirectLayoutInfo, nullptr, &indirectPipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create indirect pipeline layout!");
+        }
+
+        VkPipelineShaderStageCreateInfo indirectShaderStages[2];
+        indirectShaderStages[0] = createShaderStage("shaders/vertex_shader_indirect.spv", VK_SHADER_STAGE_VERTEX_BIT);
+        indirectShaderStages[1] = shaderStages[1];
+        pipelineInfo.pStages = indirectShaderStages;
+        pipelineInfo.layout = indirectPipelineLayout;
+
+        if (vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &indirectPipeline) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create indirect graphics pipeline!");
+        }
+    }
+
+    // SECOND PASS PIPELINE
+    VkPipelineShaderStageCreateInfo secondPassShaderStages[2];
+    secondPassShaderStages[0] = createShaderStage("shaders/second_pass_vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+    secondPassShaderStages[1] = createShaderStage("shaders/second_pass_frag.spv", VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    vertexInputInfo.vertexBindingDescriptionCount = 0;
+    vertexInputInfo.pVertexBindingDescriptions = nullptr;
+    vertexInputInfo.vertexAttributeDescriptionCount = 0;
+    vertexInputInfo.pVertexAttributeDescriptions = nullptr;
+
+    depthStencilCreateInfo.depthWriteEnable = VK_FALSE;
+    
+    VkPipelineLayoutCreateInfo secondPipelineLayoutCreateInfo = {};
+    secondPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    secondPipelineLayoutCreateInfo.setLayoutCount = 1;
+    secondPipelineLayoutCreateInfo.pSetLayouts = &inputSetLayout;
+    secondPipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+    secondPipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+    result = vkCreatePipelineLayout(device->getLogicalDevice(), &secondPipelineLayoutCreateInfo, nullptr, &secondPipelineLayout);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create second pipeline layout!");
+    }
+
+    pipelineInfo.pStages = secondPassShaderStages;
+    pipelineInfo.layout = secondPipelineLayout;
+    pipelineInfo.subpass = 1;
+
+    // create second pass pipeline
+    result = vkCreateGraphicsPipelines(device->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &secondPipeline);
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create graphics pipeline! Error code: " << result << std::endl;
+        throw std::runtime_error("Failed to create graphics pipeline!");
+    }
+}
+
+void Renderer::createColorBufferImage()
+{
+    colorBufferImages.resize(swapchain->getImageCount());
+    colorBufferImageMemory.resize(swapchain->getImageCount());
+    colorBufferImageViews.resize(swapchain->getImageCount());
+
+    VkFormat colorFormat = findColorFormat();
+
+    for (size_t i = 0; i < swapchain->getImageCount(); i++)
+    {
+        createImage(swapchain->getExtent().width,
+                    swapchain->getExtent().height,
+                    colorFormat,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    &colorBufferImages[i],
+                    &colorBufferImageMemory[i],
+                    attachmentMemoryPool);
+
+        colorBufferImageViews[i] = createImageView(colorBufferImages[i], colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+}
+
+void Renderer::createDepthBufferImage()
+{
+
+    depthBufferImages.resize(swapchain->getImageCount());
+    depthBufferImageMemory.resize(swapchain->getImageCount());
+    depthBufferImageViews.resize(swapchain->getImageCount());
+
+    VkFormat depthFormat = findDepthFormat();
+
+    for (size_t i = 0; i < swapchain->getImageCount(); i++)
+    {
+        createImage(swapchain->getExtent().width, swapchain->getExtent().height,
+            depthFormat,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &depthBufferImages[i],
+            &depthBufferImageMemory[i],
+            attachmentMemoryPool);
+        depthBufferImageViews[i] = createImageView(depthBufferImages[i], depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+    }
+}
+
+// Create framebuffers for each swapchain image view
+void Renderer::createFramebuffers() 
+{
+    framebuffers.resize(swapchain->getImageCount());
+
+    for (size_t i = 0; i < framebuffers.size(); i++) 
+    {
+        std::array<VkImageView, 3> attachments = {  swapchain->getImageView(i),
+                                                    colorBufferImageViews[i],
+                                                    depthBufferImageViews[i]
+                                                 };
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = swapchain->getExtent().width;
+        framebufferInfo.height = swapchain->getExtent().height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device->getLogicalDevice(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("Failed to create framebuffer!");
+        }
+    }
+}
+
+void Renderer::createTextureSampler() {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &properties);
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = device->supportsSamplerAnisotropy() ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = device->supportsSamplerAnisotropy() ? properties.limits.maxSamplerAnisotropy : 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;                // every level the texture has
+    samplerInfo.mipLodBias = 0.0f;
+
+    // Allocate memory for sampler
+    
+    if (vkCreateSampler(device->getLogicalDevice(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create texture sampler!");
+    }
+
+}
+
+
+// Create the ring of frame contexts and everything they own
+void Renderer::createFrameContexts(uint32_t frameCount)
+{
+    frameCount = std::max(1u, std::min(frameCount, MAX_FRAMES_IN_FLIGHT_LIMIT));
+    frames.resize(frameCount);
+
+    for (FrameContext& frame : frames)
+    {
+        createFrameCommandBuffers(frame);
+        createFrameSyncObjects(frame);
+        createFrameDescriptorArena(frame);
+    }
+
+    createUniformBuffers();
+    createDescriptorSets();
+
+    gpuProfiler.create(device->getLogicalDevice(), device->getPhysicalDevice(),
+        device->getGraphicsQueueFamilyIndex(), frameCount);
+    staticDrawScope = gpuProfiler.registerFixedScope("Static draws");
+
+    currentFrame = 0;
+    imagesInFlight.assign(swapchain->getImageCount(), 0);
+
+    Logger::info("Frames in flight: " + std::to_string(frameCount));
+}
+
+// Destroy the frame contexts, caller makes sure none of them is in flight
+void Renderer::destroyFrameContexts()
+{
+    VkDevice logicalDevice = device->getLogicalDevice();
+
+    for (FrameContext& frame : frames)
+    {
+        if (frame.commandPool != VK_NULL_HANDLE)
+        {
+            vkDestroyCommandPool(logicalDevice, frame.commandPool, nullptr);
+        }
+        for (ThreadCommands& thread : frame.threadCommands)
+        {
+            vkDestroyCommandPool(logicalDevice, thread.commandPool, nullptr);
+        }
+        if (frame.staticCommandPool != VK_NULL_HANDLE)
+        {
+            vkDestroyCommandPool(logicalDevice, frame.staticCommandPool, nullptr);
+        }
+        for (StaticBundle& bundle : frame.staticBundles)
+        {
+            if (bundle.instanceBuffer != VK_NULL_HANDLE)
+            {
+                destroyBuffer(logicalDevice, device->getAllocator(), bundle.instanceBuffer, bundle.instanceMemory);
+            }
+        }
+        if (frame.staticDescriptorPool != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(logicalDevice, frame.staticDescriptorPool, nullptr);
+        }
+        if (frame.descriptorArena != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(logicalDevice, frame.descriptorArena, nullptr);
+        }
+        if (frame.instanceBuffer != VK_NULL_HANDLE)
+        {
+            destroyBuffer(logicalDevice, device->getAllocator(), frame.instanceBuffer, frame.instanceMemory);
+        }
+        if (frame.renderFinishedSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(logicalDevice, frame.renderFinishedSemaphore, nullptr);
+        }
+        if (frame.imageAvailableSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(logicalDevice, frame.imageAvailableSemaphore, nullptr);
+        }
+    }
+    frames.clear();
+    imagesInFlight.assign(imagesInFlight.size(), 0);
+
+    gpuProfiler.cleanup();
+
+    // view projection descriptor sets are freed with the pool
+    if (descriptorPool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
+        descriptorPool = VK_NULL_HANDLE;
+    }
+
+    destroyBuffer(logicalDevice, device->getAllocator(), vpUniformBuffer, vpUniformBufferMemory);
+}
+
+void Renderer::createFrameCommandBuffers(FrameContext& frame)
+{
+    // Command buffers are re-recorded every frame, so the whole pool is reset at once
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = device->getGraphicsQueueFamilyIndex();
+
+    if (vkCreateCommandPool(device->getLogicalDevice(), &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create frame command pool!");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = frame.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(device->getLogicalDevice(), &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate command buffers!");
+    }
+
+    // One pool for every recording thread, secondaries are allocated from them on demand
+    frame.threadCommands.resize(jobSystem.getThreadCount());
+    for (ThreadCommands& thread : frame.threadCommands)
+    {
+        if (vkCreateCommandPool(device->getLogicalDevice(), &poolInfo, nullptr, &thread.commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create recording thread command pool!");
+        }
+    }
+
+    // Static bundles are re-recorded one at a time
+    VkCommandPoolCreateInfo staticPoolInfo{};
+    staticPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    staticPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    staticPoolInfo.queueFamilyIndex = device->getGraphicsQueueFamilyIndex();
+
+    if (vkCreateCommandPool(device->getLogicalDevice(), &staticPoolInfo, nullptr, &frame.staticCommandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create static bundle command pool!");
+    }
+}
+
+// Create the swapchain semaphores of a frame
+void Renderer::createFrameSyncObjects(FrameContext& frame)
+{
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    // No fence, the frame is complete once the GPU timeline reaches its value
+    frame.timelineValue = 0;
+
+    if (vkCreateSemaphore(device->getLogicalDevice(), &semaphoreInfo, nullptr, &frame.imageAvailableSemaphore) != VK_SUCCESS ||
+        vkCreateSemaphore(device->getLogicalDevice(), &semaphoreInfo, nullptr, &frame.renderFinishedSemaphore) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create synchronization objects for a frame!");
+    }
+}
+
+void Renderer::createFrameDescriptorArena(FrameContext& frame)
+{
+    std::array<VkDescriptorPoolSize, 3> poolSizes = {};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSizes[0].descriptorCount = FRAME_DESCRIPTOR_ARENA_SIZE;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = FRAME_DESCRIPTOR_ARENA_SIZE;
+    poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[2].descriptorCount = FRAME_DESCRIPTOR_ARENA_SIZE;
+
+    VkDescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = FRAME_DESCRIPTOR_ARENA_SIZE;
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolCreateInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(device->getLogicalDevice(), &poolCreateInfo, nullptr, &frame.descriptorArena) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a frame descriptor arena!");
+    }
+
+    // Instance sets of the static bundles live as long as their bundles, the pool is never reset
+    VkDescriptorPoolSize staticPoolSize = {};
+    staticPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    staticPoolSize.descriptorCount = MAX_INSTANCED_STATIC_BUNDLES;
+
+    VkDescriptorPoolCreateInfo staticPoolCreateInfo = {};
+    staticPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    staticPoolCreateInfo.maxSets = MAX_INSTANCED_STATIC_BUNDLES;
+    staticPoolCreateInfo.poolSizeCount = 1;
+    staticPoolCreateInfo.pPoolSizes = &staticPoolSize;
+
+    if (vkCreateDescriptorPool(device->getLogicalDevice(), &staticPoolCreateInfo, nullptr, &frame.staticDescriptorPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a static bundle descriptor pool!");
+    }
+}
+
+// Allocate a descriptor set that is only valid until this frame context is reused
+VkDescriptorSet Renderer::allocateFrameDescriptorSet(FrameContext& frame, VkDescriptorSetLayout layout)
+{
+    VkDescriptorSetAllocateInfo setAllocInfo = {};
+    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocInfo.descriptorPool = frame.descriptorArena;
+    setAllocInfo.descriptorSetCount = 1;
+    setAllocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptorSet;
+    if (vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, &descriptorSet) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate frame descriptor set!");
+    }
+    return descriptorSet;
+}
+
+void Renderer::createDescriptorPools()
+{
+    // ViewProjection pool is owned by the frame contexts, see createDescriptorSets
+
+    // create texture sampler pool, streamed textures swap in new sets and free the old ones
+    VkDescriptorPoolSize samplerPoolSize = {};
+    samplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerPoolSize.descriptorCount = MAX_OBJECTS + STREAMING_SPARE_DESCRIPTOR_SETS;
+    
+    VkDescriptorPoolCreateInfo samplerPoolCreateInfo = {};
+    samplerPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    samplerPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    samplerPoolCreateInfo.maxSets = MAX_OBJECTS + STREAMING_SPARE_DESCRIPTOR_SETS;
+    samplerPoolCreateInfo.poolSizeCount = 1;
+    samplerPoolCreateInfo.pPoolSizes = &samplerPoolSize;
+
+    VkResult result = vkCreateDescriptorPool(device->getLogicalDevice(), &samplerPoolCreateInfo, nullptr, &samplerDescriptorPool);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a sampler descriptor pool!");
+    }
+
+    // create input attachment descriptor pool
+    VkDescriptorPoolSize colorInputPoolSize = {};
+    colorInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    colorInputPoolSize.descriptorCount = static_cast<uint32_t>(colorBufferImageViews.size());
+
+    VkDescriptorPoolSize depthInputPoolSize = {};
+    depthInputPoolSize.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    depthInputPoolSize.descriptorCount = static_cast<uint32_t>(depthBufferImageViews.size());
+
+    std::vector<VkDescriptorPoolSize> inputPoolSizes = { colorInputPoolSize, depthInputPoolSize };
+
+    VkDescriptorPoolCreateInfo inputPoolCreateInfo = {};
+    inputPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    inputPoolCreateInfo.maxSets = swapchain->getImageCount();
+    inputPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(inputPoolSizes.size());
+    inputPoolCreateInfo.pPoolSizes = inputPoolSizes.data();
+    result = vkCreateDescriptorPool(device->getLogicalDevice(), &inputPoolCreateInfo, nullptr, &inputDescriptorPool);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a input descriptor pool!");
+    }
+}
+
+void Renderer::createDescriptorSets()
+{
+    // ViewProjection pool, one set for each frame context
+    VkDescriptorPoolSize vpPoolSize = {};
+    vpPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    vpPoolSize.descriptorCount = static_cast<uint32_t>(frames.size());
+
+    // Model pool dynamic
+    /* used with model dynamic buffers
+    VkDescriptorPoolSize modelPoolSize = {};
+    modelPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    modelPoolSize.descriptorCount = static_cast<uint32_t>(modelDynUniformBuffers.size());
+
+    std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize, modelPoolSize };
+*/
+    std::vector<VkDescriptorPoolSize> descriptorPoolSizes = { vpPoolSize };
+    VkDescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = static_cast<uint32_t>(frames.size());
+    poolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
+    poolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
+
+    VkResult result = vkCreateDescriptorPool(device->getLogicalDevice(), &poolCreateInfo, nullptr, &descriptorPool);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create a descriptor pool!");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(frames.size(), descriptorSetLayout);
+    std::vector<VkDescriptorSet> descriptorSets(frames.size());
+
+    VkDescriptorSetAllocateInfo setAllocInfo = {};
+    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocInfo.descriptorPool = descriptorPool;
+    setAllocInfo.descriptorSetCount = static_cast<uint32_t>(frames.size());
+    setAllocInfo.pSetLayouts = setLayouts.data();
+
+    // Alocate descriptor sets
+    result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocInfo, descriptorSets.data());
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate descriptor sets!");
+    }
+
+    // Update all of descriptor set buffer bindings
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i].vpDescriptorSet = descriptorSets[i];
+
+        // ViewProjection Descriptor, points at the slice of this frame.
+        VkDescriptorBufferInfo vpBufferInfo = {};
+        vpBufferInfo.buffer = vpUniformBuffer;
+        vpBufferInfo.offset = frames[i].uniformOffset;
+        vpBufferInfo.range = sizeof(UboViewProjection);
+
+        VkWriteDescriptorSet vpSetWrite = {};
+        vpSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        vpSetWrite.dstSet = frames[i].vpDescriptorSet;
+        vpSetWrite.dstBinding = 0;
+        vpSetWrite.dstArrayElement = 0;
+        vpSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        vpSetWrite.descriptorCount = 1;
+        vpSetWrite.pBufferInfo = &vpBufferInfo;
+
+        // Model descriptor.
+        /* left for example if dynamic buffer usage, not in use with push constant for model transform
+        VkDescriptorBufferInfo modelBufferInfo = {};
+        modelBufferInfo.buffer = modelDynUniformBuffers[i];
+        modelBufferInfo.offset = 0;
+        modelBufferInfo.range = modelUniformAlignment;
+
+        VkWriteDescriptorSet modelSetWrite = {};
+        modelSetWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        modelSetWrite.dstSet = frames[i].vpDescriptorSet;
+        modelSetWrite.dstBinding = 1;
+        modelSetWrite.dstArrayElement = 0;
+        modelSetWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        modelSetWrite.descriptorCount = 1;
+        modelSetWrite.pBufferInfo = &modelBufferInfo;
+        
+        std::vector< VkWriteDescriptorSet> setWrites = { vpSetWrite, modelSetWrite };
+        */
+        std::vector< VkWriteDescriptorSet> setWrites = { vpSetWrite };
+
+        // update the descriptor sets with new buffer/binding info.
+        vkUpdateDescriptorSets(device->getLogicalDevice(),
+                                static_cast<uint32_t>(setWrites.size()), 
+                                setWrites.data(), 
+                                0, nullptr);
+    }
+}
+
+int Renderer::createTextureDescriptor(VkImageView textureImage)
+{
+    invalidateStaticBundles();
+
+    samplerDescriptorSets.push_back(allocateTextureDescriptorSet(textureImage));
+
+    return samplerDescriptorSets.size() - 1;
+}
+
+VkDescriptorSet Renderer::allocateTextureDescriptorSet(VkImageView textureImage)
+{
+    VkDescriptorSet descriptorSet;
+    
+    VkDescriptorSetAllocateInfo setAllocateInfo = {};
+    setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocateInfo.descriptorPool = samplerDescriptorPool;
+    setAllocateInfo.descriptorSetCount = 1;
+    setAllocateInfo.pSetLayouts = &samplerSetLayout;
+
+    VkResult result = vkAllocateDescriptorSets(device->getLogicalDevice(), &setAllocateInfo, &descriptorSet);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate texture descriptor set!");
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = textureImage;
+    imageInfo.sampler = textureSampler;
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = descriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device->getLogicalDevice(), 1, &descriptorWrite, 0, nullptr);
+
+    return descriptorSet;
+}
+
+int Renderer::createMeshModel(std::string modelPath, std::string modelFile)
+{
+    PROFILE_ZONE("Renderer::createMeshModel");
+
+    // Same import as the background loads, geometry comes straight from the mapped cache when the file was imported before
+    ImportedModel imported = AssetLoader::importModel(modelPath, modelFile);
+    const std::vector<std::string>& textureNames = imported.textureNames;
+    std::vector<MeshView> meshViews = imported.getMeshViews();
+
+    // Decode the images that are not loaded yet on every thread, each one once
+    std::vector<std::string> imagePaths;
+    for (const std::string& textureName : textureNames)
+    {
+        std::string path = modelPath + textureName;
+        if (!textureName.empty() && textures.find(path) == textures.end() &&
+            std::find(imagePaths.begin(), imagePaths.end(), path) == imagePaths.end())
+        {
+            imagePaths.push_back(path);
+        }
+    }
+
+    std::vector<DecodedImage> images(imagePaths.size());
+    std::vector<std::string> errors(imagePaths.size());
+    jobSystem.dispatch(static_cast<uint32_t>(imagePaths.size()), [&](uint32_t image, uint32_t)
+    {
+        try {
+            images[image] = AssetLoader::decodeImage(imagePaths[image]);
+        }
+        catch (const std::exception& e) {
+            errors[image] = e.what();
+        }
+    });
+
+    for (const std::string& error : errors)
+    {
+        if (!error.empty())
+        {
+            throw std::runtime_error(error);
+        }
+    }
+
+    // Uploads are recorded into the current batch, submitted together with the geometry
+    for (const DecodedImage& image : images)
+    {
+        createTexture(image);
+    }
+
+    std::vector<int> matToTex(textureNames.size());
+    for (size_t i = 0; i < textureNames.size(); ++i)
+    {
+        matToTex[i] = textureNames[i].empty() ? placeholderTextureId : textures[modelPath + textureNames[i]].textId;
+    }
+
+    // Copied into the staging ring here, the cache can be unmapped afterwards
+    std::vector<Mesh> modelMeshes;
+    for (const MeshView& mesh : meshViews)
+    {
+        int textureId = mesh.materialIndex < matToTex.size() ? matToTex[mesh.materialIndex] : placeholderTextureId;
+        modelMeshes.emplace_back(device, mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount, textureId);
+    }
+
+    uint32_t root = sceneGraph.createNode();
+    uint32_t content = createSceneNodes(root, imported.nodes, meshViews, modelMeshes);
+    return addMeshModel(modelMeshes, root, content);
+}
+
+int Renderer::loadMeshModelAsync(std::string modelPath, std::string modelFile)
+{
+    PROFILE_ZONE("Renderer::loadMeshModelAsync");
+
+    DecodedMesh box = MeshModel::createBoxMesh(glm::vec3(0.0f), 0.5f);
+    int modelIndex = createMeshModel({ Mesh(device, box.vertices, box.indices, placeholderTextureId) });
+
+    loadingModels.push_back(modelIndex);
+    assetLoader.loadModel(modelIndex, modelPath, modelFile);
+    return modelIndex;
+}
+
+// Nodes are created depth first, which only appends to the scene graph
+uint32_t Renderer::createSceneNodes(uint32_t root, const std::vector<DecodedNode>& nodes, const std::vector<MeshView>& views,
+                                    std::vector<Mesh>& meshes)
+{
+    uint32_t content = sceneGraph.createNode(root);
+
+    std::vector<uint32_t> handles(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        uint32_t parent = nodes[i].parent >= 0 ? handles[nodes[i].parent] : content;
+        handles[i] = sceneGraph.createNode(parent, nodes[i].transform);
+    }
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        meshes[i].setSceneNode(views[i].node < handles.size() ? handles[views[i].node] : content);
+    }
+    return content;
+}
+
+void Renderer::updateScene()
+{
+    // Model transforms are set on the MeshModel, the changed ones go into the scene graph
+    for (MeshModel& meshModel : modelList)
+    {
+        uint32_t node = meshModel.getSceneNode();
+        if (sceneGraph.isValid(node) && sceneGraph.getLocalTransform(node) != meshModel.getModel().model)
+        {
+            sceneGraph.setLocalTransform(node, meshModel.getModel().model);
+        }
+    }
+    sceneNodesUpdated = sceneGraph.update(&jobSystem);
+}
+
+bool Renderer::isMeshModelLoading(size_t index) const
+{
+    return std::find(loadingModels.begin(), loadingModels.end(), index) != loadingModels.end();
+}
+
+void Renderer::processLoadedModels()
+{
+    PROFILE_ZONE("Renderer::processLoadedModels");
+
+    UploadEngine& uploadEngine = device->getUploadEngine();
+
+    // Real data is resident, the placeholder goes once the frames drawing it are done
+    for (size_t i = 0; i < uploadingModels.size();)
+    {
+        UploadingModel& uploading = uploadingModels[i];
+        if (!uploadEngine.isComplete(uploading.uploadValue))
+        {
+            ++i;
+            continue;
+        }
+
+        MeshModel& meshModel = modelList[uploading.modelIndex];
+        sceneGraph.destroyNode(meshModel.getContentNode());
+        meshModel.replaceMeshes(uploading.meshes);
+        meshModel.setSceneNodes(meshModel.getSceneNode(), uploading.contentNode);
+        loadingModels.erase(std::find(loadingModels.begin(), loadingModels.end(), uploading.modelIndex));
+        uploadingModels.erase(uploadingModels.begin() + i);
+    }
+
+    std::vector<DecodedModel> decodedModels = assetLoader.takeLoaded();
+    if (decodedModels.empty())
+    {
+        return;
+    }
+
+    size_t firstNew = uploadingModels.size();
+    for (DecodedModel& decoded : decodedModels)
+    {
+        if (!decoded.error.empty())
+        {
+            // Keeps its placeholder
+            Logger::error(decoded.error);
+            loadingModels.erase(std::find(loadingModels.begin(), loadingModels.end(), decoded.modelIndex));
+            continue;
+        }
+
+        std::vector<int> imageTextures;
+        for (const DecodedImage& image : decoded.images)
+        {
+            auto existing = textures.find(image.path);
+            Texture* texture = existing != textures.end() ? &existing->second :
+                createTexture(image);
+            imageTextures.push_back(texture->textId);
+        }
+
+        UploadingModel uploading;
+        uploading.modelIndex = decoded.modelIndex;
+        std::vector<MeshView> meshViews = decoded.geometry.getMeshViews();
+        for (const MeshView& mesh : meshViews)
+        {
+            int image = mesh.materialIndex < decoded.materialImages.size() ? decoded.materialImages[mesh.materialIndex] : -1;
+            uploading.meshes.emplace_back(device, mesh.vertices, mesh.vertexCount, mesh.indices, mesh.indexCount,
+                image >= 0 ? imageTextures[image] : placeholderTextureId);
+        }
+        // Next to the placeholder's content until the swap
+        uploading.contentNode = createSceneNodes(modelList[decoded.modelIndex].getSceneNode(), decoded.geometry.nodes, meshViews, uploading.meshes);
+        uploadingModels.push_back(std::move(uploading));
+    }
+
+    // Everything that arrived this frame goes in one batch
+    uint64_t uploadValue = uploadEngine.flush();
+    for (size_t i = firstNew; i < uploadingModels.size(); ++i)
+    {
+        uploadingModels[i].uploadValue = uploadValue;
+    }
+}
+
+int Renderer::createMeshModel(const std::vector<Mesh>& meshes)
+{
+    uint32_t root = sceneGraph.createNode();
+    return addMeshModel(meshes, root, sceneGraph.createNode(root));
+}
+
+int Renderer::addMeshModel(const std::vector<Mesh>& meshes, uint32_t root, uint32_t content)
+{
+    // Submit all copies of the model in one batch, later graphics submissions see the data
+    device->getUploadEngine().flush();
+
+    MeshModel meshModel = MeshModel(meshes);
+    for (size_t i = 0; i < meshModel.getMeshCount(); ++i)
+    {
+        Mesh* mesh = meshModel.getMesh(i);
+        if (!sceneGraph.isValid(mesh->getSceneNode()))
+        {
+            mesh->setSceneNode(content);
+        }
+    }
+    meshModel.setSceneNodes(root, content);
+    modelList.push_back(meshModel);
+    invalidateStaticBundles();
+    return modelList.size() - 1;
+}
+
+void Renderer::destroyMeshModel(size_t index)
+{
+    if (index >= modelList.size())
+    {
+        return;
+    }
+
+    // Stop a background load, meshes already uploaded for it are freed like the model's own
+    if (isMeshModelLoading(index))
+    {
+        assetLoader.cancel(index);
+        for (auto uploading = uploadingModels.begin(); uploading != uploadingModels.end(); ++uploading)
+        {
+            if (uploading->modelIndex == index)
+            {
+                MeshModel(uploading->meshes).destroyMeshModel();
+                uploadingModels.erase(uploading);
+                break;
+            }
+        }
+        loadingModels.erase(std::find(loadingModels.begin(), loadingModels.end(), index));
+    }
+
+    // Frames in flight may still draw the model, the arena holds its ranges back until they are done
+    sceneGraph.destroyNode(modelList[index].getSceneNode());
+    modelList[index].destroyMeshModel();
+    modelList[index] = MeshModel();
+    invalidateStaticBundles();
+}
+
+void Renderer::createUniformBuffers()
+{
+    // One buffer for all frame contexts, every frame writes its own aligned slice
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &deviceProperties);
+    VkDeviceSize alignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+
+    // viewProjection slice size.
+    vpUniformSliceSize = sizeof(UboViewProjection);
+    if (alignment > 0)
+    {
+        vpUniformSliceSize = (vpUniformSliceSize + alignment - 1) & ~(alignment - 1);
+    }
+
+    // model buffer size
+    //VkDeviceSize modelBufferSize = modelUniformAlignment * MAX_OBJECTS;
+
+    //modelDynUniformBuffers.resize(swapchain->getImageCount());
+    //modelDynUniformBuffersMemory.resize(swapchain->getImageCount());
+
+    // Host visible memory is persistently mapped by the allocator
+    createBuffer(device->getLogicalDevice(), device->getAllocator(), vpUniformSliceSize * frames.size(), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        vpUniformBuffer, vpUniformBufferMemory);
+    void* data = vpUniformBufferMemory.mapped;
+
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i].uniformOffset = vpUniformSliceSize * i;
+        frames[i].uniformMapped = static_cast<char*>(data) + frames[i].uniformOffset;
+
+        /*
+        createBuffer(device->getLogicalDevice(), device->getPhysicalDevice(), modelBufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            modelDynUniformBuffers[i], modelDynUniformBuffersMemory[i]);
+            */
+    }
+
+}
+
+void Renderer::updateUniformBuffers(FrameContext& frame)
+{
+    PROFILE_ZONE("Renderer::updateUniformBuffers");
+
+    if (frame.uniformMapped == nullptr) {
+        // Skip updating if no uniform buffer is available
+        return;
+    }
+
+    // ViewProjection data, the slice is not read by the GPU until this frame is submitted
+    memcpy(frame.uniformMapped, &uboViewProjection, sizeof(UboViewProjection));
+
+    // Model data
+
+    /* this is not in use now, left for example of updating uniform dynamic buffer!
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        Model* model = (Model*)((uint64_t)modelTransferSpace + (i * modelUniformAlignment));
+        *model = meshes[i]->getModel();
+    }
+
+    result = vkMapMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[imageIndex], 0, modelUniformAlignment * meshes.size(), 0, &data);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to map model uniform buffer memory!");
+    }
+    memcpy(data, modelTransferSpace, modelUniformAlignment * meshes.size());
+    vkUnmapMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[imageIndex]);
+    */
+}
+
+
+VkPipelineShaderStageCreateInfo Renderer::createShaderStage(const std::string& filepath, VkShaderStageFlagBits stage)
+{
+    // Read the shader code from file
+    std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open shader file: " + filepath);
+    }
+
+    size_t fileSize = (size_t)file.tellg();
+    std::vector<char> buffer(fileSize);
+
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+    file.close();
+
+    // Create shader module
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = buffer.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(device->getLogicalDevice(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create shader module: " + filepath);
+    }
+
+    // Store the shader module for later cleanup
+    shaderModules.push_back(shaderModule); // Add the created shader module to the vector
+
+    // Create shader stage info
+    VkPipelineShaderStageCreateInfo shaderStageInfo{};
+    shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageInfo.stage = stage;
+    shaderStageInfo.module = shaderModule;
+    shaderStageInfo.pName = "main";  // Entry point for the shader
+
+    return shaderStageInfo; // Return the created shader stage info
+}
+
+void Renderer::allocateDynamicBufferTransferSpace()
+{
+    /*
+    modelUniformAlignment = (sizeof(Model) + minUniformBufferOffset - 1) & ~(minUniformBufferOffset - 1);
+
+    // create space in memory to hold dynamic buffer aligned to required alignment and hold max objects.
+    modelTransferSpace = (Model*)_aligned_malloc(modelUniformAlignment * MAX_OBJECTS, modelUniformAlignment);
+    if (!modelTransferSpace) {
+        throw std::runtime_error("Failed to allocate aligned memory for modelTransferSpace.");
+    }
+    */
+}
+
+void Renderer::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags, VkImage* image, Allocation* imageMemory, uint32_t linearPool, uint32_t mipLevels)
+{
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = width;
+    imageInfo.extent.height = height;
+    imageInfo.extent.depth = 1;                             // Single layer
+    imageInfo.mipLevels = mipLevels;                        // number of mipmap levels
+    imageInfo.arrayLayers = 1;                              // Single image
+    imageInfo.format = format;                              // Format (e.g., depth format)
+    imageInfo.tiling = tiling;                              // Tiling (e.g., optimal tiling)
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;    // Initial layout
+    imageInfo.usage = usageFlags;                           // Usage flags (e.g., depth-stencil attachment)
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;              // Single sample (no multisampling)
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;      // Exclusive access, wether image can be shared between queues
+
+    // Create the image
+    if (vkCreateImage(device->getLogicalDevice(), &imageInfo, nullptr, image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image!");
+    }
+
+    // Get memory requirements
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device->getLogicalDevice(), *image, &memRequirements);
+
+    // Sub-allocate memory, from the linear pool when one is given
+    if (linearPool != INVALID_LINEAR_POOL)
+    {
+        *imageMemory = device->getAllocator().allocateLinear(linearPool, memRequirements, memoryPropertyFlags);
+    }
+    else
+    {
+        *imageMemory = device->getAllocator().allocate(memRequirements, memoryPropertyFlags, ResourceType::Image);
+    }
+
+    // Bind memory to the image
+    vkBindImageMemory(device->getLogicalDevice(), *image, imageMemory->memory, imageMemory->offset);
+
+}
+
+VkImageView Renderer::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+
+    // Define the subresource range (for depth, color, etc.)
+    viewInfo.subresourceRange.aspectMask = aspectFlags;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = mipLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView imageView;
+    if (vkCreateImageView(device->getLogicalDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) 
+    {
+        throw std::runtime_error("Failed to create image view!");
+    }
+
+    return imageView;
+}
+
+VkFormat Renderer::findDepthFormat()
+{
+    return findSupportedFormat(
+        { VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT },
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+    );
+}
+
+VkFormat Renderer::findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
+{
+    for (VkFormat format : candidates)
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), format, &props);
+
+        if (tiling == VK_IMAGE_TILING_LINEAR && (props.linearTilingFeatures & features) == features) 
+        {
+            return format;
+        }
+        else if (tiling == VK_IMAGE_TILING_OPTIMAL && (props.optimalTilingFeatures & features) == features)
+        {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("Failed to find a supported depth format!");
+}
+
+bool Renderer::supportsLinearBlit(VkFormat format)
+{
+    const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), format, &props);
+    return (props.optimalTilingFeatures & features) == features;
+}
+
+void Renderer::createTextureImage(uint32_t width, uint32_t height, const void* pixels, Texture& texture)
+{
+    texture.mipLevels = getMipLevelCount(width, height);
+
+    // Create Vulkan image, transfer source as well for blitting the mip chain
+    createImage(width, height, texture.format,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture.image, &texture.memory, INVALID_LINEAR_POOL, texture.mipLevels);
+
+    // Transition, copy through the staging ring and transition for shader sampling, all in the current upload batch.
+    // The mip chain is blitted on the GPU, or downsampled here when the format cannot be filtered in blits
+    if (supportsLinearBlit(texture.format))
+    {
+        device->getUploadEngine().uploadImageGenerateMips(texture.image, width, height, 4, pixels, texture.mipLevels); // RGBA (4 bytes per pixel)
+    }
+    else
+    {
+        std::vector<unsigned char> mipChain = buildMipChainRgba8(pixels, width, height, texture.mipLevels);
+        device->getUploadEngine().uploadImage(texture.image, width, height, 4, mipChain.data(), texture.mipLevels);
+    }
+}
+
+void Renderer::createContainerImage(const TextureContainer& container, Texture& texture)
+{
+    VkFormatProperties props;
+    vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), container.getFormat(), &props);
+
+    // Mips the file asks for are built like those of any RGBA8 image, block compressed
+    // levels cannot be blitted so those files keep their base level alone
+    bool generateMips = container.requestsGeneratedMips() && container.getBlock().width == 1;
+    if (container.requestsGeneratedMips() && !generateMips)
+    {
+        Logger::warning("Cannot generate mips of a block compressed texture, using the base level only");
+    }
+
+    if (generateMips || !(props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        // e.g. BC formats on mobile GPUs, the mips are rebuilt from the decoded base level
+        if (!generateMips)
+        {
+            Logger::warning("Texture format not supported by the device, decoding to RGBA8");
+        }
+        std::vector<unsigned char> pixels = container.decodeRgba8();
+        texture.format = container.getFallbackFormat();
+        createTextureImage(container.getWidth(), container.getHeight(), pixels.data(), texture);
+        return;
+    }
+
+    texture.format = container.getFormat();
+    texture.mipLevels = container.getLevelCount();
+    createImage(container.getWidth(), container.getHeight(), texture.format,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture.image, &texture.memory, INVALID_LINEAR_POOL, texture.mipLevels);
+
+    // Straight from the mapped file into the staging ring
+    device->getUploadEngine().uploadImageLevels(texture.image, container.getWidth(), container.getHeight(),
+        container.getBlock(), container.getLevels());
+}
+
+// A neutral grey checker, drawn for loading models and for materials without a texture
+void Renderer::createPlaceholderTexture()
+{
+    const uint32_t pixels[4] = { 0xffc0c0c0, 0xff808080, 0xff808080, 0xffc0c0c0 };
+    placeholderTextureId = createTexture(PLACEHOLDER_TEXTURE_NAME, 2, 2, pixels)->textId;
+    device->getUploadEngine().flush();
+}
+
+Texture* Renderer::createTexture(const std::string& name, uint32_t width, uint32_t height, const void* pixels)
+{
+    Texture texture;
+    createTextureImage(width, height, pixels, texture);
+    texture.imageView = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+    texture.textId = createTextureDescriptor(texture.imageView);
+
+    textures[name] = texture;
+    return &textures[name];
+}
+
+Texture* Renderer::createTexture(const DecodedImage& image)
+{
+    uint32_t levelCount = image.container ? image.container->getLevelCount() : getMipLevelCount(image.width, image.height);
+    if (textureStreamingEnabled && TextureStreamer::getTailLevel(image.width, image.height, levelCount) > 0)
+    {
+        return createStreamedTexture(image);
+    }
+
+    if (!image.container)
+    {
+        return createTexture(image.path, image.width, image.height, image.pixels.get());
+    }
+
+    Texture texture;
+    createContainerImage(*image.container, texture);
+    texture.imageView = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+    texture.textId = createTextureDescriptor(texture.imageView);
+
+    textures[image.path] = texture;
+    return &textures[image.path];
+}
+
+Texture* Renderer::createStreamedTexture(const DecodedImage& image)
+{
+    PROFILE_ZONE("Renderer::createStreamedTexture");
+
+    StreamingSource source;
+    source.name = image.path;
+    source.width = image.width;
+    source.height = image.height;
+
+    VkFormatProperties props = {};
+    if (image.container)
+    {
+        vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), image.container->getFormat(), &props);
+    }
+
+    if (image.container && (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+    {
+        // Levels are read from the mapped file whenever they become resident
+        source.format = image.container->getFormat();
+        source.block = image.container->getBlock();
+        source.container = image.container;
+        source.levels = image.container->getLevels();
+    }
+    else
+    {
+        // Every level is built up front, streaming in only copies them
+        std::vector<unsigned char> decoded;
+        const void* pixels = image.pixels.get();
+        source.format = VK_FORMAT_R8G8B8A8_SRGB;
+        if (image.container)
+        {
+            Logger::warning("Texture format not supported by the device, decoding to RGBA8");
+            decoded = image.container->decodeRgba8();
+            pixels = decoded.data();
+            source.format = image.container->getFallbackFormat();
+        }
+
+        uint32_t levelCount = getMipLevelCount(image.width, image.height);
+        source.mipChain = buildMipChainRgba8(pixels, image.width, image.height, levelCount);
+
+        size_t offset = 0;
+        for (uint32_t level = 0; level < levelCount; ++level)
+        {
+            source.levels.push_back(source.mipChain.data() + offset);
+            offset += getMipLevelSize(image.width, image.height, level, source.block);
+        }
+    }
+
+    // Only the tail is resident to start with
+    uint32_t levelCount = static_cast<uint32_t>(source.levels.size());
+    uint32_t tail = TextureStreamer::getTailLevel(source.width, source.height, levelCount);
+
+    Texture texture;
+    createStreamedImage(source, tail, texture);
+    texture.textId = createTextureDescriptor(texture.imageView);
+
+    textureStreamer.addTexture(texture.textId, source.width, source.height, levelCount, source.block);
+    streamingSources[texture.textId] = std::move(source);
+
+    textures[image.path] = texture;
+    return &textures[image.path];
+}
+
+void Renderer::createStreamedImage(const StreamingSource& source, uint32_t level, Texture& texture)
+{
+    uint32_t width = getMipExtent(source.width, level);
+    uint32_t height = getMipExtent(source.height, level);
+
+    // Level 0 of the image is the first resident level of the texture
+    texture.format = source.format;
+    texture.mipLevels = static_cast<uint32_t>(source.levels.size()) - level;
+    createImage(width, height, texture.format,
+        VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture.image, &texture.memory, INVALID_LINEAR_POOL, texture.mipLevels);
+
+    std::vector<const void*> levels(source.levels.begin() + level, source.levels.end());
+    device->getUploadEngine().uploadImageLevels(texture.image, width, height, source.block, levels);
+
+    texture.imageView = createImageView(texture.image, texture.format, VK_IMAGE_ASPECT_COLOR_BIT, texture.mipLevels);
+}
+
+void Renderer::updateTextureStreaming()
+{
+    if (textureStreamer.getStreamedCount() == 0)
+    {
+        return;
+    }
+
+    PROFILE_ZONE("Renderer::updateTextureStreaming");
+
+    UploadEngine& uploadEngine = device->getUploadEngine();
+    GpuTimeline& gpuTimeline = device->getGpuTimeline();
+
+    // Swap in the textures whose new levels have arrived, the old image goes once no frame samples it
+    for (auto it = streamingUploads.begin(); it != streamingUploads.end();)
+    {
+        if (!uploadEngine.isComplete(it->uploadValue))
+        {
+            ++it;
+            continue;
+        }
+
+        Texture& texture = textures[streamingSources[it->textureId].name];
+        Texture old = texture;
+        VkDescriptorSet oldSet = samplerDescriptorSets[it->textureId];
+
+        texture = it->texture;
+        texture.textId = it->textureId;
+        samplerDescriptorSets[it->textureId] = it->descriptorSet;
+
+        gpuTimeline.defer([this, old, oldSet]() mutable
+        {
+            vkDestroyImageView(device->getLogicalDevice(), old.imageView, nullptr);
+            vkDestroyImage(device->getLogicalDevice(), old.image, nullptr);
+            device->getAllocator().free(old.memory);
+            vkFreeDescriptorSets(device->getLogicalDevice(), samplerDescriptorPool, 1, &oldSet);
+            spareTextureDescriptorSets++;
+        });
+
+        textureStreamer.setResident(it->textureId, it->level);
+        it = streamingUploads.erase(it);
+
+        // Cached bundles bind the old descriptor set
+        invalidateStaticBundles();
+    }
+
+    // Each change needs a descriptor set until the one it replaces is freed
+    std::vector<ResidencyChange> changes = textureStreamer.update(std::min(MAX_STREAMING_CHANGES_PER_FRAME, spareTextureDescriptorSets));
+    if (changes.empty())
+    {
+        return;
+    }
+
+    for (const ResidencyChange& change : changes)
+    {
+        StreamingUpload upload;
+        upload.textureId = change.textureId;
+        upload.level = change.level;
+        createStreamedImage(streamingSources[change.textureId], change.level, upload.texture);
+        upload.descriptorSet = allocateTextureDescriptorSet(upload.texture.imageView);
+        spareTextureDescriptorSets--;
+        streamingUploads.push_back(upload);
+    }
+
+    uint64_t uploadValue = uploadEngine.flush();
+    for (size_t i = streamingUploads.size() - changes.size(); i < streamingUploads.size(); ++i)
+    {
+        streamingUploads[i].uploadValue = uploadValue;
+    }
+}
+
+// Every streamed texture drawn this frame asks for the level matching its size on screen. Only draws that
+// survived culling ask, so textures that went off screen become the least recently used ones.
+// Instanced meshes ask once per instance, the most detailed request wins so the nearest instance decides
+void Renderer::requestTextureLevels()
+{
+    if (textureStreamer.getStreamedCount() == 0)
+    {
+        return;
+    }
+
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(uboViewProjection.view)[3]);
+    float pixelScale = std::abs(uboViewProjection.projection[1][1]) * static_cast<float>(swapchain->getExtent().height);
+
+    if (!usesGpuCulling())
+    {
+        for (const DrawItem& item : drawList)
+        {
+            requestTextureLevel(item.mesh, sceneGraph.getWorldTransform(item.mesh->getSceneNode()), cameraPosition, pixelScale);
+        }
+        for (const DrawItem& item : staticDrawList)
+        {
+            requestTextureLevel(item.mesh, sceneGraph.getWorldTransform(item.mesh->getSceneNode()), cameraPosition, pixelScale);
+        }
+        requestInstancedTextureLevels(instancedDrawList, frameInstances, cameraPosition, pixelScale);
+        requestInstancedTextureLevels(staticInstancedDrawList, staticInstances, cameraPosition, pixelScale);
+        return;
+    }
+
+    // The GPU only reports which buckets drew anything, every mesh of a texture that was drawn asks
+    for (MeshModel& meshModel : modelList)
+    {
+        for (size_t j = 0; j < meshModel.getMeshCount(); ++j)
+        {
+            Mesh* mesh = meshModel.getMesh(j);
+            int textureId = mesh->getTextId();
+            if (textureId >= static_cast<int>(gpuVisibleTextures.size()) || !gpuVisibleTextures[textureId] ||
+                !textureStreamer.isStreamed(textureId))
+            {
+                continue;
+            }
+
+            const glm::mat4& world = sceneGraph.getWorldTransform(mesh->getSceneNode());
+            if (!meshModel.isInstanced())
+            {
+                requestTextureLevel(mesh, world, cameraPosition, pixelScale);
+                continue;
+            }
+            for (const InstanceData& instance : meshModel.getInstances())
+            {
+                requestTextureLevel(mesh, instance.transform * world, cameraPosition, pixelScale);
+            }
+        }
+    }
+}
+
+void Renderer::requestInstancedTextureLevels(const std::vector<InstancedDraw>& draws, const std::vector<InstanceData>& instances,
+                                             const glm::vec3& cameraPosition, float pixelScale)
+{
+    for (const InstancedDraw& draw : draws)
+    {
+        if (!textureStreamer.isStreamed(draw.mesh->getTextId()))
+        {
+            continue;
+        }
+        const glm::mat4& world = sceneGraph.getWorldTransform(draw.mesh->getSceneNode());
+        for (uint32_t k = draw.firstInstance; k < draw.firstInstance + draw.instanceCount; ++k)
+        {
+            requestTextureLevel(draw.mesh, instances[k].transform * world, cameraPosition, pixelScale);
+        }
+    }
+}
+
+// pixelScale turns the size of a sphere over its distance into its height on screen in pixels
+void Renderer::requestTextureLevel(Mesh* mesh, const glm::mat4& transform, const glm::vec3& cameraPosition, float pixelScale)
+{
+    int textureId = mesh->getTextId();
+    if (!textureStreamer.isStreamed(textureId))
+    {
+        return;
+    }
+
+    float scale = std::max(glm::length(glm::vec3(transform[0])),
+        std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+    // Bounding sphere of the mesh, the texture is assumed to be mapped across it once
+    const MeshBounds& bounds = mesh->getBounds();
+    glm::vec3 center = glm::vec3(transform * glm::vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+    float radius = bounds.radius * scale;
+    float distance = std::max(glm::length(center - cameraPosition) - radius, 0.1f);
+
+    // Height in pixels, larger objects on screen get their levels first
+    float size = std::max(radius * pixelScale / distance, 1.0f);
+
+    const StreamingSource& source = streamingSources[textureId];
+    float level = std::log2(std::max(source.width, source.height) / size);
+    textureStreamer.request(textureId, level, size);
+}
+
+int Renderer::initImGui()
+{
+    try {
+        imguiManager = new ImGuiManager(window->getSDLWindow(),
+            instance->getInstance(),
+            device->getLogicalDevice(),
+            device->getPhysicalDevice(),
+            device->getGraphicsQueue(),
+            device->getGraphicsQueueFamilyIndex(),
+            getRenderPass());
+
+    }
+    catch (std::runtime_error& e) {
+        Logger::error("Failed to initialize ImGui: " + std::string(e.what()));
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
+
+VkFormat Renderer::findColorFormat()
+{
+    return findSupportedFormat(
+        { VK_FORMAT_R8G8B8A8_UNORM },
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+    );
+}
+
+void Renderer::cleanup()
+{
+    jobSystem.cleanup();
+    assetLoader.cleanup();
+    
+    //if (modelTransferSpace) {
+    //    _aligned_free(modelTransferSpace);
+    //    modelTransferSpace = nullptr;
+    //}
+
+
+    if (imguiManager)
+    {
+        delete imguiManager;
+        imguiManager = nullptr;
+    }
+
+    if (device)
+    {
+        vkDeviceWaitIdle(device->getLogicalDevice());
+
+        for (size_t i = 0; i < modelList.size(); ++i)
+        {
+            modelList[i].destroyMeshModel();
+        }
+        for (UploadingModel& uploading : uploadingModels)
+        {
+            MeshModel(uploading.meshes).destroyMeshModel();
+        }
+        uploadingModels.clear();
+        loadingModels.clear();
+
+        // Textures replaced by streaming, and the streamed levels that never got swapped in
+        device->getGpuTimeline().collect();
+        for (StreamingUpload& upload : streamingUploads)
+        {
+            vkDestroyImageView(device->getLogicalDevice(), upload.texture.imageView, nullptr);
+            vkDestroyImage(device->getLogicalDevice(), upload.texture.image, nullptr);
+            device->getAllocator().free(upload.texture.memory);
+        }
+        streamingUploads.clear();
+        streamingSources.clear();
+
+        vkDestroyDescriptorPool(device->getLogicalDevice(), samplerDescriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(device->getLogicalDevice(), samplerSetLayout, nullptr);
+
+        for (size_t i = 0; i < depthBufferImages.size(); i++)
+        {
+            vkDestroyImageView(device->getLogicalDevice(), depthBufferImageViews[i], nullptr);
+            vkDestroyImage(device->getLogicalDevice(), depthBufferImages[i], nullptr);
+            device->getAllocator().free(depthBufferImageMemory[i]);
+        }
+
+        for (size_t i = 0; i < colorBufferImages.size(); i++)
+        {
+            vkDestroyImageView(device->getLogicalDevice(), colorBufferImageViews[i], nullptr);
+            vkDestroyImage(device->getLogicalDevice(), colorBufferImages[i], nullptr);
+            device->getAllocator().free(colorBufferImageMemory[i]);
+        }
+        device->getAllocator().resetLinearPool(attachmentMemoryPool);
+
+        cleanupTextures();
+        vkDestroySampler(device->getLogicalDevice(), textureSampler, nullptr);
+
+        // Frame contexts own the view projection pool, uniform buffer and sync objects
+        Logger::info("Destroying frame contexts.");
+        destroyFrameContexts();
+        gpuCuller.cleanup();
+
+        vkDestroyDescriptorPool(device->getLogicalDevice(), inputDescriptorPool, nullptr);
+        if (inputSetLayout != VK_NULL_HANDLE)
+        {
+            Logger::info("Destroying input descriptor set layout.");
+            vkDestroyDescriptorSetLayout(device->getLogicalDevice(), inputSetLayout, nullptr);
+            inputSetLayout = VK_NULL_HANDLE;
+        }
+
+        if (instanceSetLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(device->getLogicalDevice(), instanceSetLayout, nullptr);
+            instanceSetLayout = VK_NULL_HANDLE;
+        }
+
+        if (descriptorSetLayout != VK_NULL_HANDLE)
+        {
+            Logger::info("Destroying descriptor set layout.");
+            vkDestroyDescriptorSetLayout(device->getLogicalDevice(), descriptorSetLayout, nullptr);
+            descriptorSetLayout = VK_NULL_HANDLE;
+        }
+        else {
+            Logger::warning("Descriptor set layout is already null.");
+        }
+
+        for (size_t i = 0; i < modelDynUniformBuffers.size(); ++i)
+        {
+            if (modelDynUniformBuffers[i] != VK_NULL_HANDLE)
+            {
+                Logger::info("Destroying uniform buffer at index " + std::to_string(i));
+                vkDestroyBuffer(device->getLogicalDevice(), modelDynUniformBuffers[i], nullptr);
+                modelDynUniformBuffers[i] = VK_NULL_HANDLE;
+            }
+            else {
+                Logger::warning("Model dynamic Uniform buffer at index " + std::to_string(i) + " is already null.");
+            }
+        }
+
+        for (size_t i = 0; i < modelDynUniformBuffersMemory.size(); ++i)
+        {
+            if (modelDynUniformBuffersMemory[i] != VK_NULL_HANDLE)
+            {
+                Logger::info("Freeing uniform buffer memory at index " + std::to_string(i));
+                vkFreeMemory(device->getLogicalDevice(), modelDynUniformBuffersMemory[i], nullptr);
+                modelDynUniformBuffersMemory[i] = VK_NULL_HANDLE;
+            }
+            else {
+                Logger::warning("Model Dynamic Uniform buffer memory at index " + std::to_string(i) + " is already null.");
+            }
+        }
+
+        // Destroy graphics pipelines
+
+        if (secondPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device->getLogicalDevice(), secondPipeline, nullptr);
+            secondPipeline = VK_NULL_HANDLE;
+        }
+
+        // Destroy pipeline layout
+        if (secondPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(device->getLogicalDevice(), secondPipelineLayout, nullptr);
+            secondPipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (graphicsPipeline != VK_NULL_HANDLE) 
+        {
+            vkDestroyPipeline(device->getLogicalDevice(), graphicsPipeline, nullptr);
+            graphicsPipeline = VK_NULL_HANDLE;
+        }
+
+        // Destroy pipeline layout
+        if (pipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(device->getLogicalDevice(), pipelineLayout, nullptr);
+            pipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (indirectPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device->getLogicalDevice(), indirectPipeline, nullptr);
+            indirectPipeline = VK_NULL_HANDLE;
+        }
+
+        if (indirectPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(device->getLogicalDevice(), indirectPipelineLayout, nullptr);
+            indirectPipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (instancedPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device->getLogicalDevice(), instancedPipeline, nullptr);
+            instancedPipeline = VK_NULL_HANDLE;
+        }
+
+        if (instancedPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(device->getLogicalDevice(), instancedPipelineLayout, nullptr);
+            instancedPipelineLayout = VK_NULL_HANDLE;
+        }
+
+        // Destroy render pass
+        if (renderPass != VK_NULL_HANDLE) 
+        {
+            vkDestroyRenderPass(device->getLogicalDevice(), renderPass, nullptr);
+            renderPass = VK_NULL_HANDLE;
+        }
+
+        // Destroy framebuffers
+        for (auto framebuffer : framebuffers) 
+        {
+            if (framebuffer != VK_NULL_HANDLE)
+            {
+                vkDestroyFramebuffer(device->getLogicalDevice(), framebuffer, nullptr);
+            }
+        }
+        framebuffers.clear();
+
+        // Destroy shader modules
+        for (auto shaderModule : shaderModules)
+        {
+            if (shaderModule != VK_NULL_HANDLE) 
+            {
+                vkDestroyShaderModule(device->getLogicalDevice(), shaderModule, nullptr);
+            }
+        }
+        shaderModules.clear();
+
+        this->device = nullptr;
+    }
+}
@@ -1,183 +1,406 @@
-#pragma once
-
-#define GLM_FORCE_DEPTH_ZERO_TO_ONE
-
-#include <vulkan/vulkan.h>
-#include <glm/glm.hpp>
-#include <string>
-#include <vector>
-#include <memory>
-#include <unordered_map>
-
-#include "stb_image.h"
-#include "Texture.h"
-//#include "Vertex.h"
-
-#include "MeshModel.h"
-#include "ImGuiManager.h"
-
-class Device;
-class Swapchain;
-class Window;
-class Instance;
-class Mesh;
-struct Model;
-
-class Renderer
-{
-public:
-    ~Renderer();
-    void setup(Device* device, Swapchain* swapchain, Window* window, Instance* instance);
-    void finalizeSetup();
-    void drawFrame();
-    void update(float deltaTime);
-    void cleanup();
-    
-    void recreateSwapchain(VkExtent2D newExtent);
-
-    Texture* getTexture(const std::string& texturePath);
-    void cleanupTextures();
-
-    int createMeshModel(std::string modelPath, std::string modelFile);
-    MeshModel& getMeshModel(size_t index) { return modelList[index]; }
-    VkRenderPass getRenderPass() { return renderPass; }
-
-private:
-    void createRenderPass();
-    void createDescriptorSetLayout();
-    void createPushConstantRange();
-    void createGraphicsPipeline();
-    void createColorBufferImage();
-    void createDepthBufferImage();
-    void createFramebuffers();
-    void createCommandBuffers();
-    void createTextureSampler();
-    void createSyncObjects();
-
-    void createDescriptorPools();
-    void createDescriptorSets();
-    void createInputDescriptorSets();
-    int createTextureDescriptor(VkImageView textureImage);
-
-    void createUniformBuffers();
-    void updateUniformBuffers(uint32_t imageIndex);
-      
-    void cleanupSwapchain();
-
-    VkPipelineShaderStageCreateInfo createShaderStage(const std::string& filepath, VkShaderStageFlagBits stage);
-
-    void allocateDynamicBufferTransferSpace();
-
-    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, 
-                    VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags,
-                    VkImage* image, VkDeviceMemory* imageMemory);
-    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-    VkFormat findDepthFormat();
-    VkFormat findColorFormat();
-    VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
-
-    void loadTexture(const std::string& filePath, Texture& texture);
-    void loadTextureImage(const std::string& filePath, Texture& texture);
-
-    void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
-
-    void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-
-    // init ImGui manager
-    int initImGui();
-
-    //--------------------------------------------------------------------------------
-    // Render Frame methods
-    void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
-    VkCommandBuffer getCurrentCommandBuffer() const;
-
-    // Reference to external objects (set in setup)
-    Device* device = nullptr;       // Pointer to Device for easy access
-    Swapchain* swapchain = nullptr; // Pointer to Swapchain for easy access
-    Window* window = nullptr;
-    Instance* instance = nullptr;
-
-    // Vulkan resources
-    VkRenderPass renderPass = VK_NULL_HANDLE;
-    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
-
-    // second pass pipeline
-    VkPipelineLayout secondPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline secondPipeline = VK_NULL_HANDLE;
-
-    // Framebuffers for each swapchain image
-    std::vector<VkFramebuffer> framebuffers;
-
-    // Command buffers, one per framebuffer
-    // Command buffers hold GPU commands, such as drawing calls, memory transfers, and synchronization instructions.
-    std::vector<VkCommandBuffer> commandBuffers;
-
-
-    //-------------------------------------------------
-    // Buffers for sub passes
-
-    // Color buffer image
-    std::vector<VkImage> colorBufferImages;
-    std::vector<VkDeviceMemory> colorBufferImageMemory;
-    std::vector<VkImageView> colorBufferImageViews;
-
-    // Depth buffer
-    std::vector<VkImage> depthBufferImages;
-    std::vector<VkDeviceMemory> depthBufferImageMemory;
-    std::vector<VkImageView> depthBufferImageViews;
-
-    //-----------------------------------------------
-
-    // Synchronization objects
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
-    std::vector<VkSemaphore> imageAvailableSemaphores;
-    std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
-    uint32_t currentFrame = 0;  // Tracks the current frame in flight
-
-    std::vector<VkShaderModule> shaderModules; // To store created shader modules
-
-    // Descriptors
-    VkDescriptorSetLayout descriptorSetLayout;
-    VkDescriptorPool descriptorPool;
-    std::vector<VkDescriptorSet> descriptorSets; // for viewProjection one for each swapchain image
-
-    VkDescriptorSetLayout inputSetLayout;
-    VkDescriptorPool inputDescriptorPool;
-    std::vector<VkDescriptorSet> inputDescriptorSets;
-
-    // texture sampler descriptor pool
-    VkDescriptorPool samplerDescriptorPool;
-    VkDescriptorSetLayout samplerSetLayout;
-    std::vector<VkDescriptorSet> samplerDescriptorSets;
-
-    VkPushConstantRange pushConstantRange;
-
-    // View Projection uniform buffer for every swapchain image
-    std::vector<VkBuffer> vpUniformBuffers;
-    std::vector<VkDeviceMemory> vpUniformBuffersMemory;
-
-    // Model dynamic uniform buffers
-    std::vector<VkBuffer> modelDynUniformBuffers;
-    std::vector<VkDeviceMemory> modelDynUniformBuffersMemory;
-    //VkDeviceSize minUniformBufferOffset;
-    //size_t modelUniformAlignment;
-
-    //Model* modelTransferSpace;
-
-    struct UboViewProjection {
-        glm::mat4 projection;
-        glm::mat4 view;
-    } uboViewProjection;
-
-    // Textures
-    std::unordered_map<std::string, Texture> textures;
-    VkSampler textureSampler;
-
-    // MeshModels
-    std::vector<MeshModel> modelList;
-
-    // ImGuiManager
-    ImGuiManager* imguiManager = nullptr;
-};
+#pragma once
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "stb_image.h"
+#include "Texture.h"
+//#include "Vertex.h"
+
+#include "MeshModel.h"
+#include "ImGuiManager.h"
+#include "FrameContext.h"
+#include "JobSystem.h"
+#include "GpuProfiler.h"
+#include "AssetLoader.h"
+#include "TextureStreamer.h"
+#include "FrustumCuller.h"
+#include "GpuCuller.h"
+
+class Device;
+class Swapchain;
+class Window;
+class Instance;
+class Mesh;
+struct Model;
+
+class Renderer
+{
+public:
+    ~Renderer();
+    void setup(Device* device, Swapchain* swapchain, Window* window, Instance* instance, uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+    void finalizeSetup();
+    void drawFrame();
+    void update(float deltaTime);
+    void cleanup();
+    
+    void recreateSwapchain(VkExtent2D newExtent);
+
+    // Number of frames the CPU may record ahead of the GPU, more frames trade latency for overlap.
+    // The change is applied at the start of the next frame.
+    void setFramesInFlight(uint32_t count);
+    uint32_t getFramesInFlight() const { return static_cast<uint32_t>(frames.size()); }
+
+    Texture* getTexture(const std::string& texturePath);
+    // Texture from RGBA8 pixels in memory, found by name with getTexture afterwards
+    Texture* createTexture(const std::string& name, uint32_t width, uint32_t height, const void* pixels);
+    void cleanupTextures();
+
+    // Texture files larger than the streaming tail keep only their small mips resident and stream
+    // the rest in by projected size, within this many bytes. Takes effect from the next texture loaded
+    void setTextureStreamingEnabled(bool enabled) { textureStreamingEnabled = enabled; }
+    void setTextureBudget(uint64_t bytes) { textureStreamer.setBudget(bytes); }
+
+    int createMeshModel(std::string modelPath, std::string modelFile);
+    // Returns at once, a placeholder is drawn while the model is imported and decoded in the
+    // background and until its uploads have completed
+    int loadMeshModelAsync(std::string modelPath, std::string modelFile);
+    bool isMeshModelLoading(size_t index) const;
+    // Model from meshes already in the geometry arena, e.g. generated ones
+    int createMeshModel(const std::vector<Mesh>& meshes);
+    size_t getMeshModelCount() const { return modelList.size(); }
+    MeshModel& getMeshModel(size_t index) { return modelList[index]; }
+    // Every model is a root of the scene graph, with the node hierarchy of its file below it
+    SceneGraph& getSceneGraph() { return sceneGraph; }
+    // Frees the geometry of the model, the index stays valid but empty. The arena is compacted
+    // later, once the freed ranges leave it fragmented
+    void destroyMeshModel(size_t index);
+
+    // Record static models once into cached bundles instead of every frame
+    void setStaticBundlesEnabled(bool enabled);
+
+    // Only record draws whose bounds are inside the view frustum
+    void setFrustumCullingEnabled(bool enabled) { frustumCullingEnabled = enabled; }
+    bool getFrustumCullingEnabled() const { return frustumCullingEnabled; }
+    // Draws tested and kept by the last recorded frame, a few frames behind with GPU culling
+    const CullingStats& getCullingStats() const { return cullingStats; }
+
+    // Cull on the GPU and draw with indirect commands while frustum culling is enabled, replaces
+    // CPU culling and the static bundles. Needs firstInstance support in indirect draws
+    void setGpuCullingEnabled(bool enabled) { gpuCullingEnabled = enabled; }
+    bool getGpuCullingEnabled() const { return gpuCullingEnabled; }
+    bool isGpuCullingSupported() const { return gpuCullingSupported; }
+
+    // GPU time of the passes and draw groups, a few frames behind
+    GpuProfiler& getGpuProfiler() { return gpuProfiler; }
+    bool getStaticBundlesEnabled() const { return staticBundlesEnabled; }
+
+    // Draw calls of the last recorded frame, cached static, instanced and indirect draws and the fullscreen pass included
+    uint32_t getDrawCallCount() const
+    {
+        return static_cast<uint32_t>(drawList.size() + staticDrawList.size() + instancedDrawList.size() +
+            staticInstancedDrawList.size()) + indirectDrawCallCount + 1;
+    }
+    VkRenderPass getRenderPass() { return renderPass; }
+
+private:
+    // One mesh draw of the scene
+    struct DrawItem
+    {
+        MeshModel* model;
+        Mesh* mesh;
+    };
+
+    // One mesh of an instanced model drawn for a range of the frame's instances
+    struct InstancedDraw
+    {
+        MeshModel* model;
+        Mesh* mesh;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    // GPU culled draws that share a texture and an index type, a range of indirect commands
+    struct DrawBucket
+    {
+        int textureId;
+        VkIndexType indexType;
+        uint32_t firstCommand;
+        uint32_t commandCount;
+    };
+
+    void createRenderPass();
+    void createDescriptorSetLayout();
+    void createGpuCuller();
+    void createPushConstantRange();
+    void createGraphicsPipeline();
+    void createColorBufferImage();
+    void createDepthBufferImage();
+    void createFramebuffers();
+    void createTextureSampler();
+
+    // Frame context ring
+    void createFrameContexts(uint32_t frameCount);
+    void destroyFrameContexts();
+    void createFrameCommandBuffers(FrameContext& frame);
+    void createFrameSyncObjects(FrameContext& frame);
+    void createFrameDescriptorArena(FrameContext& frame);
+    VkDescriptorSet allocateFrameDescriptorSet(FrameContext& frame, VkDescriptorSetLayout layout);
+
+    void createDescriptorPools();
+    void createDescriptorSets();
+    void createInputDescriptorSets();
+    int createTextureDescriptor(VkImageView textureImage);
+    VkDescriptorSet allocateTextureDescriptorSet(VkImageView textureImage);
+
+    void createUniformBuffers();
+    void updateUniformBuffers(FrameContext& frame);
+      
+    void cleanupSwapchain();
+
+    VkPipelineShaderStageCreateInfo createShaderStage(const std::string& filepath, VkShaderStageFlagBits stage);
+
+    void allocateDynamicBufferTransferSpace();
+
+    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, 
+                    VkImageUsageFlags usageFlags, VkMemoryPropertyFlags memoryPropertyFlags,
+                    VkImage* image, Allocation* imageMemory, uint32_t linearPool = INVALID_LINEAR_POOL,
+                    uint32_t mipLevels = 1);
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
+    VkFormat findDepthFormat();
+    VkFormat findColorFormat();
+    VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+    // Mip chains of the format can be generated with linear filtered blits
+    bool supportsLinearBlit(VkFormat format);
+
+    void createTextureImage(uint32_t width, uint32_t height, const void* pixels, Texture& texture);
+    // Pre-built levels as stored, decoded to RGBA8 when the device cannot sample the format
+    void createContainerImage(const TextureContainer& container, Texture& texture);
+    Texture* createTexture(const DecodedImage& image);
+    void createPlaceholderTexture();
+
+    // Upload what the asset loader finished and swap in models whose uploads are complete
+    void processLoadedModels();
+
+    // A content node below root with the file's node hierarchy, each mesh is attached to its node
+    uint32_t createSceneNodes(uint32_t root, const std::vector<DecodedNode>& nodes, const std::vector<MeshView>& views,
+                              std::vector<Mesh>& meshes);
+    int addMeshModel(const std::vector<Mesh>& meshes, uint32_t root, uint32_t content);
+    void updateScene();
+
+    // init ImGui manager
+    int initImGui();
+
+    //--------------------------------------------------------------------------------
+    // Render Frame methods
+    void recordCommandBuffer(FrameContext& frame, uint32_t imageIndex);
+    VkCommandBuffer recordImGui(FrameContext& frame, uint32_t imageIndex, const StaticBundle& staticBundle, uint32_t jobCount);
+    VkCommandBuffer beginSecondaryCommandBuffer(FrameContext& frame, uint32_t thread, uint32_t imageIndex);
+    void beginInheritingCommandBuffer(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkCommandBufferUsageFlags flags);
+    void recordDraws(VkCommandBuffer commandBuffer, FrameContext& frame, const std::vector<DrawItem>& items, size_t first, size_t count);
+    void prepareDrawLists();
+    void prepareIndirectDraws(FrameContext& frame);
+    VkCommandBuffer recordIndirectDraws(FrameContext& frame, uint32_t imageIndex);
+    VkCommandBuffer recordInstancedDraws(FrameContext& frame, uint32_t imageIndex);
+    void recordInstancedDrawList(VkCommandBuffer commandBuffer, FrameContext& frame, VkDescriptorSet instanceSet,
+                                 const std::vector<InstancedDraw>& draws);
+    bool writeInstanceBuffer(const std::vector<InstanceData>& instances, VkBuffer& buffer, Allocation& memory, uint32_t& capacity);
+    void writeInstanceSet(VkDescriptorSet instanceSet, VkBuffer buffer);
+    bool usesGpuCulling() const { return frustumCullingEnabled && gpuCullingEnabled && gpuCullingSupported; }
+
+    // Static draw bundles
+    StaticBundle& getStaticBundle(FrameContext& frame, VkPipeline pipeline);
+    bool isStaticBundleCurrent(const StaticBundle& bundle) const;
+    void recordStaticBundle(FrameContext& frame, StaticBundle& bundle);
+    void invalidateStaticBundles() { staticRevision++; }
+    VkCommandBuffer getCurrentCommandBuffer() const;
+
+    // Reference to external objects (set in setup)
+    Device* device = nullptr;       // Pointer to Device for easy access
+    Swapchain* swapchain = nullptr; // Pointer to Swapchain for easy access
+    Window* window = nullptr;
+    Instance* instance = nullptr;
+
+    // Vulkan resources
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+
+    // graphics pipeline of the GPU culled draws, the model is read from the cull objects
+    VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline indirectPipeline = VK_NULL_HANDLE;
+
+    // graphics pipeline of the instanced draws, the push constant model is placed by every instance
+    VkPipelineLayout instancedPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline instancedPipeline = VK_NULL_HANDLE;
+
+    // second pass pipeline
+    VkPipelineLayout secondPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline secondPipeline = VK_NULL_HANDLE;
+
+    // Framebuffers for each swapchain image
+    std::vector<VkFramebuffer> framebuffers;
+
+
+    //-------------------------------------------------
+    // Buffers for sub passes
+
+    // Color buffer image
+    std::vector<VkImage> colorBufferImages;
+    std::vector<Allocation> colorBufferImageMemory;
+    std::vector<VkImageView> colorBufferImageViews;
+
+    // Depth buffer
+    std::vector<VkImage> depthBufferImages;
+    std::vector<Allocation> depthBufferImageMemory;
+
+    // color and depth attachments share a lifetime, so they are bump allocated together
+    uint32_t attachmentMemoryPool = INVALID_LINEAR_POOL;
+    std::vector<VkImageView> depthBufferImageViews;
+
+    //-----------------------------------------------
+
+    // Frame contexts, one per frame in flight.
+    // Each holds its own command pool, uniform slice, descriptors and sync objects.
+    std::vector<FrameContext> frames;
+    uint32_t currentFrame = 0;  // Tracks the current frame in flight
+    uint32_t requestedFramesInFlight = 0;   // pending frame count change, 0 when none
+
+    // Timeline value of the frame that last rendered to each swapchain image,
+    // the color/depth attachments and input descriptors are per image.
+    std::vector<uint64_t> imagesInFlight;
+
+    std::vector<VkShaderModule> shaderModules; // To store created shader modules
+
+    // Descriptors
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;    // viewProjection sets, one for each frame context
+
+    VkDescriptorSetLayout inputSetLayout;
+
+    // instance storage buffer of a frame, allocated from its descriptor arena
+    VkDescriptorSetLayout instanceSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool inputDescriptorPool;
+    std::vector<VkDescriptorSet> inputDescriptorSets;
+
+    // texture sampler descriptor pool
+    VkDescriptorPool samplerDescriptorPool;
+    VkDescriptorSetLayout samplerSetLayout;
+    std::vector<VkDescriptorSet> samplerDescriptorSets;
+
+    VkPushConstantRange pushConstantRange;
+
+    // View Projection uniform buffer, one aligned slice for every frame context.
+    // The memory stays mapped for the lifetime of the buffer.
+    VkBuffer vpUniformBuffer = VK_NULL_HANDLE;
+    Allocation vpUniformBufferMemory;
+    VkDeviceSize vpUniformSliceSize = 0;
+
+    // Model dynamic uniform buffers
+    std::vector<VkBuffer> modelDynUniformBuffers;
+    std::vector<VkDeviceMemory> modelDynUniformBuffersMemory;
+    //VkDeviceSize minUniformBufferOffset;
+    //size_t modelUniformAlignment;
+
+    //Model* modelTransferSpace;
+
+    struct UboViewProjection {
+        glm::mat4 projection;
+        glm::mat4 view;
+    } uboViewProjection;
+
+    // Textures
+    std::unordered_map<std::string, Texture> textures;
+    VkSampler textureSampler;
+
+    // Texture streaming, the CPU copy of every level stays around to upload from
+    struct StreamingSource
+    {
+        std::string name;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        ImageBlock block;
+        std::shared_ptr<TextureContainer> container;
+        std::vector<unsigned char> mipChain;
+        std::vector<const void*> levels;
+    };
+    struct StreamingUpload
+    {
+        int textureId = -1;
+        uint32_t level = 0;
+        Texture texture;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint64_t uploadValue = 0;
+    };
+    bool textureStreamingEnabled = true;
+    TextureStreamer textureStreamer;
+    std::unordered_map<int, StreamingSource> streamingSources;     // by texture id
+    std::vector<StreamingUpload> streamingUploads;
+    uint32_t spareTextureDescriptorSets = STREAMING_SPARE_DESCRIPTOR_SETS;
+
+    // Streamed textures are images of their resident levels, replaced whenever residency changes
+    Texture* createStreamedTexture(const DecodedImage& image);
+    void createStreamedImage(const StreamingSource& source, uint32_t level, Texture& texture);
+    void updateTextureStreaming();
+    void requestTextureLevels();
+    void requestInstancedTextureLevels(const std::vector<InstancedDraw>& draws, const std::vector<InstanceData>& instances,
+                                       const glm::vec3& cameraPosition, float pixelScale);
+    void requestTextureLevel(Mesh* mesh, const glm::mat4& transform, const glm::vec3& cameraPosition, float pixelScale);
+
+    // MeshModels
+    std::vector<MeshModel> modelList;
+    SceneGraph sceneGraph;
+    uint32_t sceneNodesUpdated = 0;
+
+    // Every mesh of the scene, tested against the view frustum before it becomes a draw
+    bool frustumCullingEnabled = true;
+    FrustumCuller frustumCuller;
+    CullingStats cullingStats;
+    std::vector<DrawItem> drawCandidates;
+    std::vector<InstancedDraw> instancedCandidates;     // instances of a mesh at their first culling index
+
+    // GPU culling, the objects are written every frame and culled by a compute pass
+    bool gpuCullingEnabled = true;
+    bool gpuCullingSupported = false;
+    GpuCuller gpuCuller;
+    std::vector<DrawBucket> drawBuckets;
+    std::vector<uint32_t> drawBucketLookup;     // bucket of texture id * 2 + 16 bit indices
+    std::vector<uint8_t> gpuVisibleTextures;    // by texture id, drawn by a culled bucket a few frames ago
+    uint32_t indirectDrawCallCount = 0;
+
+    // Scene flattened into single draws every frame, recorded in chunks by the job system
+    std::vector<DrawItem> drawList;
+    std::vector<VkCommandBuffer> secondaryCommands;     // in execution order
+
+    // Instanced models become one draw per mesh of their visible instances, copied to the frame's instance buffer
+    std::vector<InstancedDraw> instancedDrawList;
+    std::vector<InstanceData> frameInstances;
+
+    // Static models go into the cached bundles instead, drawn before the per frame draws
+    bool staticBundlesEnabled = true;
+    uint64_t staticRevision = 1;        // bumped on model list, texture and swapchain changes
+    uint32_t staticBundleRecordCount = 0;
+    std::vector<DrawItem> staticDrawList;
+    std::vector<uint32_t> staticModelRevisions;
+    std::vector<uint32_t> staticVisibleDraws;        // static draws and instances of the frame that passed culling
+    std::vector<InstancedDraw> staticInstancedDrawList;
+    std::vector<InstanceData> staticInstances;       // copied to the bundle's instance buffer when it is recorded
+    JobSystem jobSystem;
+
+    // Timestamps around passes and draw groups, one query pool per frame context
+    GpuProfiler gpuProfiler;
+    uint32_t staticDrawScope = GpuProfiler::INVALID_SCOPE;
+
+    // Background model loading, decoded on the loader threads and uploaded here
+    struct UploadingModel
+    {
+        size_t modelIndex;
+        std::vector<Mesh> meshes;
+        uint32_t contentNode = SceneGraph::INVALID_NODE;
+        uint64_t uploadValue = 0;
+    };
+    AssetLoader assetLoader;
+    std::vector<size_t> loadingModels;          // still drawn with their placeholder
+    std::vector<UploadingModel> uploadingModels;
+    int placeholderTextureId = 0;               // also used by materials without a texture
+
+    // ImGuiManager
+    ImGuiManager* imguiManager = nullptr;
+};
@@ -0,0 +1,227 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+uint32_t SceneGraph::createNode(uint32_t parent, const glm::mat4& localTransform)
+{
+    if (parent != INVALID_NODE && !isValid(parent))
+    {
+        throw std::runtime_error("Invalid scene graph parent!");
+    }
+
+    // Right after the parent's subtree, keeps every subtree contiguous
+    uint32_t parentPosition = INVALID_NODE;
+    uint32_t position = getNodeCount();
+    if (parent != INVALID_NODE)
+    {
+        parentPosition = positions[parent];
+        position = parentPosition + subtreeSizes[parentPosition];
+    }
+
+    uint32_t handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(positions.size());
+        positions.push_back(position);
+    }
+
+    localTransforms.insert(localTransforms.begin() + position, localTransform);
+    worldTransforms.insert(worldTransforms.begin() + position, localTransform);
+    parents.insert(parents.begin() + position, parentPosition);
+    subtreeSizes.insert(subtreeSizes.begin() + position, 1);
+    handles.insert(handles.begin() + position, handle);
+    dirty.insert(dirty.begin() + position, 0);
+    positions[handle] = position;
+
+    // Everything behind the new node moved up by one
+    for (uint32_t i = position + 1; i < getNodeCount(); ++i)
+    {
+        positions[handles[i]] = i;
+        if (parents[i] != INVALID_NODE && parents[i] >= position)
+        {
+            parents[i]++;
+        }
+    }
+    for (uint32_t ancestor = parentPosition; ancestor != INVALID_NODE; ancestor = parents[ancestor])
+    {
+        subtreeSizes[ancestor]++;
+    }
+
+    markDirty(position);
+    return handle;
+}
+
+void SceneGraph::destroyNode(uint32_t node)
+{
+    if (!isValid(node))
+    {
+        return;
+    }
+
+    uint32_t position = positions[node];
+    uint32_t count = subtreeSizes[position];
+    for (uint32_t ancestor = parents[position]; ancestor != INVALID_NODE; ancestor = parents[ancestor])
+    {
+        subtreeSizes[ancestor] -= count;
+    }
+    for (uint32_t i = position; i < position + count; ++i)
+    {
+        positions[handles[i]] = INVALID_NODE;
+        freeHandles.push_back(handles[i]);
+    }
+
+    localTransforms.erase(localTransforms.begin() + position, localTransforms.begin() + position + count);
+    worldTransforms.erase(worldTransforms.begin() + position, worldTransforms.begin() + position + count);
+    parents.erase(parents.begin() + position, parents.begin() + position + count);
+    subtreeSizes.erase(subtreeSizes.begin() + position, subtreeSizes.begin() + position + count);
+    handles.erase(handles.begin() + position, handles.begin() + position + count);
+    dirty.erase(dirty.begin() + position, dirty.begin() + position + count);
+
+    // Everything behind the subtree moved down, dirty handles of it are skipped by update()
+    for (uint32_t i = position; i < getNodeCount(); ++i)
+    {
+        positions[handles[i]] = i;
+        if (parents[i] != INVALID_NODE && parents[i] >= position)
+        {
+            parents[i] -= count;
+        }
+    }
+}
+
+bool SceneGraph::isValid(uint32_t node) const
+{
+    return node < positions.size() && positions[node] != INVALID_NODE;
+}
+
+void SceneGraph::setLocalTransform(uint32_t node, const glm::mat4& transform)
+{
+    uint32_t position = positions[node];
+    localTransforms[position] = transform;
+    markDirty(position);
+}
+
+const glm::mat4& SceneGraph::getLocalTransform(uint32_t node) const
+{
+    return localTransforms[positions[node]];
+}
+
+const glm::mat4& SceneGraph::getWorldTransform(uint32_t node) const
+{
+    return worldTransforms[positions[node]];
+}
+
+uint32_t SceneGraph::update(JobSystem* jobSystem)
+{
+    if (dirtyNodes.empty())
+    {
+        return 0;
+    }
+
+    PROFILE_ZONE("SceneGraph::update");
+
+    // Dirty nodes in depth first order, the ones inside another dirty subtree are covered by it
+    std::vector<uint32_t> roots;
+    roots.reserve(dirtyNodes.size());
+    for (uint32_t node : dirtyNodes)
+    {
+        if (isValid(node) && dirty[positions[node]])
+        {
+            dirty[positions[node]] = 0;
+            roots.push_back(positions[node]);
+        }
+    }
+    dirtyNodes.clear();
+    std::sort(roots.begin(), roots.end());
+
+    const bool split = jobSystem && jobSystem->getThreadCount() > 1;
+    updateRanges.clear();
+    uint32_t coveredEnd = 0;
+    uint32_t updated = 0;
+    for (uint32_t root : roots)
+    {
+        if (root < coveredEnd)
+        {
+            continue;
+        }
+        coveredEnd = root + subtreeSizes[root];
+        updated += subtreeSizes[root];
+        addUpdateRange(root, split);
+    }
+
+    if (!split || updated <= SCENE_UPDATE_BATCH_SIZE)
+    {
+        for (const auto& range : updateRanges)
+        {
+            updateRange(range.first, range.second);
+        }
+        return updated;
+    }
+
+    // Ranges are independent of each other, pack them into jobs of about a batch each
+    std::vector<size_t> jobStarts;
+    uint32_t jobSize = SCENE_UPDATE_BATCH_SIZE;
+    for (size_t i = 0; i < updateRanges.size(); ++i)
+    {
+        if (jobSize >= SCENE_UPDATE_BATCH_SIZE)
+        {
+            jobStarts.push_back(i);
+            jobSize = 0;
+        }
+        jobSize += updateRanges[i].second - updateRanges[i].first;
+    }
+    jobStarts.push_back(updateRanges.size());
+
+    jobSystem->dispatch(static_cast<uint32_t>(jobStarts.size() - 1), [&](uint32_t job, uint32_t)
+    {
+        for (size_t i = jobStarts[job]; i < jobStarts[job + 1]; ++i)
+        {
+            updateRange(updateRanges[i].first, updateRanges[i].second);
+        }
+    });
+    return updated;
+}
+
+void SceneGraph::markDirty(uint32_t position)
+{
+    if (!dirty[position])
+    {
+        dirty[position] = 1;
+        dirtyNodes.push_back(handles[position]);
+    }
+}
+
+// Large subtrees are split into the root, updated right here, and one range per child
+void SceneGraph::addUpdateRange(uint32_t position, bool split)
+{
+    uint32_t end = position + subtreeSizes[position];
+    if (!split || subtreeSizes[position] <= SCENE_UPDATE_BATCH_SIZE)
+    {
+        updateRanges.emplace_back(position, end);
+        return;
+    }
+
+    updateRange(position, position + 1);
+    for (uint32_t child = position + 1; child < end; child += subtreeSizes[child])
+    {
+        addUpdateRange(child, split);
+    }
+}
+
+void SceneGraph::updateRange(uint32_t begin, uint32_t end)
+{
+    // The parent of begin is outside the range and already up to date, the rest follow their parents
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        uint32_t parent = parents[i];
+        worldTransforms[i] = parent == INVALID_NODE ? localTransforms[i] : worldTransforms[parent] * localTransforms[i];
+    }
+}
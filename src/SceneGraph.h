@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// Dirty nodes updated by one job, larger dirty subtrees are split at their children
+const uint32_t SCENE_UPDATE_BATCH_SIZE = 4096;
+
+// Transform hierarchy in structure of arrays form.
+// Nodes are stored depth first, so every subtree is a contiguous range that starts with its root
+// and parents always come before their children. Handles stay valid while nodes move around.
+// Setting a local transform marks the node dirty, update() recomputes the world transforms of
+// the dirty subtrees only, spread over the job system when there are enough of them.
+class SceneGraph
+{
+public:
+    static const uint32_t INVALID_NODE = UINT32_MAX;
+
+    // The new node is the last child of parent, or a root without one.
+    // Creating nodes depth first only ever appends
+    uint32_t createNode(uint32_t parent = INVALID_NODE, const glm::mat4& localTransform = glm::mat4(1.0f));
+
+    // Destroys the node and everything below it
+    void destroyNode(uint32_t node);
+
+    bool isValid(uint32_t node) const;
+
+    void setLocalTransform(uint32_t node, const glm::mat4& transform);
+    const glm::mat4& getLocalTransform(uint32_t node) const;
+
+    // Up to date after update()
+    const glm::mat4& getWorldTransform(uint32_t node) const;
+
+    // Recompute the world transforms of dirty subtrees, returns how many were recomputed
+    uint32_t update(JobSystem* jobSystem = nullptr);
+
+    uint32_t getNodeCount() const { return static_cast<uint32_t>(handles.size()); }
+
+private:
+    // Indexed by position
+    std::vector<glm::mat4> localTransforms;
+    std::vector<glm::mat4> worldTransforms;
+    std::vector<uint32_t> parents;              // position of the parent, INVALID_NODE for roots
+    std::vector<uint32_t> subtreeSizes;         // the node and all of its descendants
+    std::vector<uint32_t> handles;
+    std::vector<uint8_t> dirty;
+
+    // Indexed by handle
+    std::vector<uint32_t> positions;
+    std::vector<uint32_t> freeHandles;
+
+    std::vector<uint32_t> dirtyNodes;           // handles, in the order they were marked
+    std::vector<std::pair<uint32_t, uint32_t>> updateRanges;
+
+    void markDirty(uint32_t position);
+    void addUpdateRange(uint32_t position, bool split);
+    void updateRange(uint32_t begin, uint32_t end);
+};
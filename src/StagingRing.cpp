@@ -0,0 +1,125 @@
+#include "StagingRing.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include "Utils.h"
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+void StagingRing::create(VkDevice device, MemoryAllocator& allocator, VkDeviceSize size)
+{
+    this->size = size;
+
+    createBuffer(device, allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffer, memory);
+
+    if (memory.mapped == nullptr)
+    {
+        throw std::runtime_error("Failed to map staging ring!");
+    }
+
+    head = 0;
+    regions.clear();
+}
+
+void StagingRing::cleanup(VkDevice device, MemoryAllocator& allocator)
+{
+    destroyBuffer(device, allocator, buffer, memory);
+    regions.clear();
+    head = 0;
+}
+
+VkDeviceSize StagingRing::getLargestFree(VkDeviceSize alignment) const
+{
+    if (regions.empty())
+    {
+        return size;
+    }
+
+    VkDeviceSize tail = regions.front().start;
+    VkDeviceSize alignedHead = alignUp(head, alignment);
+    if (head > tail)
+    {
+        // free space at the end and, after wrapping, in front of the tail
+        VkDeviceSize atEnd = alignedHead < size ? size - alignedHead : 0;
+        return std::max(atEnd, tail);
+    }
+    return alignedHead < tail ? tail - alignedHead : 0;
+}
+
+bool StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment, uint64_t value, VkDeviceSize& offset)
+{
+    if (size == 0 || !findSpace(size, alignment, offset))
+    {
+        return false;
+    }
+
+    // Regions of the same batch are merged as long as they are contiguous
+    if (!regions.empty() && regions.back().value == value && regions.back().end <= offset &&
+        regions.back().start < offset)
+    {
+        regions.back().end = offset + size;
+    }
+    else
+    {
+        regions.push_back({ value, offset, offset + size });
+    }
+
+    head = offset + size;
+    return true;
+}
+
+void StagingRing::reclaim(uint64_t completedValue)
+{
+    while (!regions.empty() && regions.front().value <= completedValue)
+    {
+        regions.pop_front();
+    }
+
+    // start over at the beginning when the ring is empty, keeps the regions contiguous
+    if (regions.empty())
+    {
+        head = 0;
+    }
+}
+
+bool StagingRing::findSpace(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const
+{
+    if (regions.empty())
+    {
+        offset = 0;
+        return size <= this->size;
+    }
+
+    VkDeviceSize tail = regions.front().start;
+    VkDeviceSize alignedHead = alignUp(head, alignment);
+
+    if (head > tail)
+    {
+        if (alignedHead + size <= this->size)
+        {
+            offset = alignedHead;
+            return true;
+        }
+
+        // wrap around, the unused end is given back together with the regions before it
+        if (size <= tail)
+        {
+            offset = 0;
+            return true;
+        }
+        return false;
+    }
+
+    if (alignedHead + size <= tail)
+    {
+        offset = alignedHead;
+        return true;
+    }
+    return false;
+}
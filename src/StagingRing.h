@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <deque>
+
+#include "MemoryAllocator.h"
+
+// Default size of the persistently mapped staging buffer all uploads go through
+const VkDeviceSize DEFAULT_STAGING_BUFFER_SIZE = 32ull * 1024 * 1024;
+
+// A persistently mapped host visible buffer used as a ring.
+// Every region is tagged with the upload batch value that reads it and is reclaimed
+// once that value has completed, so no staging buffers are created while streaming.
+class StagingRing
+{
+public:
+    void create(VkDevice device, MemoryAllocator& allocator, VkDeviceSize size);
+    void cleanup(VkDevice device, MemoryAllocator& allocator);
+
+    // Largest contiguous region that can be handed out right now
+    VkDeviceSize getLargestFree(VkDeviceSize alignment) const;
+
+    // Reserve size bytes read by batch value, returns false when there is no contiguous space
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, uint64_t value, VkDeviceSize& offset);
+
+    // Give back every region used by batches up to completedValue
+    void reclaim(uint64_t completedValue);
+
+    VkBuffer getBuffer() const { return buffer; }
+    char* getMapped() const { return static_cast<char*>(memory.mapped); }
+    VkDeviceSize getSize() const { return size; }
+
+private:
+    struct Region
+    {
+        uint64_t value;
+        VkDeviceSize start;
+        VkDeviceSize end;
+    };
+
+    VkBuffer buffer = VK_NULL_HANDLE;
+    Allocation memory;
+    VkDeviceSize size = 0;
+
+    VkDeviceSize head = 0;          // next write position
+    std::deque<Region> regions;     // in use, oldest first
+
+    bool findSpace(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) const;
+};
@@ -1,182 +1,274 @@
-#include "Swapchain.h"
-
-
-void Swapchain::create(Device* device, VkSurfaceKHR surface, VkExtent2D windowExtent) 
-{
-    this->device = device;
-
-    // Query surface capabilities
-    VkSurfaceCapabilitiesKHR surfaceCapabilities;
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device->getPhysicalDevice(), surface, &surfaceCapabilities);
-
-    // Select surface format, present mode, and swap extent
-    VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(device->getSurfaceFormats(surface));
-    VkPresentModeKHR presentMode = choosePresentMode(device->getPresentModes(surface));
-    extent = chooseSwapExtent(surfaceCapabilities, windowExtent.width, windowExtent.height);
-
-    // Set the image count (minimum plus one for triple-buffering, capped by max)
-    uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
-    if (surfaceCapabilities.maxImageCount > 0 && imageCount > surfaceCapabilities.maxImageCount) {
-        imageCount = surfaceCapabilities.maxImageCount;
-    }
-
-    // Define swapchain create info
-    VkSwapchainCreateInfoKHR createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-    createInfo.surface = surface;
-    createInfo.minImageCount = imageCount;
-    createInfo.imageFormat = surfaceFormat.format;
-    createInfo.imageColorSpace = surfaceFormat.colorSpace;
-    createInfo.imageExtent = extent;
-    createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-
-    // Define how to handle swapchain images (e.g., in case of multiple queues)
-    QueueFamilyIndices indices = device->findQueueFamilies(device->getPhysicalDevice(), surface);
-    uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
-
-    if (indices.graphicsFamily != indices.presentFamily)
-    {
-        createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-        createInfo.queueFamilyIndexCount = 2;
-        createInfo.pQueueFamilyIndices = queueFamilyIndices;
-    }
-    else {
-        createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    }
-
-    createInfo.preTransform = surfaceCapabilities.currentTransform;
-    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    createInfo.presentMode = presentMode;
-    createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
-
-    // Create the swapchain
-    VkResult result = vkCreateSwapchainKHR(device->getLogicalDevice(), &createInfo, nullptr, &swapchain);
-    
-    if (result != VK_SUCCESS)
-    {
-        std::cerr << "Failed to create swapchain! Error code: " << result << std::endl;
-        throw std::runtime_error("Failed to create swapchain!");
-    }
-
-    // Retrieve swapchain images
-    vkGetSwapchainImagesKHR(device->getLogicalDevice(), swapchain, &imageCount, nullptr);
-    swapchainImages.resize(imageCount);
-    vkGetSwapchainImagesKHR(device->getLogicalDevice(), swapchain, &imageCount, swapchainImages.data());
-    imageFormat = surfaceFormat.format;
-
-    // Create image views for each image in the swapchain
-    swapchainImageViews.resize(swapchainImages.size());
-    for (size_t i = 0; i < swapchainImages.size(); i++) 
-    {
-        VkImageViewCreateInfo viewInfo{};
-        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        viewInfo.image = swapchainImages[i];
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewInfo.format = imageFormat;
-        viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
-        viewInfo.subresourceRange.baseArrayLayer = 0;
-        viewInfo.subresourceRange.layerCount = 1;
-
-        if (vkCreateImageView(device->getLogicalDevice(), &viewInfo, nullptr, &swapchainImageViews[i]) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("Failed to create image views!");
-        }
-    }
-}
-
-void Swapchain::cleanup() {
-    // Destroy image views for each swapchain image
-    for (auto imageView : swapchainImageViews)
-    {
-        vkDestroyImageView(device->getLogicalDevice(), imageView, nullptr);
-    }
-    swapchainImageViews.clear();
-
-    // Destroy the swapchain
-    if (swapchain != VK_NULL_HANDLE) 
-    {
-        vkDestroySwapchainKHR(device->getLogicalDevice(), swapchain, nullptr);
-        swapchain = VK_NULL_HANDLE;
-    }
-}
-
-
-uint32_t Swapchain::getImageCount() const
-{
-    return static_cast<uint32_t>(swapchainImages.size());
-}
-
-VkImageView Swapchain::getImageView(size_t index) const
-{
-    if (index >= swapchainImageViews.size()) 
-    {
-        throw std::out_of_range("Requested image view index is out of range.");
-    }
-    return swapchainImageViews[index];
-}
-
-// Helper to choose the best surface format from available options
-VkSurfaceFormatKHR Swapchain::chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) 
-{
-    
-    if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
-    {
-        return { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
-    }
-
-    for (const auto& availableFormat : availableFormats) 
-    {
-        if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
-            availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-            return availableFormat;
-        }
-    }
-
-    // Fallback to a commonly supported format
-    for (const auto& availableFormat : availableFormats) 
-    {
-        if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM) {
-            return availableFormat;
-        }
-    }
-
-    return availableFormats[0];
-}
-
-// Helper to choose the best present mode
-VkPresentModeKHR Swapchain::choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) 
-{
-    for (const auto& availablePresentMode : availablePresentModes) 
-    {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) 
-        {
-            return availablePresentMode;
-        }
-    }
-    return VK_PRESENT_MODE_FIFO_KHR; // Guaranteed to be available
-}
-
-// Helper to choose the appropriate swap extent based on window and surface capabilities
-VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height)
-{
-    if (capabilities.currentExtent.width != UINT32_MAX)
-    {
-        return capabilities.currentExtent;
-    }
-    else {
-        VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
-        actualExtent.width = std::max(capabilities.minImageExtent.width,
-            std::min(capabilities.maxImageExtent.width, actualExtent.width));
-        actualExtent.height = std::max(capabilities.minImageExtent.height,
-            std::min(capabilities.maxImageExtent.height, actualExtent.height));
-        return actualExtent;
-    }
-}
+#include "Swapchain.h"
+
+
+void Swapchain::create(Device* device, VkSurfaceKHR surface, VkExtent2D windowExtent) 
+{
+    this->device = device;
+    offscreen = false;
+
+    // Query surface capabilities
+    VkSurfaceCapabilitiesKHR surfaceCapabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device->getPhysicalDevice(), surface, &surfaceCapabilities);
+
+    // Select surface format, present mode, and swap extent
+    VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(device->getSurfaceFormats(surface));
+    VkPresentModeKHR presentMode = choosePresentMode(device->getPresentModes(surface));
+    extent = chooseSwapExtent(surfaceCapabilities, windowExtent.width, windowExtent.height);
+
+    // Set the image count (minimum plus one for triple-buffering, capped by max)
+    uint32_t imageCount = surfaceCapabilities.minImageCount + 1;
+    if (surfaceCapabilities.maxImageCount > 0 && imageCount > surfaceCapabilities.maxImageCount) {
+        imageCount = surfaceCapabilities.maxImageCount;
+    }
+
+    // Define swapchain create info
+    VkSwapchainCreateInfoKHR createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    createInfo.surface = surface;
+    createInfo.minImageCount = imageCount;
+    createInfo.imageFormat = surfaceFormat.format;
+    createInfo.imageColorSpace = surfaceFormat.colorSpace;
+    createInfo.imageExtent = extent;
+    createInfo.imageArrayLayers = 1;
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    // Define how to handle swapchain images (e.g., in case of multiple queues)
+    QueueFamilyIndices indices = device->findQueueFamilies(device->getPhysicalDevice(), surface);
+    uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+
+    if (indices.graphicsFamily != indices.presentFamily)
+    {
+        createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = 2;
+        createInfo.pQueueFamilyIndices = queueFamilyIndices;
+    }
+    else {
+        createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    createInfo.preTransform = surfaceCapabilities.currentTransform;
+    createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    createInfo.presentMode = presentMode;
+    createInfo.clipped = VK_TRUE;
+    createInfo.oldSwapchain = VK_NULL_HANDLE;
+
+    // Create the swapchain
+    VkResult result = vkCreateSwapchainKHR(device->getLogicalDevice(), &createInfo, nullptr, &swapchain);
+    
+    if (result != VK_SUCCESS)
+    {
+        std::cerr << "Failed to create swapchain! Error code: " << result << std::endl;
+        throw std::runtime_error("Failed to create swapchain!");
+    }
+
+    // Retrieve swapchain images
+    vkGetSwapchainImagesKHR(device->getLogicalDevice(), swapchain, &imageCount, nullptr);
+    swapchainImages.resize(imageCount);
+    vkGetSwapchainImagesKHR(device->getLogicalDevice(), swapchain, &imageCount, swapchainImages.data());
+    imageFormat = surfaceFormat.format;
+
+    createImageViews();
+}
+
+void Swapchain::createOffscreen(Device* device, VkExtent2D extent, uint32_t imageCount)
+{
+    this->device = device;
+    this->extent = extent;
+    offscreen = true;
+    imageFormat = OFFSCREEN_IMAGE_FORMAT;
+    nextOffscreenImage = 0;
+
+    swapchainImages.resize(imageCount);
+    offscreenMemory.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = imageFormat;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device->getLogicalDevice(), &imageInfo, nullptr, &swapchainImages[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create offscreen image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device->getLogicalDevice(), swapchainImages[i], &memRequirements);
+        offscreenMemory[i] = device->getAllocator().allocate(memRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ResourceType::Image);
+        vkBindImageMemory(device->getLogicalDevice(), swapchainImages[i], offscreenMemory[i].memory, offscreenMemory[i].offset);
+    }
+
+    createImageViews();
+}
+
+void Swapchain::createImageViews()
+{
+    // Create image views for each image in the swapchain
+    swapchainImageViews.resize(swapchainImages.size());
+    for (size_t i = 0; i < swapchainImages.size(); i++) 
+    {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = swapchainImages[i];
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = imageFormat;
+        viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device->getLogicalDevice(), &viewInfo, nullptr, &swapchainImageViews[i]) != VK_SUCCESS) 
+        {
+            throw std::runtime_error("Failed to create image views!");
+        }
+    }
+}
+
+void Swapchain::cleanup() {
+    // Destroy image views for each swapchain image
+    for (auto imageView : swapchainImageViews)
+    {
+        vkDestroyImageView(device->getLogicalDevice(), imageView, nullptr);
+    }
+    swapchainImageViews.clear();
+
+    // Offscreen images are ours, swapchain images go with the swapchain
+    if (offscreen)
+    {
+        for (size_t i = 0; i < swapchainImages.size(); i++)
+        {
+            vkDestroyImage(device->getLogicalDevice(), swapchainImages[i], nullptr);
+            device->getAllocator().free(offscreenMemory[i]);
+        }
+        offscreenMemory.clear();
+    }
+    swapchainImages.clear();
+
+    // Destroy the swapchain
+    if (swapchain != VK_NULL_HANDLE) 
+    {
+        vkDestroySwapchainKHR(device->getLogicalDevice(), swapchain, nullptr);
+        swapchain = VK_NULL_HANDLE;
+    }
+}
+
+VkResult Swapchain::acquireNextImage(VkSemaphore imageAvailable, uint32_t& imageIndex)
+{
+    if (offscreen)
+    {
+        imageIndex = nextOffscreenImage;
+        nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(swapchainImages.size());
+        return VK_SUCCESS;
+    }
+
+    return vkAcquireNextImageKHR(device->getLogicalDevice(), swapchain, UINT64_MAX, imageAvailable, VK_NULL_HANDLE, &imageIndex);
+}
+
+VkResult Swapchain::present(VkQueue queue, VkSemaphore renderFinished, uint32_t imageIndex)
+{
+    if (offscreen)
+    {
+        return VK_SUCCESS;
+    }
+
+    VkPresentInfoKHR presentInfo{};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = &renderFinished;
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = &swapchain;
+    presentInfo.pImageIndices = &imageIndex;
+
+    return vkQueuePresentKHR(queue, &presentInfo);
+}
+
+VkImageLayout Swapchain::getFinalLayout() const
+{
+    return offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+}
+
+
+uint32_t Swapchain::getImageCount() const
+{
+    return static_cast<uint32_t>(swapchainImages.size());
+}
+
+VkImageView Swapchain::getImageView(size_t index) const
+{
+    if (index >= swapchainImageViews.size()) 
+    {
+        throw std::out_of_range("Requested image view index is out of range.");
+    }
+    return swapchainImageViews[index];
+}
+
+// Helper to choose the best surface format from available options
+VkSurfaceFormatKHR Swapchain::chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) 
+{
+    
+    if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
+    {
+        return { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+    }
+
+    for (const auto& availableFormat : availableFormats) 
+    {
+        if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB &&
+            availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+            return availableFormat;
+        }
+    }
+
+    // Fallback to a commonly supported format
+    for (const auto& availableFormat : availableFormats) 
+    {
+        if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM) {
+            return availableFormat;
+        }
+    }
+
+    return availableFormats[0];
+}
+
+// Helper to choose the best present mode
+VkPresentModeKHR Swapchain::choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) 
+{
+    for (const auto& availablePresentMode : availablePresentModes) 
+    {
+        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) 
+        {
+            return availablePresentMode;
+        }
+    }
+    return VK_PRESENT_MODE_FIFO_KHR; // Guaranteed to be available
+}
+
+// Helper to choose the appropriate swap extent based on window and surface capabilities
+VkExtent2D Swapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height)
+{
+    if (capabilities.currentExtent.width != UINT32_MAX)
+    {
+        return capabilities.currentExtent;
+    }
+    else {
+        VkExtent2D actualExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+        actualExtent.width = std::max(capabilities.minImageExtent.width,
+            std::min(capabilities.maxImageExtent.width, actualExtent.width));
+        actualExtent.height = std::max(capabilities.minImageExtent.height,
+            std::min(capabilities.maxImageExtent.height, actualExtent.height));
+        return actualExtent;
+    }
+}
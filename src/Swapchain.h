@@ -1,38 +1,64 @@
-#pragma once
-
-#include <vulkan/vulkan.h>
-#include <vector>
-
-#include "Device.h"
-
-class Swapchain
-{
-public:
-    void create(Device* device, VkSurfaceKHR surface, VkExtent2D extent);
-    void cleanup();
-
-    VkSwapchainKHR getSwapchain() const { return swapchain; }
-    VkFormat getImageFormat() const { return imageFormat; }
-    VkExtent2D getExtent() const { return extent; }
-    const std::vector<VkImageView>& getImageViews() const { return swapchainImageViews; }
-
-    uint32_t getImageCount() const;                 // Returns the number of images in the swapchain
-    VkImageView getImageView(size_t index) const;   // Returns the image view at a specified index
-
-private:
-    // Helper functions for configuring the swapchain
-    VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-    VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
-    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height);
-
-    // Swapchain handle and properties
-    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
-    VkFormat imageFormat;                           // Format of swapchain images
-    VkExtent2D extent;                              // Dimensions of swapchain images
-    std::vector<VkImage> swapchainImages;           // Images in the swapchain
-    std::vector<VkImageView> swapchainImageViews;   // Image views for each swapchain image
-
-    // Reference to the logical device (for cleanup, etc.)
-    const Device* device = nullptr;
-};
-
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "Device.h"
+
+// Images rendered in turn when there is no surface to present to
+const uint32_t OFFSCREEN_IMAGE_COUNT = 3;
+// Same format the windowed path prefers, so pipelines and shaders behave the same
+const VkFormat OFFSCREEN_IMAGE_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
+
+// The images the renderer draws into, either a VkSwapchainKHR presenting to a surface or,
+// when running headless, images owned here that are never presented.
+class Swapchain
+{
+public:
+    void create(Device* device, VkSurfaceKHR surface, VkExtent2D extent);
+    // Headless, needs neither a surface nor VK_KHR_swapchain
+    void createOffscreen(Device* device, VkExtent2D extent, uint32_t imageCount = OFFSCREEN_IMAGE_COUNT);
+    void cleanup();
+
+    bool isOffscreen() const { return offscreen; }
+
+    // Offscreen images take turns and need no semaphore, the caller waits for the frame that last used one
+    VkResult acquireNextImage(VkSemaphore imageAvailable, uint32_t& imageIndex);
+    VkResult present(VkQueue queue, VkSemaphore renderFinished, uint32_t imageIndex);
+
+    // Layout the render pass leaves the images in, offscreen images are ready to be copied out
+    VkImageLayout getFinalLayout() const;
+
+    VkSwapchainKHR getSwapchain() const { return swapchain; }
+    VkFormat getImageFormat() const { return imageFormat; }
+    VkExtent2D getExtent() const { return extent; }
+    const std::vector<VkImageView>& getImageViews() const { return swapchainImageViews; }
+
+    uint32_t getImageCount() const;                 // Returns the number of images in the swapchain
+    VkImageView getImageView(size_t index) const;   // Returns the image view at a specified index
+    VkImage getImage(size_t index) const { return swapchainImages[index]; }
+
+private:
+    // Helper functions for configuring the swapchain
+    VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
+    VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+    VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, int width, int height);
+
+    // Swapchain handle and properties
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    VkFormat imageFormat;                           // Format of swapchain images
+    VkExtent2D extent;                              // Dimensions of swapchain images
+    std::vector<VkImage> swapchainImages;           // Images in the swapchain
+    std::vector<VkImageView> swapchainImageViews;   // Image views for each image in the swapchain
+
+    // Headless mode, the images and their memory belong to this object
+    bool offscreen = false;
+    std::vector<Allocation> offscreenMemory;
+    uint32_t nextOffscreenImage = 0;
+
+    // Reference to the logical device (for cleanup, etc.)
+    Device* device = nullptr;
+
+    void createImageViews();
+};
+
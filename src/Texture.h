@@ -1,11 +1,15 @@
-#pragma once
-
-#include <vulkan/vulkan.h>
-#include <string>
-
-struct Texture {
-    VkImage image;
-    VkDeviceMemory memory;
-    VkImageView imageView;
-    int textId;
-};
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+
+#include "MemoryAllocator.h"
+
+struct Texture {
+    VkImage image;
+    Allocation memory;
+    VkImageView imageView;
+    int textId;
+    uint32_t mipLevels = 1;
+    VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+};
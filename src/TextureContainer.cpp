@@ -0,0 +1,467 @@
+#include "TextureContainer.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace
+{
+    struct FormatInfo
+    {
+        VkFormat format;
+        ImageBlock block;
+        VkFormat fallback;      // RGBA8 format with the same encoding
+    };
+
+    const FormatInfo FORMATS[] = {
+        { VK_FORMAT_R8G8B8A8_UNORM, { 1, 1, 4 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_R8G8B8A8_SRGB, { 1, 1, 4 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_BC1_RGB_UNORM_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_BC1_RGB_SRGB_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_BC3_UNORM_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_BC3_SRGB_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_BC5_UNORM_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_BC7_UNORM_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_BC7_SRGB_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, { 4, 4, 8 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_ASTC_4x4_UNORM_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_ASTC_4x4_SRGB_BLOCK, { 4, 4, 16 }, VK_FORMAT_R8G8B8A8_SRGB },
+        { VK_FORMAT_ASTC_8x8_UNORM_BLOCK, { 8, 8, 16 }, VK_FORMAT_R8G8B8A8_UNORM },
+        { VK_FORMAT_ASTC_8x8_SRGB_BLOCK, { 8, 8, 16 }, VK_FORMAT_R8G8B8A8_SRGB },
+    };
+
+    const FormatInfo* findFormat(VkFormat format)
+    {
+        for (const FormatInfo& info : FORMATS)
+        {
+            if (info.format == format)
+            {
+                return &info;
+            }
+        }
+        return nullptr;
+    }
+
+    const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct Ktx2Header
+    {
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint32_t sgdByteOffset[2];      // 64 bit values at 4 byte aligned offsets, unused
+        uint32_t sgdByteLength[2];
+    };
+    static_assert(sizeof(Ktx2Header) == 68, "KTX2 header layout");
+
+    struct Ktx2Level
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    uint32_t fourCC(char a, char b, char c, char d)
+    {
+        return uint32_t(uint8_t(a)) | uint32_t(uint8_t(b)) << 8 | uint32_t(uint8_t(c)) << 16 | uint32_t(uint8_t(d)) << 24;
+    }
+
+    // Offsets into the 124 byte DDS_HEADER that follows the magic
+    const size_t DDS_HEADER_SIZE = 124;
+    const size_t DDS_HEIGHT = 8;
+    const size_t DDS_WIDTH = 12;
+    const size_t DDS_DEPTH = 20;
+    const size_t DDS_MIP_COUNT = 24;
+    const size_t DDS_PIXEL_FLAGS = 76;
+    const size_t DDS_FOURCC = 80;
+    const size_t DDS_RGB_BIT_COUNT = 84;
+    const size_t DDS_MASKS = 88;
+    const size_t DDS_CAPS2 = 108;
+    const size_t DDS_DX10_SIZE = 20;
+
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDPF_RGB = 0x40;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+
+    // DXGI_FORMAT values of the DX10 extension header
+    VkFormat formatFromDxgi(uint32_t dxgiFormat)
+    {
+        switch (dxgiFormat)
+        {
+        case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+        case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+        case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    uint32_t readU32(const char* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // RGB565 to 8 bit per channel
+    void unpack565(uint16_t color, unsigned char* rgb)
+    {
+        rgb[0] = static_cast<unsigned char>(((color >> 11) & 31) * 255 / 31);
+        rgb[1] = static_cast<unsigned char>(((color >> 5) & 63) * 255 / 63);
+        rgb[2] = static_cast<unsigned char>((color & 31) * 255 / 31);
+    }
+
+    // Colour part of BC1 and BC3, out is 4x4 RGBA8. BC3 always uses the four colour mode
+    void decodeColorBlock(const unsigned char* block, unsigned char* out, bool allowTransparent)
+    {
+        uint16_t color0 = uint16_t(block[0] | block[1] << 8);
+        uint16_t color1 = uint16_t(block[2] | block[3] << 8);
+
+        unsigned char palette[4][4];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+
+        bool fourColors = color0 > color1 || !allowTransparent;
+        for (int channel = 0; channel < 3; ++channel)
+        {
+            if (fourColors)
+            {
+                palette[2][channel] = static_cast<unsigned char>((2 * palette[0][channel] + palette[1][channel]) / 3);
+                palette[3][channel] = static_cast<unsigned char>((palette[0][channel] + 2 * palette[1][channel]) / 3);
+            }
+            else
+            {
+                palette[2][channel] = static_cast<unsigned char>((palette[0][channel] + palette[1][channel]) / 2);
+                palette[3][channel] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColors ? 255 : 0;
+
+        uint32_t indices = readU32(reinterpret_cast<const char*>(block + 4));
+        for (int texel = 0; texel < 16; ++texel)
+        {
+            std::memcpy(out + texel * 4, palette[(indices >> (texel * 2)) & 3], 4);
+        }
+    }
+
+    // One BC4 style channel, as used by the alpha of BC3 and both channels of BC5
+    void decodeChannelBlock(const unsigned char* block, unsigned char* out, int channel)
+    {
+        unsigned char values[8];
+        values[0] = block[0];
+        values[1] = block[1];
+        if (values[0] > values[1])
+        {
+            for (int i = 1; i < 7; ++i)
+            {
+                values[i + 1] = static_cast<unsigned char>(((7 - i) * values[0] + i * values[1]) / 7);
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; ++i)
+            {
+                values[i + 1] = static_cast<unsigned char>(((5 - i) * values[0] + i * values[1]) / 5);
+            }
+            values[6] = 0;
+            values[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i)
+        {
+            indices |= uint64_t(block[2 + i]) << (8 * i);
+        }
+        for (int texel = 0; texel < 16; ++texel)
+        {
+            out[texel * 4 + channel] = values[(indices >> (texel * 3)) & 7];
+        }
+    }
+}
+
+bool TextureContainer::isContainer(const std::string& path)
+{
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos)
+    {
+        return false;
+    }
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == "ktx2" || extension == "dds";
+}
+
+void TextureContainer::load(const std::string& path)
+{
+    this->path = path;
+    levels.clear();
+
+    if (!file.open(path))
+    {
+        throw std::runtime_error("Failed to load texture image! (" + path + ")");
+    }
+
+    if (file.getSize() >= sizeof(KTX2_IDENTIFIER) && std::memcmp(file.getData(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+    {
+        parseKtx2();
+    }
+    else if (file.getSize() >= 4 && readU32(file.getData()) == fourCC('D', 'D', 'S', ' '))
+    {
+        parseDds();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown texture container! (" + path + ")");
+    }
+}
+
+VkFormat TextureContainer::getFallbackFormat() const
+{
+    return findFormat(format)->fallback;
+}
+
+void TextureContainer::parseKtx2()
+{
+    const char* data = file.getData();
+    size_t size = file.getSize();
+
+    if (size < sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header))
+    {
+        throw std::runtime_error("Truncated KTX2 file! (" + path + ")");
+    }
+
+    Ktx2Header header;
+    std::memcpy(&header, data + sizeof(KTX2_IDENTIFIER), sizeof(header));
+
+    if (header.supercompressionScheme != 0)
+    {
+        throw std::runtime_error("Supercompressed KTX2 files are not supported! (" + path + ")");
+    }
+    if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0)
+    {
+        throw std::runtime_error("Only 2D KTX2 textures are supported! (" + path + ")");
+    }
+
+    setFormat(static_cast<VkFormat>(header.vkFormat));
+    width = header.pixelWidth;
+    height = header.pixelHeight;
+
+    // A level count of 0 asks for generated mips, only the base level is stored. Levels beyond
+    // the 1x1 one are ignored like in parseDds
+    uint32_t levelCount = std::min(header.levelCount, getMipLevelCount(width, height));
+    if (header.levelCount == 0)
+    {
+        generateMips = true;
+        levelCount = 1;
+    }
+    size_t indexOffset = sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header);
+    if (indexOffset + levelCount * sizeof(Ktx2Level) > size)
+    {
+        throw std::runtime_error("Truncated KTX2 file! (" + path + ")");
+    }
+
+    // The level index is ordered from the base level down
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        Ktx2Level entry;
+        std::memcpy(&entry, data + indexOffset + level * sizeof(Ktx2Level), sizeof(entry));
+        // Compared without adding the two, a crafted offset could wrap around
+        if (entry.byteLength < getMipLevelSize(width, height, level, block) ||
+            entry.byteOffset > size || entry.byteLength > size - entry.byteOffset)
+        {
+            throw std::runtime_error("Invalid KTX2 level! (" + path + ")");
+        }
+        levels.push_back(data + entry.byteOffset);
+    }
+}
+
+void TextureContainer::parseDds()
+{
+    const char* data = file.getData();
+    size_t size = file.getSize();
+
+    if (size < 4 + DDS_HEADER_SIZE)
+    {
+        throw std::runtime_error("Truncated DDS file! (" + path + ")");
+    }
+
+    const char* header = data + 4;
+    uint32_t pixelFlags = readU32(header + DDS_PIXEL_FLAGS);
+    uint32_t code = readU32(header + DDS_FOURCC);
+    size_t dataOffset = 4 + DDS_HEADER_SIZE;
+
+    if (readU32(header + DDS_DEPTH) > 1 || (readU32(header + DDS_CAPS2) & DDSCAPS2_CUBEMAP))
+    {
+        throw std::runtime_error("Only 2D DDS textures are supported! (" + path + ")");
+    }
+
+    VkFormat ddsFormat = VK_FORMAT_UNDEFINED;
+    if ((pixelFlags & DDPF_FOURCC) && code == fourCC('D', 'X', '1', '0'))
+    {
+        if (size < dataOffset + DDS_DX10_SIZE)
+        {
+            throw std::runtime_error("Truncated DDS file! (" + path + ")");
+        }
+
+        const char* dx10 = data + dataOffset;
+        const uint32_t arraySize = readU32(dx10 + 12);
+        if (arraySize > 1)
+        {
+            throw std::runtime_error("Only 2D DDS textures are supported! (" + path + ")");
+        }
+        ddsFormat = formatFromDxgi(readU32(dx10));
+        dataOffset += DDS_DX10_SIZE;
+    }
+    else if (pixelFlags & DDPF_FOURCC)
+    {
+        // Legacy files carry no colour space, DXT1 and DXT5 are taken to be colour maps
+        if (code == fourCC('D', 'X', 'T', '1'))
+        {
+            ddsFormat = VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        }
+        else if (code == fourCC('D', 'X', 'T', '5'))
+        {
+            ddsFormat = VK_FORMAT_BC3_SRGB_BLOCK;
+        }
+        else if (code == fourCC('A', 'T', 'I', '2') || code == fourCC('B', 'C', '5', 'U'))
+        {
+            ddsFormat = VK_FORMAT_BC5_UNORM_BLOCK;
+        }
+    }
+    else if ((pixelFlags & DDPF_RGB) && readU32(header + DDS_RGB_BIT_COUNT) == 32 &&
+             readU32(header + DDS_MASKS) == 0x000000ff && readU32(header + DDS_MASKS + 4) == 0x0000ff00 &&
+             readU32(header + DDS_MASKS + 8) == 0x00ff0000)
+    {
+        ddsFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    }
+
+    if (ddsFormat == VK_FORMAT_UNDEFINED)
+    {
+        throw std::runtime_error("Unsupported DDS format! (" + path + ")");
+    }
+
+    setFormat(ddsFormat);
+    width = readU32(header + DDS_WIDTH);
+    height = readU32(header + DDS_HEIGHT);
+    if (width == 0 || height == 0)
+    {
+        throw std::runtime_error("Invalid DDS size! (" + path + ")");
+    }
+
+    uint32_t levelCount = std::max(1u, readU32(header + DDS_MIP_COUNT));
+    levelCount = std::min(levelCount, getMipLevelCount(width, height));
+    setLevels(dataOffset, levelCount);
+}
+
+// Levels stored back to back from offset, largest first
+void TextureContainer::setLevels(uint64_t offset, uint32_t levelCount)
+{
+    for (uint32_t level = 0; level < levelCount; ++level)
+    {
+        uint64_t levelSize = getMipLevelSize(width, height, level, block);
+        if (offset + levelSize > file.getSize())
+        {
+            throw std::runtime_error("Truncated texture data! (" + path + ")");
+        }
+        levels.push_back(file.getData() + offset);
+        offset += levelSize;
+    }
+}
+
+void TextureContainer::setFormat(VkFormat format)
+{
+    const FormatInfo* info = findFormat(format);
+    if (info == nullptr)
+    {
+        throw std::runtime_error("Unsupported texture format " + std::to_string(format) + "! (" + path + ")");
+    }
+
+    this->format = format;
+    block = info->block;
+}
+
+std::vector<unsigned char> TextureContainer::decodeRgba8() const
+{
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+    const unsigned char* src = static_cast<const unsigned char*>(levels[0]);
+
+    if (block.width == 1)
+    {
+        std::memcpy(pixels.data(), src, pixels.size());
+        return pixels;
+    }
+
+    bool bc1 = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ||
+               format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+    bool bc3 = format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+    bool bc5 = format == VK_FORMAT_BC5_UNORM_BLOCK;
+    if (!bc1 && !bc3 && !bc5)
+    {
+        throw std::runtime_error("Texture format " + std::to_string(format) + " is not supported by the device! (" + path + ")");
+    }
+
+    uint32_t blocksWide = (width + 3) / 4;
+    uint32_t blocksHigh = (height + 3) / 4;
+    for (uint32_t by = 0; by < blocksHigh; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocksWide; ++bx)
+        {
+            unsigned char texels[16 * 4];
+            const unsigned char* encoded = src + (static_cast<size_t>(by) * blocksWide + bx) * block.bytes;
+            if (bc1)
+            {
+                decodeColorBlock(encoded, texels, true);
+            }
+            else if (bc3)
+            {
+                decodeColorBlock(encoded + 8, texels, false);
+                decodeChannelBlock(encoded, texels, 3);
+            }
+            else
+            {
+                // Two channel normal maps, blue stays empty
+                std::memset(texels, 0, sizeof(texels));
+                decodeChannelBlock(encoded, texels, 0);
+                decodeChannelBlock(encoded + 8, texels, 1);
+                for (int texel = 0; texel < 16; ++texel)
+                {
+                    texels[texel * 4 + 3] = 255;
+                }
+            }
+
+            // Blocks hanging over the edge are clipped
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+                {
+                    std::memcpy(&pixels[((static_cast<size_t>(by) * 4 + y) * width + bx * 4 + x) * 4], &texels[(y * 4 + x) * 4], 4);
+                }
+            }
+        }
+    }
+    return pixels;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "MipChain.h"
+
+// A KTX2 or DDS texture file, mapped and uploaded as stored with all its mip levels.
+// Block compressed formats (BC1/3/5/7, ETC2, ASTC) and RGBA8 are understood, 2D images only,
+// supercompressed KTX2 files are rejected.
+class TextureContainer
+{
+public:
+    // Decided by the file extension
+    static bool isContainer(const std::string& path);
+
+    // Map and parse the file, throws when it cannot be used
+    void load(const std::string& path);
+
+    VkFormat getFormat() const { return format; }
+    uint32_t getWidth() const { return width; }
+    uint32_t getHeight() const { return height; }
+    uint32_t getLevelCount() const { return static_cast<uint32_t>(levels.size()); }
+    // The file only stores the base level and asks for the other mips to be generated
+    bool requestsGeneratedMips() const { return generateMips; }
+    const ImageBlock& getBlock() const { return block; }
+
+    // Level i as stored, inside the mapping
+    const std::vector<const void*>& getLevels() const { return levels; }
+
+    // Format to use when the device cannot sample getFormat()
+    VkFormat getFallbackFormat() const;
+
+    // Level 0 decoded to RGBA8, for BC1, BC3, BC5 and RGBA8 data. Throws for other formats
+    std::vector<unsigned char> decodeRgba8() const;
+
+private:
+    MappedFile file;
+    std::string path;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    ImageBlock block;
+    std::vector<const void*> levels;
+    bool generateMips = false;
+
+    void parseKtx2();
+    void parseDds();
+    void setLevels(uint64_t offset, uint32_t levelCount);
+    void setFormat(VkFormat format);
+};
@@ -0,0 +1,197 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t TextureStreamer::getTailLevel(uint32_t width, uint32_t height, uint32_t levelCount)
+{
+    uint32_t level = 0;
+    while (level + 1 < levelCount && std::max(getMipExtent(width, level), getMipExtent(height, level)) > STREAMING_TAIL_SIZE)
+    {
+        level++;
+    }
+    return level;
+}
+
+void TextureStreamer::addTexture(int textureId, uint32_t width, uint32_t height, uint32_t levelCount, const ImageBlock& block)
+{
+    if (textureId >= static_cast<int>(entries.size()))
+    {
+        entries.resize(textureId + 1);
+    }
+
+    Entry& entry = entries[textureId];
+    entry = Entry{};
+    entry.active = true;
+    entry.width = width;
+    entry.height = height;
+    entry.levelCount = levelCount;
+    entry.block = block;
+    entry.tail = getTailLevel(width, height, levelCount);
+    entry.resident = entry.target = entry.wanted = entry.tail;
+
+    residentBytes += getChainBytes(entry, entry.tail);
+    streamedCount++;
+}
+
+void TextureStreamer::removeTexture(int textureId)
+{
+    if (!isStreamed(textureId))
+    {
+        return;
+    }
+
+    Entry& entry = entries[textureId];
+    residentBytes -= getChainBytes(entry, std::min(entry.resident, entry.target));
+    if (entry.resident != entry.target)
+    {
+        pendingCount--;
+    }
+    entry = Entry{};
+    streamedCount--;
+}
+
+bool TextureStreamer::isStreamed(int textureId) const
+{
+    return textureId >= 0 && textureId < static_cast<int>(entries.size()) && entries[textureId].active;
+}
+
+void TextureStreamer::request(int textureId, float level, float priority)
+{
+    if (!isStreamed(textureId))
+    {
+        return;
+    }
+
+    Entry& entry = entries[textureId];
+    uint32_t wanted = static_cast<uint32_t>(std::max(0.0f, std::floor(level)));
+    wanted = std::min(wanted, entry.tail);
+
+    if (entry.lastUsed != frame)
+    {
+        entry.lastUsed = frame;
+        entry.wanted = wanted;
+        entry.priority = priority;
+    }
+    else
+    {
+        entry.wanted = std::min(entry.wanted, wanted);
+        entry.priority = std::max(entry.priority, priority);
+    }
+}
+
+std::vector<ResidencyChange> TextureStreamer::update(uint32_t maxChanges)
+{
+    std::vector<ResidencyChange> changes;
+
+    // Drawn this frame and missing levels, most important first
+    std::vector<int> missing;
+    for (int id = 0; id < static_cast<int>(entries.size()); ++id)
+    {
+        const Entry& entry = entries[id];
+        if (entry.active && entry.lastUsed == frame && entry.resident == entry.target && entry.wanted < entry.resident)
+        {
+            missing.push_back(id);
+        }
+    }
+    std::sort(missing.begin(), missing.end(), [&](int a, int b) { return entries[a].priority > entries[b].priority; });
+
+    // Eviction order, least recently used first. Unused textures go back to their tail,
+    // textures still drawn only give up levels finer than they want
+    std::vector<int> victims;
+    for (int id = 0; id < static_cast<int>(entries.size()); ++id)
+    {
+        const Entry& entry = entries[id];
+        uint32_t keep = entry.lastUsed == frame ? entry.wanted : entry.tail;
+        if (entry.active && entry.resident == entry.target && keep > entry.resident)
+        {
+            victims.push_back(id);
+        }
+    }
+    std::sort(victims.begin(), victims.end(), [&](int a, int b) { return entries[a].lastUsed < entries[b].lastUsed; });
+    size_t nextVictim = 0;
+    uint64_t freeing = 0;
+
+    auto evictNext = [&]()
+    {
+        int victimId = victims[nextVictim++];
+        Entry& victim = entries[victimId];
+        uint32_t keep = victim.lastUsed == frame ? victim.wanted : victim.tail;
+        freeing += getChainBytes(victim, victim.resident) - getChainBytes(victim, keep);
+        startChange(victimId, keep, changes);
+    };
+
+    for (int id : missing)
+    {
+        if (changes.size() >= maxChanges)
+        {
+            break;
+        }
+
+        Entry& entry = entries[id];
+        uint64_t extra = getChainBytes(entry, entry.wanted) - getChainBytes(entry, entry.resident);
+
+        while (residentBytes - freeing + extra > budget && nextVictim < victims.size() && changes.size() < maxChanges)
+        {
+            evictNext();
+        }
+
+        // Memory given back by evictions only counts once they have completed, until then the
+        // texture waits
+        if (residentBytes + extra <= budget && changes.size() < maxChanges)
+        {
+            startChange(id, entry.wanted, changes);
+        }
+    }
+
+    // Over budget, e.g. after lowering it, trim until it fits again
+    while (residentBytes - freeing > budget && nextVictim < victims.size() && changes.size() < maxChanges)
+    {
+        evictNext();
+    }
+
+    frame++;
+    return changes;
+}
+
+void TextureStreamer::setResident(int textureId, uint32_t level)
+{
+    if (!isStreamed(textureId))
+    {
+        return;
+    }
+
+    Entry& entry = entries[textureId];
+    if (entry.resident != entry.target)
+    {
+        pendingCount--;
+    }
+
+    residentBytes -= getChainBytes(entry, std::min(entry.resident, entry.target));
+    entry.resident = entry.target = level;
+    residentBytes += getChainBytes(entry, level);
+}
+
+uint64_t TextureStreamer::getChainBytes(const Entry& entry, uint32_t level)
+{
+    uint64_t bytes = 0;
+    for (uint32_t i = level; i < entry.levelCount; ++i)
+    {
+        bytes += getMipLevelSize(entry.width, entry.height, i, entry.block);
+    }
+    return bytes;
+}
+
+// Memory for more levels is counted from the start, memory given back once the change is done
+void TextureStreamer::startChange(int textureId, uint32_t level, std::vector<ResidencyChange>& changes)
+{
+    Entry& entry = entries[textureId];
+    if (level < entry.resident)
+    {
+        residentBytes += getChainBytes(entry, level) - getChainBytes(entry, entry.resident);
+    }
+    entry.target = level;
+    pendingCount++;
+
+    changes.push_back({ textureId, level });
+}
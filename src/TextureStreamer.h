@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MipChain.h"
+
+// Texture memory streamed textures may use, in bytes
+const uint64_t DEFAULT_TEXTURE_BUDGET = 256ull * 1024 * 1024;
+
+// Levels of this size and smaller are always resident, textures are created with just these
+const uint32_t STREAMING_TAIL_SIZE = 64;
+
+// Residency changes started per frame, each one uploads the new resident levels of a texture
+const uint32_t MAX_STREAMING_CHANGES_PER_FRAME = 4;
+
+// Texture descriptor sets kept free for swapping in streamed textures
+const uint32_t STREAMING_SPARE_DESCRIPTOR_SETS = 32;
+
+struct ResidencyChange
+{
+    int textureId = -1;
+    uint32_t level = 0;         // first resident level after the change
+};
+
+// Decides which mip levels of streamed textures are resident under a memory budget.
+// Every frame the renderer reports the level each drawn texture wants and how important it is.
+// The most important missing levels are streamed in while the budget allows. The least recently
+// used textures are trimmed back to the levels they want, or to their tail, to make room.
+// Only decides, the renderer uploads and reports back with setResident.
+class TextureStreamer
+{
+public:
+    void setBudget(uint64_t bytes) { budget = bytes; }
+    uint64_t getBudget() const { return budget; }
+
+    // First level whose size is at most STREAMING_TAIL_SIZE
+    static uint32_t getTailLevel(uint32_t width, uint32_t height, uint32_t levelCount);
+
+    // Track a texture created with its tail levels resident
+    void addTexture(int textureId, uint32_t width, uint32_t height, uint32_t levelCount, const ImageBlock& block);
+    void removeTexture(int textureId);
+    bool isStreamed(int textureId) const;
+
+    // The texture is drawn this frame at level, a fractional LOD. The most detailed request wins
+    void request(int textureId, float level, float priority);
+
+    // Changes to start now, at most maxChanges. Each one stays pending until setResident
+    std::vector<ResidencyChange> update(uint32_t maxChanges);
+    void setResident(int textureId, uint32_t level);
+
+    uint64_t getResidentBytes() const { return residentBytes; }
+    uint32_t getStreamedCount() const { return streamedCount; }
+    uint32_t getPendingCount() const { return pendingCount; }
+
+private:
+    struct Entry
+    {
+        bool active = false;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levelCount = 0;
+        ImageBlock block;
+        uint32_t tail = 0;
+        uint32_t resident = 0;
+        uint32_t target = 0;            // equals resident unless a change is pending
+        uint32_t wanted = 0;
+        float priority = 0.0f;
+        uint64_t lastUsed = 0;          // frame of the last request
+    };
+
+    std::vector<Entry> entries;         // indexed by texture id
+    uint64_t budget = DEFAULT_TEXTURE_BUDGET;
+    uint64_t residentBytes = 0;         // counts the larger of resident and target while pending
+    uint64_t frame = 1;
+    uint32_t streamedCount = 0;
+    uint32_t pendingCount = 0;
+
+    static uint64_t getChainBytes(const Entry& entry, uint32_t level);
+    void startChange(int textureId, uint32_t level, std::vector<ResidencyChange>& changes);
+};
@@ -0,0 +1,300 @@
+#include "TlsfAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Index of the highest set bit, value must not be 0
+static uint32_t findMsb(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+// Index of the lowest set bit, value must not be 0
+static uint32_t findLsb(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+void TlsfAllocator::init(uint64_t size)
+{
+    capacity = size;
+    reset();
+}
+
+void TlsfAllocator::reset()
+{
+    nodes.clear();
+    unusedNodes.clear();
+
+    flBitmap = 0;
+    for (uint32_t fl = 0; fl < FL_COUNT; ++fl)
+    {
+        slBitmap[fl] = 0;
+        for (uint32_t sl = 0; sl < SL_COUNT; ++sl)
+        {
+            freeHeads[fl][sl] = INVALID_NODE;
+        }
+    }
+
+    freeSize = capacity;
+    if (capacity > 0)
+    {
+        insertFree(createNode(0, capacity));
+    }
+}
+
+uint32_t TlsfAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+    if (size == 0)
+    {
+        return INVALID_NODE;
+    }
+    if (alignment == 0)
+    {
+        alignment = 1;
+    }
+
+    // Any block this large can hold the request however its start is aligned
+    uint32_t node = findFreeBlock(size + alignment - 1);
+    if (node == INVALID_NODE)
+    {
+        return INVALID_NODE;
+    }
+    removeFree(node);
+
+    // Give the padding in front of the aligned offset back as its own free block
+    uint64_t alignedOffset = (nodes[node].offset + alignment - 1) / alignment * alignment;
+    uint64_t padding = alignedOffset - nodes[node].offset;
+    if (padding > 0)
+    {
+        uint32_t aligned = split(node, padding);
+        insertFree(node);
+        node = aligned;
+    }
+
+    // And the tail that is not needed
+    if (nodes[node].size > size)
+    {
+        insertFree(split(node, size));
+    }
+
+    nodes[node].used = true;
+    freeSize -= nodes[node].size;
+    offset = nodes[node].offset;
+    return node;
+}
+
+void TlsfAllocator::free(uint32_t node)
+{
+    if (node >= nodes.size() || !nodes[node].used)
+    {
+        throw std::runtime_error("Invalid TLSF free!");
+    }
+
+    nodes[node].used = false;
+    freeSize += nodes[node].size;
+
+    // Merge with the free neighbours so the range does not fragment over time
+    uint32_t prev = nodes[node].prevPhysical;
+    if (prev != INVALID_NODE && !nodes[prev].used)
+    {
+        removeFree(prev);
+        nodes[prev].size += nodes[node].size;
+        nodes[prev].nextPhysical = nodes[node].nextPhysical;
+        if (nodes[node].nextPhysical != INVALID_NODE)
+        {
+            nodes[nodes[node].nextPhysical].prevPhysical = prev;
+        }
+        releaseNode(node);
+        node = prev;
+    }
+
+    uint32_t next = nodes[node].nextPhysical;
+    if (next != INVALID_NODE && !nodes[next].used)
+    {
+        removeFree(next);
+        nodes[node].size += nodes[next].size;
+        nodes[node].nextPhysical = nodes[next].nextPhysical;
+        if (nodes[next].nextPhysical != INVALID_NODE)
+        {
+            nodes[nodes[next].nextPhysical].prevPhysical = node;
+        }
+        releaseNode(next);
+    }
+
+    insertFree(node);
+}
+
+uint64_t TlsfAllocator::getLargestFreeSize() const
+{
+    if (flBitmap == 0)
+    {
+        return 0;
+    }
+
+    // The largest block is in the highest non empty sub class, whose blocks differ in size
+    uint32_t fl = findMsb(flBitmap);
+    uint32_t sl = findMsb(slBitmap[fl]);
+    uint64_t largest = 0;
+    for (uint32_t node = freeHeads[fl][sl]; node != INVALID_NODE; node = nodes[node].nextFree)
+    {
+        largest = std::max(largest, nodes[node].size);
+    }
+    return largest;
+}
+
+void TlsfAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    if (size < SL_COUNT)
+    {
+        // small sizes all live in the first class, one sub class per size
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+        return;
+    }
+
+    uint32_t msb = findMsb(size);
+    fl = msb - SL_BITS + 1;
+    sl = static_cast<uint32_t>(size >> (msb - SL_BITS)) - SL_COUNT;
+}
+
+uint32_t TlsfAllocator::findFreeBlock(uint64_t size) const
+{
+    // Round up to the next sub class, so every block found there is large enough
+    if (size >= SL_COUNT)
+    {
+        uint64_t round = (1ull << (findMsb(size) - SL_BITS)) - 1;
+        if (size > UINT64_MAX - round)
+        {
+            return INVALID_NODE;
+        }
+        size += round;
+    }
+
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+
+    uint32_t slMap = slBitmap[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        uint64_t flMap = (fl + 1 < 64) ? (flBitmap & (~0ull << (fl + 1))) : 0;
+        if (flMap == 0)
+        {
+            return INVALID_NODE;
+        }
+        fl = findLsb(flMap);
+        slMap = slBitmap[fl];
+    }
+    sl = findLsb(slMap);
+
+    return freeHeads[fl][sl];
+}
+
+uint32_t TlsfAllocator::createNode(uint64_t offset, uint64_t size)
+{
+    uint32_t node;
+    if (!unusedNodes.empty())
+    {
+        node = unusedNodes.back();
+        unusedNodes.pop_back();
+        nodes[node] = Node{};
+    }
+    else
+    {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+
+    nodes[node].offset = offset;
+    nodes[node].size = size;
+    return node;
+}
+
+void TlsfAllocator::releaseNode(uint32_t node)
+{
+    unusedNodes.push_back(node);
+}
+
+void TlsfAllocator::insertFree(uint32_t node)
+{
+    uint32_t fl, sl;
+    mapping(nodes[node].size, fl, sl);
+
+    uint32_t head = freeHeads[fl][sl];
+    nodes[node].prevFree = INVALID_NODE;
+    nodes[node].nextFree = head;
+    if (head != INVALID_NODE)
+    {
+        nodes[head].prevFree = node;
+    }
+    freeHeads[fl][sl] = node;
+
+    flBitmap |= 1ull << fl;
+    slBitmap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFree(uint32_t node)
+{
+    uint32_t prev = nodes[node].prevFree;
+    uint32_t next = nodes[node].nextFree;
+
+    if (prev != INVALID_NODE)
+    {
+        nodes[prev].nextFree = next;
+    }
+    if (next != INVALID_NODE)
+    {
+        nodes[next].prevFree = prev;
+    }
+
+    uint32_t fl, sl;
+    mapping(nodes[node].size, fl, sl);
+    if (freeHeads[fl][sl] == node)
+    {
+        freeHeads[fl][sl] = next;
+        if (next == INVALID_NODE)
+        {
+            slBitmap[fl] &= ~(1u << sl);
+            if (slBitmap[fl] == 0)
+            {
+                flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+
+    nodes[node].prevFree = INVALID_NODE;
+    nodes[node].nextFree = INVALID_NODE;
+}
+
+// Keep the first size bytes in node, the rest becomes a new node right after it
+uint32_t TlsfAllocator::split(uint32_t node, uint64_t size)
+{
+    uint32_t rest = createNode(nodes[node].offset + size, nodes[node].size - size);
+
+    nodes[node].size = size;
+    nodes[rest].prevPhysical = node;
+    nodes[rest].nextPhysical = nodes[node].nextPhysical;
+    if (nodes[node].nextPhysical != INVALID_NODE)
+    {
+        nodes[nodes[node].nextPhysical].prevPhysical = rest;
+    }
+    nodes[node].nextPhysical = rest;
+
+    return rest;
+}
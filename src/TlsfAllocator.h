@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Two level segregated fit allocator over an abstract range of offsets.
+// It only hands out offsets, what the range backs (device memory, a buffer, ...) is up to the caller.
+// Free blocks are binned by size class and merged with their neighbours on free, both are O(1).
+class TlsfAllocator
+{
+public:
+    static const uint32_t INVALID_NODE = UINT32_MAX;
+
+    void init(uint64_t size);
+
+    // Drop every allocation, the whole range becomes one free block again
+    void reset();
+
+    // Returns the node of the allocation or INVALID_NODE when no free block is large enough
+    uint32_t allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+    void free(uint32_t node);
+
+    uint64_t getCapacity() const { return capacity; }
+    uint64_t getFreeSize() const { return freeSize; }
+    // Size of the largest free block, what fits in one allocation without alignment padding
+    uint64_t getLargestFreeSize() const;
+    bool isEmpty() const { return freeSize == capacity; }
+
+private:
+    // Every power of two size class is split into SL_COUNT linear sub classes
+    static const uint32_t SL_BITS = 4;
+    static const uint32_t SL_COUNT = 1u << SL_BITS;
+    static const uint32_t FL_COUNT = 64 - SL_BITS + 1;
+
+    struct Node
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t prevPhysical = INVALID_NODE;
+        uint32_t nextPhysical = INVALID_NODE;
+        uint32_t prevFree = INVALID_NODE;
+        uint32_t nextFree = INVALID_NODE;
+        bool used = false;
+    };
+
+    uint64_t capacity = 0;
+    uint64_t freeSize = 0;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> unusedNodes;
+
+    uint64_t flBitmap = 0;
+    uint32_t slBitmap[FL_COUNT] = {};
+    uint32_t freeHeads[FL_COUNT][SL_COUNT];
+
+    static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t findFreeBlock(uint64_t size) const;
+
+    uint32_t createNode(uint64_t offset, uint64_t size);
+    void releaseNode(uint32_t node);
+    void insertFree(uint32_t node);
+    void removeFree(uint32_t node);
+    uint32_t split(uint32_t node, uint64_t size);
+};
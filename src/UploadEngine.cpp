@@ -0,0 +1,701 @@
+#include "UploadEngine.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+void UploadEngine::create(VkDevice device, MemoryAllocator* allocator, GpuTimeline* gpuTimeline,
+                          VkQueue transferQueue, uint32_t transferFamily,
+                          VkQueue graphicsQueue, uint32_t graphicsFamily,
+                          VkDeviceSize stagingSize)
+{
+    this->device = device;
+    this->allocator = allocator;
+    this->gpuTimeline = gpuTimeline;
+    this->transferQueue = transferQueue;
+    this->transferFamily = transferFamily;
+    this->graphicsQueue = graphicsQueue;
+    this->graphicsFamily = graphicsFamily;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = transferFamily;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &transferPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create upload command pool!");
+    }
+
+    if (hasDedicatedTransferQueue())
+    {
+        poolInfo.queueFamilyIndex = graphicsFamily;
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &acquirePool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create upload acquire command pool!");
+        }
+    }
+
+    stagingRing.create(device, *allocator, stagingSize);
+
+    if (gpuTimeline->usesTimelineSemaphore() && hasDedicatedTransferQueue())
+    {
+        transferTimeline = createTimeline();
+    }
+}
+
+void UploadEngine::cleanup()
+{
+    if (device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Nothing recorded may be lost, submit it and wait for everything
+    flush();
+    vkQueueWaitIdle(transferQueue);
+    vkQueueWaitIdle(graphicsQueue);
+    collect();
+
+    stagingRing.cleanup(device, *allocator);
+
+    if (transferTimeline != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(device, transferTimeline, nullptr);
+        transferTimeline = VK_NULL_HANDLE;
+    }
+    if (acquirePool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(device, acquirePool, nullptr);
+        acquirePool = VK_NULL_HANDLE;
+    }
+    if (transferPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(device, transferPool, nullptr);
+        transferPool = VK_NULL_HANDLE;
+    }
+
+    device = VK_NULL_HANDLE;
+}
+
+void UploadEngine::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Avoid splitting into tiny copies when the ring is nearly full
+    const VkDeviceSize minChunk = 64 * 1024;
+    uploadedBytes += size;
+
+    const char* src = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        VkDeviceSize stagingOffset;
+        VkDeviceSize chunk = reserveStaging(size, std::min(size, minChunk), stagingOffset);
+        memcpy(stagingRing.getMapped() + stagingOffset, src, static_cast<size_t>(chunk));
+
+        beginBatch();
+        recordBufferCopy(stagingRing.getBuffer(), dstBuffer, chunk, stagingOffset, dstOffset);
+
+        src += chunk;
+        dstOffset += chunk;
+        size -= chunk;
+    }
+}
+
+void UploadEngine::uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t texelSize, const void* pixels, uint32_t mipLevels)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ImageBlock texel{ 1, 1, texelSize };
+    std::vector<const void*> levels(mipLevels);
+    const char* level = static_cast<const char*>(pixels);
+    for (uint32_t i = 0; i < mipLevels; ++i)
+    {
+        levels[i] = level;
+        level += getMipLevelSize(width, height, i, texel);
+    }
+
+    recordImageUpload(image, width, height, texel, levels.data(), mipLevels, mipLevels);
+}
+
+void UploadEngine::uploadImageGenerateMips(VkImage image, uint32_t width, uint32_t height, uint32_t texelSize, const void* pixels, uint32_t mipLevels)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    ImageBlock texel{ 1, 1, texelSize };
+    recordImageUpload(image, width, height, texel, &pixels, 1, mipLevels);
+    if (mipLevels > 1)
+    {
+        mipGenerations.push_back({ image, width, height, mipLevels });
+    }
+}
+
+void UploadEngine::uploadImageLevels(VkImage image, uint32_t width, uint32_t height, const ImageBlock& block, const std::vector<const void*>& levels)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    uint32_t levelCount = static_cast<uint32_t>(levels.size());
+    recordImageUpload(image, width, height, block, levels.data(), levelCount, levelCount);
+}
+
+// Copy the first dataLevels levels, every level is transitioned so the rest can be blitted
+void UploadEngine::recordImageUpload(VkImage image, uint32_t width, uint32_t height, const ImageBlock& block, const void* const* levels,
+                                     uint32_t dataLevels, uint32_t mipLevels)
+{
+    beginBatch();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(open.transferCommands,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    for (uint32_t level = 0; level < dataLevels; ++level)
+    {
+        uint32_t levelWidth = getMipExtent(width, level);
+        uint32_t levelHeight = getMipExtent(height, level);
+        uint32_t blockRows = (levelHeight + block.height - 1) / block.height;
+        const char* src = static_cast<const char*>(levels[level]);
+        uploadedBytes += getMipLevelSize(width, height, level, block);
+
+        // Copy in chunks of whole block rows, as many as the staging ring has room for
+        VkDeviceSize rowPitch = static_cast<VkDeviceSize>((levelWidth + block.width - 1) / block.width) * block.bytes;
+        uint32_t row = 0;
+        while (row < blockRows)
+        {
+            VkDeviceSize stagingOffset;
+            VkDeviceSize bytes = reserveStaging((blockRows - row) * rowPitch, rowPitch, stagingOffset);
+            uint32_t rows = static_cast<uint32_t>(bytes / rowPitch);
+            memcpy(stagingRing.getMapped() + stagingOffset, src + row * rowPitch, static_cast<size_t>(bytes));
+
+            beginBatch();
+
+            VkBufferImageCopy region{};
+            region.bufferOffset = stagingOffset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = level;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageOffset = { 0, static_cast<int32_t>(row * block.height), 0 };
+            region.imageExtent = { levelWidth, std::min(rows * block.height, levelHeight - row * block.height), 1 };
+
+            vkCmdCopyBufferToImage(open.transferCommands, stagingRing.getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+            row += rows;
+        }
+    }
+
+    // Transition for sampling at the end of the batch, on the graphics queue when ownership moves.
+    // Levels still to be generated stay writable, the blits transition them afterwards
+    bool generated = dataLevels < mipLevels;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = generated ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    if (hasDedicatedTransferQueue())
+    {
+        barrier.srcQueueFamilyIndex = transferFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+    }
+    else if (generated)
+    {
+        // Same queue, nothing to hand over
+        return;
+    }
+    imageReleases.push_back(barrier);
+}
+
+void UploadEngine::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    beginBatch();
+
+    VkBufferCopy region{};
+    region.srcOffset = srcOffset;
+    region.dstOffset = dstOffset;
+    region.size = size;
+
+    // Ranges moved between the same pair of buffers become one copy command
+    if (bufferMoves.empty() || bufferMoves.back().src != srcBuffer || bufferMoves.back().dst != dstBuffer)
+    {
+        bufferMoves.push_back({ srcBuffer, dstBuffer, {} });
+    }
+    bufferMoves.back().regions.push_back(region);
+}
+
+void UploadEngine::destroyAfterUpload(VkBuffer buffer, const Allocation& allocation)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    beginBatch();
+
+    open.garbage.emplace_back(buffer, allocation);
+}
+
+uint64_t UploadEngine::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (recording)
+    {
+        submitBatch();
+    }
+    collectCompleted();
+
+    return submittedValue;
+}
+
+bool UploadEngine::isComplete(uint64_t value)
+{
+    return gpuTimeline->isComplete(value);
+}
+
+void UploadEngine::wait(uint64_t value)
+{
+    gpuTimeline->wait(value);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    collectCompleted();
+}
+
+void UploadEngine::collect()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    collectCompleted();
+}
+
+uint64_t UploadEngine::getSubmittedValue() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return submittedValue;
+}
+
+uint64_t UploadEngine::getUploadedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return uploadedBytes;
+}
+
+void UploadEngine::beginBatch()
+{
+    if (recording)
+    {
+        return;
+    }
+
+    open = Batch{};
+    open.transferCommands = allocateCommandBuffer(transferPool);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(open.transferCommands, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin upload command buffer!");
+    }
+
+    // Order against earlier batches, an upload can continue in a new batch when the ring runs full
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(open.transferCommands,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    recording = true;
+}
+
+void UploadEngine::recordBufferCopy(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+{
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(open.transferCommands, srcBuffer, dstBuffer, 1, &copyRegion);
+
+    if (hasDedicatedTransferQueue())
+    {
+        // Hand the written range over to the graphics queue at the end of the batch
+        VkBufferMemoryBarrier release{};
+        release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.dstAccessMask = 0;
+        release.srcQueueFamilyIndex = transferFamily;
+        release.dstQueueFamilyIndex = graphicsFamily;
+        release.buffer = dstBuffer;
+        release.offset = dstOffset;
+        release.size = size;
+        bufferReleases.push_back(release);
+    }
+}
+
+// Reserve staging space for up to size bytes, in multiples of granularity.
+// When the ring is full the open batch is submitted and the oldest batch waited for.
+VkDeviceSize UploadEngine::reserveStaging(VkDeviceSize size, VkDeviceSize granularity, VkDeviceSize& offset)
+{
+    const VkDeviceSize alignment = 16;
+
+    if (granularity > stagingRing.getSize())
+    {
+        throw std::runtime_error("Upload does not fit in the staging ring!");
+    }
+
+    for (;;)
+    {
+        collectCompleted();
+
+        VkDeviceSize available = stagingRing.getLargestFree(alignment);
+        VkDeviceSize grant = size <= available ? size : available / granularity * granularity;
+        if (grant > 0 && stagingRing.allocate(grant, alignment, nextBatch, offset))
+        {
+            return grant;
+        }
+
+        // The rest of the ring is read by recorded or running batches
+        if (recording)
+        {
+            submitBatch();
+        }
+        waitOldestBatch();
+    }
+}
+
+void UploadEngine::waitOldestBatch()
+{
+    if (inFlight.empty())
+    {
+        return;
+    }
+
+    gpuTimeline->wait(inFlight.front().value);
+    collectCompleted();
+}
+
+void UploadEngine::recordBufferMoves(VkCommandBuffer commandBuffer)
+{
+    for (const BufferMove& move : bufferMoves)
+    {
+        vkCmdCopyBuffer(commandBuffer, move.src, move.dst, static_cast<uint32_t>(move.regions.size()), move.regions.data());
+    }
+    bufferMoves.clear();
+}
+
+// Blit every level from the one above, then make the whole chain readable by shaders.
+// Needs a graphics queue, runs after the copies and acquires of the batch
+void UploadEngine::recordMipGenerations(VkCommandBuffer commandBuffer)
+{
+    for (const MipGeneration& generation : mipGenerations)
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = generation.image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        for (uint32_t level = 1; level < generation.mipLevels; ++level)
+        {
+            // The level above was copied or blitted, read it as the source
+            barrier.subresourceRange.baseMipLevel = level - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            VkImageBlit blit{};
+            blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+            blit.srcOffsets[1] = { static_cast<int32_t>(getMipExtent(generation.width, level - 1)),
+                                   static_cast<int32_t>(getMipExtent(generation.height, level - 1)), 1 };
+            blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+            blit.dstOffsets[1] = { static_cast<int32_t>(getMipExtent(generation.width, level)),
+                                   static_cast<int32_t>(getMipExtent(generation.height, level)), 1 };
+
+            vkCmdBlitImage(commandBuffer,
+                generation.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                generation.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &blit, VK_FILTER_LINEAR);
+        }
+
+        // Every level but the last was a blit source
+        VkImageMemoryBarrier readBarriers[2] = { barrier, barrier };
+        readBarriers[0].subresourceRange.baseMipLevel = 0;
+        readBarriers[0].subresourceRange.levelCount = generation.mipLevels - 1;
+        readBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        readBarriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        readBarriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        readBarriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        readBarriers[1].subresourceRange.baseMipLevel = generation.mipLevels - 1;
+        readBarriers[1].subresourceRange.levelCount = 1;
+        readBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        readBarriers[1].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        readBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        readBarriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 0, nullptr, 0, nullptr, 2, readBarriers);
+    }
+    mipGenerations.clear();
+}
+
+void UploadEngine::submitBatch()
+{
+    open.sequence = nextBatch++;
+
+    if (!hasDedicatedTransferQueue())
+    {
+        if (!bufferMoves.empty())
+        {
+            // Moves may read what this batch has just uploaded
+            VkMemoryBarrier uploadBarrier{};
+            uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            uploadBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(open.transferCommands,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
+
+            recordBufferMoves(open.transferCommands);
+        }
+
+        // The transfer queue is the graphics queue here, blits are allowed
+        if (!mipGenerations.empty())
+        {
+            recordMipGenerations(open.transferCommands);
+        }
+
+        // Same queue as rendering, a single barrier makes the writes visible to everything after it
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+        vkCmdPipelineBarrier(open.transferCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 1, &memoryBarrier, 0, nullptr,
+            static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+    }
+    else
+    {
+        // Release ownership on the transfer queue
+        vkCmdPipelineBarrier(open.transferCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr,
+            static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+            static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+
+        // and acquire it on the graphics queue with matching barriers
+        open.acquireCommands = allocateCommandBuffer(acquirePool);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(open.acquireCommands, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to begin upload acquire command buffer!");
+        }
+
+        for (VkBufferMemoryBarrier& barrier : bufferReleases)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        }
+        for (VkImageMemoryBarrier& barrier : imageReleases)
+        {
+            // Images waiting for generated levels are written by the blits below
+            bool generated = barrier.newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = generated ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_MEMORY_READ_BIT;
+        }
+
+        vkCmdPipelineBarrier(open.acquireCommands,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0, 0, nullptr,
+            static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+            static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+
+        if (!mipGenerations.empty())
+        {
+            recordMipGenerations(open.acquireCommands);
+        }
+
+        if (!bufferMoves.empty())
+        {
+            // Buffers being moved are owned by graphics, so are the copies
+            recordBufferMoves(open.acquireCommands);
+
+            VkMemoryBarrier moveBarrier{};
+            moveBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            moveBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            moveBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            vkCmdPipelineBarrier(open.acquireCommands,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0, 1, &moveBarrier, 0, nullptr, 0, nullptr);
+        }
+
+        if (vkEndCommandBuffer(open.acquireCommands) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to record upload acquire command buffer!");
+        }
+    }
+    bufferReleases.clear();
+    imageReleases.clear();
+
+    if (vkEndCommandBuffer(open.transferCommands) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to record upload command buffer!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &open.transferCommands;
+
+    if (!hasDedicatedTransferQueue())
+    {
+        // Same queue as rendering, the batch takes its place on the frame timeline directly
+        open.value = gpuTimeline->submit(submitInfo);
+    }
+    else
+    {
+        // The transfer queue signals the acquire submission, which signals the frame timeline
+        VkTimelineSemaphoreSubmitInfo transferTimelineInfo{};
+        transferTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        transferTimelineInfo.signalSemaphoreValueCount = 1;
+        transferTimelineInfo.pSignalSemaphoreValues = &open.sequence;
+
+        VkSemaphore transferSignal = transferTimeline;
+        if (transferTimeline != VK_NULL_HANDLE)
+        {
+            submitInfo.pNext = &transferTimelineInfo;
+        }
+        else
+        {
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &open.transferDone) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create upload semaphore!");
+            }
+            transferSignal = open.transferDone;
+        }
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &transferSignal;
+
+        if (vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit upload batch!");
+        }
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo acquireInfo{};
+        acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireInfo.commandBufferCount = 1;
+        acquireInfo.pCommandBuffers = &open.acquireCommands;
+        acquireInfo.waitSemaphoreCount = 1;
+        acquireInfo.pWaitSemaphores = &transferSignal;
+        acquireInfo.pWaitDstStageMask = &waitStage;
+
+        open.value = gpuTimeline->submit(acquireInfo, transferTimeline != VK_NULL_HANDLE ? &open.sequence : nullptr);
+    }
+    submittedValue = open.value;
+
+    inFlight.push_back(std::move(open));
+    open = Batch{};
+    recording = false;
+}
+
+void UploadEngine::collectCompleted()
+{
+    // Batches complete in order, stop at the first one still running
+    uint64_t completedValue = gpuTimeline->getCompletedValue();
+    while (!inFlight.empty() && inFlight.front().value <= completedValue)
+    {
+        Batch& batch = inFlight.front();
+
+        completedBatch = batch.sequence;
+        retireBatch(batch);
+        inFlight.pop_front();
+    }
+
+    stagingRing.reclaim(completedBatch);
+}
+
+void UploadEngine::retireBatch(Batch& batch)
+{
+    for (auto& garbage : batch.garbage)
+    {
+        vkDestroyBuffer(device, garbage.first, nullptr);
+        allocator->free(garbage.second);
+    }
+
+    vkFreeCommandBuffers(device, transferPool, 1, &batch.transferCommands);
+    if (batch.acquireCommands != VK_NULL_HANDLE)
+    {
+        vkFreeCommandBuffers(device, acquirePool, 1, &batch.acquireCommands);
+    }
+    if (batch.transferDone != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(device, batch.transferDone, nullptr);
+    }
+}
+
+VkCommandBuffer UploadEngine::allocateCommandBuffer(VkCommandPool pool)
+{
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to allocate upload command buffer!");
+    }
+    return commandBuffer;
+}
+
+VkSemaphore UploadEngine::createTimeline()
+{
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create timeline semaphore!");
+    }
+    return semaphore;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+#include "MemoryAllocator.h"
+#include "StagingRing.h"
+#include "GpuTimeline.h"
+#include "MipChain.h"
+
+// Collects buffer and image uploads into one command buffer per batch and submits them together,
+// on a transfer only queue when the device has one.
+// When the transfer family differs from the graphics family, ownership of every destination is
+// released at the end of the batch and acquired by a small submission on the graphics queue.
+// The last graphics submission of a batch signals the next value of the frame timeline, so
+// anything submitted to the graphics queue after flush() sees the uploaded data.
+// Source data is copied into a persistent staging ring, uploads larger than the free space
+// are split into chunks and the ring is reclaimed as batches complete.
+// Generated mip levels are blitted on the graphics queue once the batch's copies are done.
+class UploadEngine
+{
+public:
+    void create(VkDevice device, MemoryAllocator* allocator, GpuTimeline* gpuTimeline,
+                VkQueue transferQueue, uint32_t transferFamily,
+                VkQueue graphicsQueue, uint32_t graphicsFamily,
+                VkDeviceSize stagingSize = DEFAULT_STAGING_BUFFER_SIZE);
+    void cleanup();
+
+    // Record into the open batch, data is copied to the staging ring before returning
+    void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+    // pixels holds mipLevels levels back to back, each half the size of the one before
+    void uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t texelSize, const void* pixels, uint32_t mipLevels = 1);
+
+    // Upload level 0 only and blit it down to the other levels. The format needs linear filtered
+    // blits and the image the transfer source usage
+    void uploadImageGenerateMips(VkImage image, uint32_t width, uint32_t height, uint32_t texelSize, const void* pixels, uint32_t mipLevels);
+
+    // Levels as stored in a texture file, e.g. block compressed. levels[i] points at level i
+    void uploadImageLevels(VkImage image, uint32_t width, uint32_t height, const ImageBlock& block, const std::vector<const void*>& levels);
+
+    // GPU side copy between buffers the graphics queue already uses, e.g. to move geometry.
+    // Runs after the uploads of the batch, on the graphics queue
+    void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+
+    // Destroy a buffer once the open batch has completed on the GPU
+    void destroyAfterUpload(VkBuffer buffer, const Allocation& allocation);
+
+    // Submit the open batch, returns the timeline value signaled when it completes
+    uint64_t flush();
+
+    bool isComplete(uint64_t value);
+    void wait(uint64_t value);
+
+    // Release the resources of completed batches
+    void collect();
+
+    uint64_t getSubmittedValue() const;
+
+    // Bytes copied through the staging ring since creation
+    uint64_t getUploadedBytes() const;
+    bool hasDedicatedTransferQueue() const { return transferFamily != graphicsFamily; }
+
+private:
+    struct Batch
+    {
+        uint64_t sequence = 0;      // batch number, tags the staging ring and the transfer timeline
+        uint64_t value = 0;         // frame timeline value, known once submitted
+        VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+        VkCommandBuffer acquireCommands = VK_NULL_HANDLE;
+        VkSemaphore transferDone = VK_NULL_HANDLE;     // fallback link between the two queues
+        std::vector<std::pair<VkBuffer, Allocation>> garbage;
+    };
+
+    struct MipGeneration
+    {
+        VkImage image = VK_NULL_HANDLE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+    };
+
+    struct BufferMove
+    {
+        VkBuffer src = VK_NULL_HANDLE;
+        VkBuffer dst = VK_NULL_HANDLE;
+        std::vector<VkBufferCopy> regions;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    GpuTimeline* gpuTimeline = nullptr;
+
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    VkQueue graphicsQueue = VK_NULL_HANDLE;
+    uint32_t transferFamily = 0;
+    uint32_t graphicsFamily = 0;
+
+    StagingRing stagingRing;
+
+    VkCommandPool transferPool = VK_NULL_HANDLE;
+    VkCommandPool acquirePool = VK_NULL_HANDLE;
+
+    // Links the transfer queue to the graphics queue, signaled with the batch sequence.
+    // Null without timeline semaphores or a dedicated transfer queue
+    VkSemaphore transferTimeline = VK_NULL_HANDLE;
+
+    Batch open;
+    bool recording = false;
+    std::vector<VkBufferMemoryBarrier> bufferReleases;
+    std::vector<VkImageMemoryBarrier> imageReleases;
+    std::vector<BufferMove> bufferMoves;
+    std::vector<MipGeneration> mipGenerations;
+
+    std::deque<Batch> inFlight;
+    uint64_t nextBatch = 1;
+    uint64_t completedBatch = 0;
+    uint64_t submittedValue = 0;    // frame timeline value of the last batch
+    uint64_t uploadedBytes = 0;
+
+    mutable std::mutex mutex;
+
+    void beginBatch();
+    void recordBufferCopy(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset);
+    VkDeviceSize reserveStaging(VkDeviceSize size, VkDeviceSize granularity, VkDeviceSize& offset);
+    void waitOldestBatch();
+    void recordImageUpload(VkImage image, uint32_t width, uint32_t height, const ImageBlock& block, const void* const* levels,
+                           uint32_t dataLevels, uint32_t mipLevels);
+    void recordBufferMoves(VkCommandBuffer commandBuffer);
+    void recordMipGenerations(VkCommandBuffer commandBuffer);
+    void submitBatch();
+    void collectCompleted();
+    void retireBatch(Batch& batch);
+    VkCommandBuffer allocateCommandBuffer(VkCommandPool pool);
+    VkSemaphore createTimeline();
+};
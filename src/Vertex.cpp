@@ -0,0 +1,104 @@
+#include "Vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // IEEE half float, rounded to nearest. Out of range values become infinity
+    uint16_t toHalf(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+        uint32_t biased = (bits >> 23) & 0xff;
+        uint32_t mantissa = bits & 0x7fffff;
+
+        if (biased == 0xff)
+        {
+            return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+        }
+
+        int32_t exponent = static_cast<int32_t>(biased) - 127 + 15;
+        if (exponent >= 31)
+        {
+            return sign | 0x7c00;
+        }
+        if (exponent <= 0)
+        {
+            // subnormal or zero
+            if (exponent < -10)
+            {
+                return sign;
+            }
+            mantissa |= 0x800000;
+            uint32_t shift = static_cast<uint32_t>(14 - exponent);
+            uint32_t half = mantissa >> shift;
+            half += (mantissa >> (shift - 1)) & 1;
+            return sign | static_cast<uint16_t>(half);
+        }
+
+        // a carry out of the mantissa rounds up into the exponent
+        uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+        half += (mantissa >> 12) & 1;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint16_t toUnorm16(float value)
+    {
+        return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+    }
+
+    // Scale per axis, then translate
+    glm::mat4 makeTransform(const glm::vec3& scale, const glm::vec3& offset)
+    {
+        glm::mat4 transform(1.0f);
+        transform[0][0] = scale.x;
+        transform[1][1] = scale.y;
+        transform[2][2] = scale.z;
+        transform[3] = glm::vec4(offset, 1.0f);
+        return transform;
+    }
+}
+
+VertexHalf VertexHalf::pack(const Vertex& vertex, const MeshBounds& bounds)
+{
+    glm::vec3 position = vertex.position - (bounds.min + bounds.max) * 0.5f;
+
+    VertexHalf packed;
+    packed.position[0] = toHalf(position.x);
+    packed.position[1] = toHalf(position.y);
+    packed.position[2] = toHalf(position.z);
+    packed.position[3] = toHalf(1.0f);
+    packed.texCoord[0] = toHalf(vertex.texCoord.x);
+    packed.texCoord[1] = toHalf(vertex.texCoord.y);
+    return packed;
+}
+
+glm::mat4 VertexHalf::getDequantization(const MeshBounds& bounds)
+{
+    return makeTransform(glm::vec3(1.0f), (bounds.min + bounds.max) * 0.5f);
+}
+
+VertexUnorm16 VertexUnorm16::pack(const Vertex& vertex, const MeshBounds& bounds)
+{
+    glm::vec3 extent = bounds.max - bounds.min;
+    glm::vec3 position = vertex.position - bounds.min;
+
+    // a flat axis stays 0, its scale in the dequantization is 0 as well
+    VertexUnorm16 packed;
+    packed.position[0] = extent.x > 0.0f ? toUnorm16(position.x / extent.x) : 0;
+    packed.position[1] = extent.y > 0.0f ? toUnorm16(position.y / extent.y) : 0;
+    packed.position[2] = extent.z > 0.0f ? toUnorm16(position.z / extent.z) : 0;
+    packed.position[3] = 0xffff;
+    packed.texCoord[0] = toHalf(vertex.texCoord.x);
+    packed.texCoord[1] = toHalf(vertex.texCoord.y);
+    return packed;
+}
+
+glm::mat4 VertexUnorm16::getDequantization(const MeshBounds& bounds)
+{
+    return makeTransform(bounds.max - bounds.min, bounds.min);
+}
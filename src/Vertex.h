@@ -1,42 +1,89 @@
-#pragma once
-#include <glm/glm.hpp>
-#include <vulkan/vulkan.h>
-#include <vector>
-
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 color;
-    glm::vec2 texCoord;
-
-    static std::vector<VkVertexInputBindingDescription> getBindingDescriptions() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex); // Size of a vertex (position + color)
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; // Each vertex has its own data
-        return { bindingDescription };
-    }
-
-    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
-
-        // Position attribute (location = 0)
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, position);
-
-        // Color attribute (location = 1)
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        //  Texture attribute
-        attributeDescriptions[2].binding = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
-
-        return attributeDescriptions;
-    }
-};
+#pragma once
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Axis aligned box and bounding sphere around a mesh's vertices, in model space.
+// The sphere is centered on the box
+struct MeshBounds
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+// Vertex as imported and cached, packed into GpuVertex when a mesh is uploaded
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 color;            // kept for the cache layout, no shader reads it
+    glm::vec2 texCoord;
+
+    static Vertex pack(const Vertex& vertex, const MeshBounds&) { return vertex; }
+    static glm::mat4 getDequantization(const MeshBounds&) { return glm::mat4(1.0f); }
+};
+
+// Half float position relative to the center of the mesh bounds and half float UVs, 12 bytes.
+// Keeps the full range, precision drops with the distance from the center
+struct VertexHalf
+{
+    uint16_t position[4];       // w unused, three component 16 bit formats are rarely supported
+    uint16_t texCoord[2];
+
+    static VertexHalf pack(const Vertex& vertex, const MeshBounds& bounds);
+    static glm::mat4 getDequantization(const MeshBounds& bounds);
+};
+
+// Position as 16 bit UNORM across the mesh bounds and half float UVs, 12 bytes.
+// Uniform precision of 1/65535 of the bounds
+struct VertexUnorm16
+{
+    uint16_t position[4];       // w unused
+    uint16_t texCoord[2];
+
+    static VertexUnorm16 pack(const Vertex& vertex, const MeshBounds& bounds);
+    static glm::mat4 getDequantization(const MeshBounds& bounds);
+};
+
+// Vertex input of a vertex type, one binding and an attribute per stream it has.
+// Shader locations: 0 position, 2 texture coordinate. Location 1 was the vertex color, which no
+// shader reads any more, so no layout declares it
+template <typename T>
+struct VertexLayout;
+
+template <>
+struct VertexLayout<Vertex>
+{
+    static constexpr VkVertexInputBindingDescription binding = { 0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX };
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> attributes = { {
+        { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) },
+        { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, texCoord) },
+    } };
+};
+
+template <>
+struct VertexLayout<VertexHalf>
+{
+    static constexpr VkVertexInputBindingDescription binding = { 0, sizeof(VertexHalf), VK_VERTEX_INPUT_RATE_VERTEX };
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> attributes = { {
+        { 0, 0, VK_FORMAT_R16G16B16A16_SFLOAT, offsetof(VertexHalf, position) },
+        { 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexHalf, texCoord) },
+    } };
+};
+
+template <>
+struct VertexLayout<VertexUnorm16>
+{
+    static constexpr VkVertexInputBindingDescription binding = { 0, sizeof(VertexUnorm16), VK_VERTEX_INPUT_RATE_VERTEX };
+    static constexpr std::array<VkVertexInputAttributeDescription, 2> attributes = { {
+        { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(VertexUnorm16, position) },
+        { 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexUnorm16, texCoord) },
+    } };
+};
+
+// Format of the vertices in the geometry arena, any type with a VertexLayout.
+// The model matrix of every draw is combined with the mesh's dequantization
+using GpuVertex = VertexUnorm16;
+
+static_assert(sizeof(VertexHalf) == 12 && sizeof(VertexUnorm16) == 12, "Packed vertices must not be padded");
@@ -1,22 +1,45 @@
-#define STB_IMAGE_IMPLEMENTATION
-
-#include "Engine.h"
-
-int main() 
-{
-    Engine engine;
-   
-    // Initialize the engine
-    if (engine.init() == EXIT_FAILURE)
-    {
-        return EXIT_FAILURE;
-    }
-   
-    // Run the main loop
-    engine.run();
-   
-    // Cleanup resources
-    engine.cleanup();
-
-    return 0;
-}
+#include <cstring>
+#include <cstdlib>
+
+#include "Engine.h"
+
+int main(int argc, char* argv[]) 
+{
+    // --headless [--frames N] renders offscreen without a window, e.g. on CI machines without a GPU
+    bool headless = false;
+    uint32_t frameCount = HEADLESS_FRAME_COUNT;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+
+    Engine engine;
+   
+    // Initialize the engine
+    if (engine.init(headless) == EXIT_FAILURE)
+    {
+        return EXIT_FAILURE;
+    }
+   
+    // Run the main loop
+    if (headless)
+    {
+        engine.runFrames(frameCount);
+    }
+    else
+    {
+        engine.run();
+    }
+   
+    // Cleanup resources
+    engine.cleanup();
+
+    return 0;
+}
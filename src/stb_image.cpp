@@ -0,0 +1,4 @@
+// The one translation unit with the stb_image implementation, shared by every executable
+#define STB_IMAGE_IMPLEMENTATION
+
+#include "stb_image.h"
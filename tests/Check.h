@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the unit tests, no test framework is vendored.
+// A failed check is printed and the test goes on, the executable fails when any check did
+inline int& getFailedChecks()
+{
+    static int failedChecks = 0;
+    return failedChecks;
+}
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            getFailedChecks()++; \
+        } \
+    } while (false)
+
+inline int finishTests()
+{
+    if (getFailedChecks() > 0)
+    {
+        std::printf("%d checks failed\n", getFailedChecks());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Check.h"
+#include "FrustumCuller.h"
+
+static MeshBounds makeBounds(const glm::vec3& center, const glm::vec3& halfSize)
+{
+    MeshBounds bounds;
+    bounds.min = center - halfSize;
+    bounds.max = center + halfSize;
+    bounds.radius = glm::length(halfSize);
+    return bounds;
+}
+
+// How far the bounds reach inside the frustum, worked out in double precision one plane at a time.
+// Negative when the sphere or the box is entirely behind a plane
+static double getReferenceMargin(const glm::vec4 planes[6], const MeshBounds& bounds, const glm::mat4& transform)
+{
+    double center[3];
+    double extent[3] = {};
+    double scale = 0.0;
+    for (int row = 0; row < 3; ++row)
+    {
+        center[row] = transform[3][row];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            center[row] += static_cast<double>(transform[axis][row]) * (bounds.min[axis] + bounds.max[axis]) * 0.5;
+            extent[row] += std::abs(static_cast<double>(transform[axis][row])) * (bounds.max[axis] - bounds.min[axis]) * 0.5;
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        double length = std::sqrt(static_cast<double>(transform[axis][0]) * transform[axis][0] +
+            static_cast<double>(transform[axis][1]) * transform[axis][1] + static_cast<double>(transform[axis][2]) * transform[axis][2]);
+        scale = std::max(scale, length);
+    }
+
+    double margin = INFINITY;
+    for (int p = 0; p < 6; ++p)
+    {
+        double distance = planes[p].w;
+        double boxReach = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            distance += static_cast<double>(planes[p][i]) * center[i];
+            boxReach += std::abs(static_cast<double>(planes[p][i])) * extent[i];
+        }
+        margin = std::min(margin, distance + std::min(bounds.radius * scale, boxReach));
+    }
+    return margin;
+}
+
+static void testKnownBounds()
+{
+    // Identity clip space, x and y from -1 to 1 and depth from 0 to 1
+    FrustumCuller culler;
+    culler.begin(glm::mat4(1.0f));
+    glm::mat4 identity(1.0f);
+    uint32_t inside = culler.add(makeBounds(glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.1f)), identity);
+    uint32_t left = culler.add(makeBounds(glm::vec3(-1.5f, 0.0f, 0.5f), glm::vec3(0.2f)), identity);
+    uint32_t straddling = culler.add(makeBounds(glm::vec3(-1.05f, 0.0f, 0.5f), glm::vec3(0.2f)), identity);
+    uint32_t behind = culler.add(makeBounds(glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(0.1f)), identity);
+    uint32_t beyond = culler.add(makeBounds(glm::vec3(0.0f, 0.0f, 1.5f), glm::vec3(0.2f)), identity);
+    uint32_t moved = culler.add(makeBounds(glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.1f)),
+        glm::translate(identity, glm::vec3(3.0f, 0.0f, 0.0f)));
+    culler.cull();
+
+    CHECK(culler.isVisible(inside));
+    CHECK(!culler.isVisible(left));
+    CHECK(culler.isVisible(straddling));
+    CHECK(!culler.isVisible(behind));
+    CHECK(!culler.isVisible(beyond));
+    CHECK(!culler.isVisible(moved));
+    CHECK(culler.getStats().tested == 6);
+    CHECK(culler.getStats().visible == 2);
+}
+
+static void testPlanes()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 100.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec4 planes[6];
+    FrustumCuller::getPlanes(projection * view, planes);
+
+    // Normalized, with the point the camera looks at inside and the camera itself behind the near plane
+    for (int p = 0; p < 6; ++p)
+    {
+        CHECK(std::abs(glm::length(glm::vec3(planes[p])) - 1.0f) < 1e-5f);
+        CHECK(glm::dot(planes[p], glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)) > 0.0f);
+    }
+    CHECK(glm::dot(planes[4], glm::vec4(0.0f, 0.0f, 5.0f, 1.0f)) < 0.0f);
+}
+
+// Whatever the SIMD path does has to agree with the plain per plane test
+static void testAgainstReference()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.5f, 200.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(10.0f, 5.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+    glm::vec4 planes[6];
+    FrustumCuller::getPlanes(viewProjection, planes);
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+    std::uniform_real_distribution<float> size(0.1f, 20.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+
+    // Not a multiple of the batch size, the padding lanes must not leak into the results
+    const uint32_t count = 4099;
+    std::vector<MeshBounds> bounds;
+    std::vector<glm::mat4> transforms;
+    FrustumCuller culler;
+    culler.begin(viewProjection);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bounds.push_back(makeBounds(glm::vec3(position(random), position(random), position(random)) * 0.05f,
+            glm::vec3(size(random), size(random), size(random))));
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+        transform = glm::rotate(transform, angle(random), glm::normalize(glm::vec3(size(random), size(random), size(random))));
+        transform = glm::scale(transform, glm::vec3(size(random) * 0.2f));
+        transforms.push_back(transform);
+        CHECK(culler.add(bounds.back(), transform) == i);
+    }
+    culler.cull();
+
+    uint32_t visible = 0;
+    uint32_t compared = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        visible += culler.isVisible(i) ? 1 : 0;
+
+        // Bounds touching a plane may go either way with float rounding
+        double margin = getReferenceMargin(planes, bounds[i], transforms[i]);
+        if (std::abs(margin) < 1e-3)
+        {
+            continue;
+        }
+        CHECK(culler.isVisible(i) == (margin >= 0.0));
+        compared++;
+    }
+    CHECK(culler.getStats().tested == count);
+    CHECK(culler.getStats().visible == visible);
+    CHECK(visible > 0 && visible < count);
+    CHECK(compared > count * 9 / 10);
+}
+
+int main()
+{
+    testKnownBounds();
+    testPlanes();
+    testAgainstReference();
+    return finishTests();
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "MeshOptimizer.h"
+
+// Grid of width by height quads, two triangles each, positions are the grid coordinates
+static DecodedMesh makeGrid(uint32_t width, uint32_t height)
+{
+    DecodedMesh mesh;
+    for (uint32_t y = 0; y <= height; ++y)
+    {
+        for (uint32_t x = 0; x <= width; ++x)
+        {
+            Vertex vertex = {};
+            vertex.position = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t corner = y * (width + 1) + x;
+            uint32_t quad[6] = { corner, corner + 1, corner + width + 1, corner + width + 1, corner + 1, corner + width + 2 };
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    return mesh;
+}
+
+// Triangles rotated to start at their smallest index and sorted, equal for the same set of triangles
+static std::vector<std::array<uint32_t, 3>> getTriangleSet(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<uint32_t, 3> triangle = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void testAnalyzeVertexCache()
+{
+    const uint32_t triangle[3] = { 0, 1, 2 };
+    VertexCacheStats stats = analyzeVertexCache(triangle, 3, 3);
+    CHECK(stats.acmr == 3.0f);
+    CHECK(stats.atvr == 1.0f);
+
+    // The shared edge is still in the cache
+    const uint32_t quad[6] = { 0, 1, 2, 2, 1, 3 };
+    stats = analyzeVertexCache(quad, 6, 4);
+    CHECK(stats.acmr == 2.0f);
+    CHECK(stats.atvr == 1.0f);
+
+    // The second triangle pushes the first one out of a cache of three
+    const uint32_t evicted[9] = { 0, 1, 2, 3, 4, 5, 0, 1, 2 };
+    stats = analyzeVertexCache(evicted, 9, 6, 3);
+    CHECK(stats.acmr == 3.0f);
+    CHECK(stats.atvr == 1.5f);
+    stats = analyzeVertexCache(evicted, 9, 6, 6);
+    CHECK(stats.acmr == 2.0f);
+    CHECK(stats.atvr == 1.0f);
+
+    CHECK(analyzeVertexCache(triangle, 0, 3).acmr == 0.0f);
+}
+
+static void testOptimizeVertexCache()
+{
+    DecodedMesh grid = makeGrid(32, 32);
+    uint32_t vertexCount = static_cast<uint32_t>(grid.vertices.size());
+
+    // Triangles in random order, the worst case for the cache
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < grid.indices.size(); i += 3)
+    {
+        triangles.push_back({ grid.indices[i], grid.indices[i + 1], grid.indices[i + 2] });
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(5));
+    std::vector<uint32_t> indices;
+    for (const std::array<uint32_t, 3>& triangle : triangles)
+    {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+
+    float before = analyzeVertexCache(indices.data(), indices.size(), vertexCount).acmr;
+    std::vector<uint32_t> optimized = indices;
+    std::vector<uint32_t> clusters;
+    optimizeVertexCache(optimized, vertexCount, &clusters);
+    float after = analyzeVertexCache(optimized.data(), optimized.size(), vertexCount).acmr;
+
+    CHECK(getTriangleSet(optimized) == getTriangleSet(indices));
+    CHECK(after < before);
+    CHECK(after < 1.0f);
+    CHECK(!clusters.empty() && clusters[0] == 0);
+    CHECK(std::is_sorted(clusters.begin(), clusters.end()));
+}
+
+static void testSplitMeshes()
+{
+    DecodedMesh grid = makeGrid(40, 40);
+    grid.materialIndex = 3;
+    grid.node = 2;
+    DecodedMesh small = makeGrid(2, 2);
+
+    std::vector<DecodedMesh> meshes = { grid, small };
+    const uint32_t maxVertices = 300;
+    splitMeshes(meshes, maxVertices);
+    CHECK(meshes.size() > 2);
+
+    // Pieces keep the triangle order, read back through their own vertices they are the original triangles
+    std::vector<glm::vec3> original;
+    for (uint32_t index : grid.indices)
+    {
+        original.push_back(grid.vertices[index].position);
+    }
+    std::vector<glm::vec3> pieces;
+    for (size_t i = 0; i + 1 < meshes.size(); ++i)
+    {
+        const DecodedMesh& piece = meshes[i];
+        CHECK(piece.vertices.size() <= maxVertices);
+        CHECK(piece.materialIndex == grid.materialIndex);
+        CHECK(piece.node == grid.node);
+        CHECK(piece.indices.size() % 3 == 0);
+        for (uint32_t index : piece.indices)
+        {
+            CHECK(index < piece.vertices.size());
+            pieces.push_back(piece.vertices[index].position);
+        }
+    }
+    CHECK(pieces == original);
+
+    // Meshes under the limit are left as they are
+    const DecodedMesh& last = meshes.back();
+    CHECK(last.vertices.size() == small.vertices.size());
+    CHECK(last.indices == small.indices);
+}
+
+int main()
+{
+    testAnalyzeVertexCache();
+    testOptimizeVertexCache();
+    testSplitMeshes();
+    return finishTests();
+}
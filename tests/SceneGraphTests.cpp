@@ -0,0 +1,144 @@
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Check.h"
+#include "JobSystem.h"
+#include "SceneGraph.h"
+
+static glm::mat4 translation(float x, float y, float z)
+{
+    return glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
+}
+
+static bool isAt(const glm::mat4& transform, float x, float y, float z)
+{
+    return transform[3][0] == x && transform[3][1] == y && transform[3][2] == z;
+}
+
+static void testWorldTransforms()
+{
+    SceneGraph graph;
+    uint32_t root = graph.createNode(SceneGraph::INVALID_NODE, translation(1.0f, 0.0f, 0.0f));
+    uint32_t child = graph.createNode(root, translation(0.0f, 2.0f, 0.0f));
+    uint32_t grandchild = graph.createNode(child, translation(0.0f, 0.0f, 3.0f));
+    uint32_t other = graph.createNode(SceneGraph::INVALID_NODE, translation(5.0f, 0.0f, 0.0f));
+
+    CHECK(graph.update() == 4);
+    CHECK(isAt(graph.getWorldTransform(root), 1.0f, 0.0f, 0.0f));
+    CHECK(isAt(graph.getWorldTransform(child), 1.0f, 2.0f, 0.0f));
+    CHECK(isAt(graph.getWorldTransform(grandchild), 1.0f, 2.0f, 3.0f));
+    CHECK(isAt(graph.getWorldTransform(other), 5.0f, 0.0f, 0.0f));
+
+    // Children added later keep the subtree contiguous, the handles of everything else stay valid
+    uint32_t late = graph.createNode(root, translation(0.0f, 0.0f, 1.0f));
+    CHECK(graph.update() == 1);
+    CHECK(isAt(graph.getWorldTransform(late), 1.0f, 0.0f, 1.0f));
+    CHECK(isAt(graph.getWorldTransform(grandchild), 1.0f, 2.0f, 3.0f));
+    CHECK(isAt(graph.getWorldTransform(other), 5.0f, 0.0f, 0.0f));
+}
+
+static void testDirtyPropagation()
+{
+    SceneGraph graph;
+    uint32_t root = graph.createNode();
+    uint32_t child = graph.createNode(root);
+    uint32_t grandchild = graph.createNode(child);
+    uint32_t sibling = graph.createNode(root);
+    graph.update();
+    CHECK(graph.update() == 0);
+
+    // Only the subtree below the changed node is recomputed
+    graph.setLocalTransform(child, translation(0.0f, 1.0f, 0.0f));
+    CHECK(graph.update() == 2);
+    CHECK(isAt(graph.getWorldTransform(grandchild), 0.0f, 1.0f, 0.0f));
+    CHECK(isAt(graph.getWorldTransform(sibling), 0.0f, 0.0f, 0.0f));
+
+    // A dirty node inside a dirty subtree is covered by it, in either order
+    graph.setLocalTransform(grandchild, translation(0.0f, 0.0f, 1.0f));
+    graph.setLocalTransform(root, translation(1.0f, 0.0f, 0.0f));
+    CHECK(graph.update() == 4);
+    CHECK(isAt(graph.getWorldTransform(grandchild), 1.0f, 1.0f, 1.0f));
+    CHECK(isAt(graph.getWorldTransform(sibling), 1.0f, 0.0f, 0.0f));
+
+    // Setting the same node twice marks it once
+    graph.setLocalTransform(sibling, translation(0.0f, 0.0f, 2.0f));
+    graph.setLocalTransform(sibling, translation(0.0f, 0.0f, 3.0f));
+    CHECK(graph.update() == 1);
+    CHECK(isAt(graph.getWorldTransform(sibling), 1.0f, 0.0f, 3.0f));
+}
+
+static void testDestroy()
+{
+    SceneGraph graph;
+    uint32_t root = graph.createNode(SceneGraph::INVALID_NODE, translation(1.0f, 0.0f, 0.0f));
+    uint32_t child = graph.createNode(root);
+    uint32_t grandchild = graph.createNode(child);
+    uint32_t sibling = graph.createNode(root, translation(0.0f, 1.0f, 0.0f));
+    graph.update();
+
+    // Dirty nodes of a destroyed subtree are skipped
+    graph.setLocalTransform(grandchild, translation(0.0f, 0.0f, 1.0f));
+    graph.destroyNode(child);
+    CHECK(!graph.isValid(child));
+    CHECK(!graph.isValid(grandchild));
+    CHECK(graph.isValid(sibling));
+    CHECK(graph.getNodeCount() == 2);
+    CHECK(graph.update() == 0);
+
+    graph.setLocalTransform(root, translation(2.0f, 0.0f, 0.0f));
+    CHECK(graph.update() == 2);
+    CHECK(isAt(graph.getWorldTransform(sibling), 2.0f, 1.0f, 0.0f));
+
+    // Freed handles are reused
+    uint32_t reused = graph.createNode(sibling);
+    CHECK(reused == child || reused == grandchild);
+    CHECK(graph.update() == 1);
+    CHECK(isAt(graph.getWorldTransform(reused), 2.0f, 1.0f, 0.0f));
+}
+
+// Large updates are split into jobs, they have to match the update on one thread
+static void testJobs()
+{
+    SceneGraph serial;
+    SceneGraph parallel;
+    std::vector<uint32_t> nodes;
+    for (uint32_t i = 0; i < SCENE_UPDATE_BATCH_SIZE * 3; ++i)
+    {
+        uint32_t parent = i % 64 == 0 ? SceneGraph::INVALID_NODE : nodes[i / 2];
+        glm::mat4 local = translation(static_cast<float>(i % 7), static_cast<float>(i % 5), 1.0f);
+        nodes.push_back(serial.createNode(parent, local));
+        CHECK(parallel.createNode(parent, local) == nodes.back());
+    }
+
+    JobSystem jobSystem;
+    jobSystem.create(3);
+    auto compare = [&]()
+    {
+        CHECK(serial.update() == parallel.update(&jobSystem));
+        for (uint32_t node : nodes)
+        {
+            CHECK(serial.getWorldTransform(node) == parallel.getWorldTransform(node));
+        }
+    };
+    compare();
+
+    // Every fourth node dirty, many small ranges instead of a few large ones
+    for (size_t i = 0; i < nodes.size(); i += 4)
+    {
+        glm::mat4 local = translation(0.0f, static_cast<float>(i % 3), 2.0f);
+        serial.setLocalTransform(nodes[i], local);
+        parallel.setLocalTransform(nodes[i], local);
+    }
+    compare();
+    jobSystem.cleanup();
+}
+
+int main()
+{
+    testWorldTransforms();
+    testDirtyPropagation();
+    testDestroy();
+    testJobs();
+    return finishTests();
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Check.h"
+#include "TlsfAllocator.h"
+
+static void testAllocate()
+{
+    TlsfAllocator allocator;
+    allocator.init(1024);
+    CHECK(allocator.isEmpty());
+    CHECK(allocator.getLargestFreeSize() == 1024);
+
+    uint64_t offset = 1;
+    uint32_t node = allocator.allocate(100, 1, offset);
+    CHECK(node != TlsfAllocator::INVALID_NODE);
+    CHECK(offset == 0);
+    CHECK(allocator.getFreeSize() == 924);
+
+    // The padding in front of an aligned allocation stays free
+    uint32_t aligned = allocator.allocate(10, 256, offset);
+    CHECK(aligned != TlsfAllocator::INVALID_NODE);
+    CHECK(offset % 256 == 0);
+    CHECK(allocator.getFreeSize() == 914);
+
+    CHECK(allocator.allocate(0, 1, offset) == TlsfAllocator::INVALID_NODE);
+    CHECK(allocator.allocate(2048, 1, offset) == TlsfAllocator::INVALID_NODE);
+
+    allocator.free(node);
+    allocator.free(aligned);
+    CHECK(allocator.isEmpty());
+}
+
+static void testCoalesce()
+{
+    TlsfAllocator allocator;
+    allocator.init(4096);
+
+    uint32_t blocks[4];
+    uint64_t offsets[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        blocks[i] = allocator.allocate(1024, 1, offsets[i]);
+        CHECK(blocks[i] != TlsfAllocator::INVALID_NODE);
+    }
+    CHECK(allocator.getFreeSize() == 0);
+    CHECK(allocator.getLargestFreeSize() == 0);
+
+    uint64_t offset = 0;
+    CHECK(allocator.allocate(1, 1, offset) == TlsfAllocator::INVALID_NODE);
+
+    // Free neighbours merge into one block that takes an allocation of their combined size
+    allocator.free(blocks[1]);
+    allocator.free(blocks[2]);
+    CHECK(allocator.getFreeSize() == 2048);
+    CHECK(allocator.getLargestFreeSize() == 2048);
+    blocks[1] = allocator.allocate(2048, 1, offset);
+    CHECK(blocks[1] != TlsfAllocator::INVALID_NODE);
+    CHECK(offset == std::min(offsets[1], offsets[2]));
+
+    // A block freed between two free ones merges with both
+    allocator.free(blocks[0]);
+    allocator.free(blocks[3]);
+    CHECK(allocator.getLargestFreeSize() == 1024);
+    allocator.free(blocks[1]);
+    CHECK(allocator.isEmpty());
+    CHECK(allocator.getLargestFreeSize() == 4096);
+
+    CHECK(allocator.allocate(4096, 1, offset) != TlsfAllocator::INVALID_NODE);
+    CHECK(offset == 0);
+
+    allocator.reset();
+    CHECK(allocator.isEmpty());
+    CHECK(allocator.getLargestFreeSize() == 4096);
+}
+
+static void testRandom()
+{
+    struct Block
+    {
+        uint32_t node;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const uint64_t capacity = 1 << 20;
+    TlsfAllocator allocator;
+    allocator.init(capacity);
+
+    std::mt19937 random(7);
+    std::vector<Block> blocks;
+    uint64_t usedSize = 0;
+    for (int i = 0; i < 10000; ++i)
+    {
+        if (blocks.empty() || random() % 3 != 0)
+        {
+            Block block;
+            block.size = 1 + random() % 4096;
+            uint64_t alignment = 1ull << (random() % 9);
+            block.node = allocator.allocate(block.size, alignment, block.offset);
+            if (block.node == TlsfAllocator::INVALID_NODE)
+            {
+                continue;
+            }
+            CHECK(block.offset % alignment == 0);
+            CHECK(block.offset + block.size <= capacity);
+            blocks.push_back(block);
+            usedSize += block.size;
+        }
+        else
+        {
+            size_t index = random() % blocks.size();
+            allocator.free(blocks[index].node);
+            usedSize -= blocks[index].size;
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+        }
+        CHECK(allocator.getFreeSize() == capacity - usedSize);
+    }
+
+    // No two live allocations overlap
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.offset < b.offset; });
+    for (size_t i = 1; i < blocks.size(); ++i)
+    {
+        CHECK(blocks[i - 1].offset + blocks[i - 1].size <= blocks[i].offset);
+    }
+
+    for (const Block& block : blocks)
+    {
+        allocator.free(block.node);
+    }
+    CHECK(allocator.isEmpty());
+    CHECK(allocator.getLargestFreeSize() == capacity);
+}
+
+int main()
+{
+    testAllocate();
+    testCoalesce();
+    testRandom();
+    return finishTests();
+}